@@ -166,7 +166,7 @@ void DDR3Bank::SetConfig( Config *config, bool createChildren )
 
 void DDR3Bank::RegisterStats( )
 {
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         AddUnitStat(bankEnergy, "mA*t");
         AddUnitStat(activeEnergy, "mA*t");
@@ -940,7 +940,7 @@ void DDR3Bank::CalculatePower( )
         return;
     }
 
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         bankPower = ( bankEnergy * p->Voltage ) / (double)simulationTime / 1000.0f; 
         activePower = ( activeEnergy * p->Voltage ) / (double)simulationTime / 1000.0f; 
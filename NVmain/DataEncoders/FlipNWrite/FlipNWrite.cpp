@@ -32,6 +32,7 @@
 *******************************************************************************/
 
 #include "DataEncoders/FlipNWrite/FlipNWrite.h"
+#include "include/NVMBitOps.h"
 
 #include <iostream>
 
@@ -77,42 +78,16 @@ void FlipNWrite::RegisterStats( )
 
 void FlipNWrite::InvertData( NVMDataBlock& data, uint64_t startBit, uint64_t endBit )
 {
-    uint64_t wordSize;
-    int startByte, endByte;
-
-    wordSize = p->BusWidth;
-    wordSize *= p->tBURST * p->RATE;
-    wordSize /= 8;
+    if( data.rawData == NULL )
+        return;
 
-    startByte = (int)(startBit / 8);
-    endByte = (int)((endBit - 1) / 8);
+    /* Partitions past the end of the data block have nothing to invert. */
+    uint64_t dataBits = data.GetSize( ) * 8;
 
-    for( int i = startByte; i <= endByte; i++ )
-    {
-        uint8_t originalByte = data.GetByte( i );
-        uint8_t shiftByte = originalByte;
-        uint8_t newByte = 0;
-
-        for( int j = 0; j < 8; j++ )
-        {
-            uint64_t currentBit = i * 8 + j;
-           
-            if( currentBit < startBit || currentBit >= endBit )
-            {
-                shiftByte = static_cast<uint8_t>(shiftByte >> 1);
-                continue;
-            }
+    if( endBit > dataBits )
+        endBit = dataBits;
 
-            if( !(shiftByte & 0x1) )
-            {
-                newByte = static_cast<uint8_t>(newByte | (1 << (7-j)));
-            }
-
-            shiftByte = static_cast<uint8_t>(shiftByte >> 1);
-        }
-
-        data.SetByte( i, newByte );
-    }
+    InvertBits( data.rawData, startBit, endBit );
 }
 
 ncycle_t FlipNWrite::Read( NVMainRequest* /*request*/ )
@@ -149,10 +124,8 @@ ncycle_t FlipNWrite::Write( NVMainRequest *request )
      */
     uint64_t rowSize;
     uint64_t wordSize;
-    uint64_t currentBit;
     uint64_t flipPartitions;
     uint64_t rowPartitions;
-    int *modifyCount;
 
     wordSize = p->BusWidth;
     wordSize *= p->tBURST * p->RATE;
@@ -163,17 +136,6 @@ ncycle_t FlipNWrite::Write( NVMainRequest *request )
     
     flipPartitions = ( wordSize * 8 ) / fpSize; 
 
-    modifyCount = new int[ flipPartitions ];
-
-    /*
-     *  Count the number of bits that are modified. If it is more than
-     *  half, then we will invert the data then write.
-     */
-    for( uint64_t i = 0; i < flipPartitions; i++ )
-        modifyCount[i] = 0;
-
-    currentBit = 0;
-
     /* Get what is currently in the memory (i.e., if it was previously flipped, get the flipped data. */
     for( uint64_t i = 0; i < flipPartitions; i++ )
     {
@@ -185,43 +147,17 @@ ncycle_t FlipNWrite::Write( NVMainRequest *request )
         }
     }
 
-    /* Check each byte to see if it was modified */
-    for( uint64_t i = 0; i < wordSize; ++i )
-    {
-        /*
-         *  If no bytes have changed we can just continue. Yes, I know this
-         *  will check the byte 8 times, but i'd rather not change the iter.
-         */
-        uint8_t oldByte, newByte;
-
-        oldByte = oldData.GetByte( i );
-        newByte = newData.GetByte( i );
-
-        if( oldByte == newByte )
-        {
-            currentBit += 8;
-            continue;
-        }
-
-        /*
-         *  If the bytes are different, then at least one bit has changed.
-         *  check each bit individually.
-         */
-        for( int j = 0; j < 8; j++ )
-        {
-            uint8_t oldBit, newBit;
+    /*
+     *  Count the number of bits that are modified in each partition. If it 
+     *  is more than half, then we will invert the data then write.
+     */
+    compareScratch.resize( 2 * wordSize );
+    modifyCount.resize( flipPartitions );
 
-            oldBit = ( oldByte >> j ) & 0x1;
-            newBit = ( newByte >> j ) & 0x1;
+    const uint8_t *newBytes = newData.GetBytes( wordSize, compareScratch.data( ) );
+    const uint8_t *oldBytes = oldData.GetBytes( wordSize, compareScratch.data( ) + wordSize );
 
-            if( oldBit != newBit )
-            {
-                modifyCount[(int)(currentBit/fpSize)]++;
-            }
-
-            currentBit++;
-        }
-    }
+    CountDiffBitsByPartition( newBytes, oldBytes, wordSize, fpSize, modifyCount.data( ) );
 
     /*
      *  Flip any partitions as needed and mark them as inverted or not.
@@ -233,7 +169,7 @@ ncycle_t FlipNWrite::Write( NVMainRequest *request )
         uint64_t curAddr = row * rowPartitions + col * flipPartitions + i;
 
         /* Invert if more than half of the bits are modified. */
-        if( modifyCount[i] > (fpSize / 2) )
+        if( modifyCount[i] > static_cast<uint64_t>(fpSize / 2) )
         {
             InvertData( newData, i*fpSize, (i+1)*fpSize );
 
@@ -262,8 +198,6 @@ ncycle_t FlipNWrite::Write( NVMainRequest *request )
         }
     }
 
-    delete modifyCount;
-    
     return rv;
 }
 
@@ -36,6 +36,7 @@
 
 #include "src/DataEncoder.h"
 #include <set>
+#include <vector>
 
 namespace NVM {
 
@@ -61,6 +62,9 @@ class FlipNWrite : public DataEncoder
     double flipNWriteReduction;
     int fpSize;
 
+    std::vector<uint64_t> modifyCount;
+    std::vector<uint8_t> compareScratch;
+
     void InvertData( NVMDataBlock &data, uint64_t startBit, uint64_t endBit );
 };
 
@@ -58,8 +58,10 @@ Migrator::~Migrator( )
 }
 
 
-void Migrator::SetConfig( Config *config, bool /*createChildren*/ )
+void Migrator::SetConfig( Config *config, bool createChildren )
 {
+    AddressTranslator::SetConfig( config, createChildren );
+
     /* 
      *  Each memory page will be given a one-dimensional key, so we need the
      *  size of the other dimensions to calculate this. Using GetValue is 
@@ -32,6 +32,7 @@
 *******************************************************************************/
 
 #include "Endurance/BitModel/BitModel.h"
+#include "include/NVMBitOps.h"
 #include <iostream>
 
 using namespace NVM;
@@ -118,7 +119,7 @@ ncycles_t BitModel::Write( NVMainRequest *request, NVMDataBlock& oldData )
     NVMAddress& address = request->address;
 
     /*
-     *  The default life map is an stl map< uint64_t, uint64_t >. 
+     *  The default life map is an EnduranceLifeMap keyed by uint64_t.
      *  You may map row and col to this map_key however you want.
      *  It is up to you to ensure there are no collisions here.
      */
@@ -145,52 +146,34 @@ ncycles_t BitModel::Write( NVMainRequest *request, NVMDataBlock& oldData )
 
     rowSize = p->COLS * wordSize; 
 
-    /* Check each byte to see if it was modified */
-    for( uint64_t i = 0; i < wordSize; ++i )
-    {
-        /*
-         *  If no bytes have changed we can just continue. Yes, I know this
-         *  will check the byte 8 times, but i'd rather not change the iter.
-         */
-        uint8_t oldByte, newByte;
-
-        oldByte = oldData.GetByte( i );
-        newByte = newData.GetByte( i );
-
-        if( oldByte == newByte ) 
-            continue;
-
-        /*
-         *  If the bytes are different, then at least one bit has changed.
-         *  check each bit individually.
-         */
-        for( int j = 0; j < 8; j++ )
-        {
-            uint8_t oldBit, newBit;
-
-            oldBit = ( oldByte >> j ) & 0x1;
-            newBit = ( newByte >> j ) & 0x1;
+    /*
+     *  Think of each row being partitioned into 1-bit divisions. 
+     *  Each row has rowSize * 8 paritions. For the key we will use:
+     *
+     *  row * number of partitions + partition in this row
+     */
+    partitionCount = rowSize * 8;
+    wordkey = row * partitionCount + (col * wordSize * 8);
 
-            if( oldBit == newBit )
-                continue;
+    compareScratch.resize( 2 * wordSize );
 
-            //std::cout << "Bit " << j << " changed in byte " << i << std::endl;
+    const uint8_t *newBytes = newData.GetBytes( wordSize, compareScratch.data( ) );
+    const uint8_t *oldBytes = oldData.GetBytes( wordSize, compareScratch.data( ) + wordSize );
 
-            /*
-             *  Think of each row being partitioned into 1-bit divisions. 
-             *  Each row has rowSize * 8 paritions. For the key we will use:
-             *
-             *  row * number of partitions + partition in this row
-             */
-            partitionCount = rowSize * 8;
-            
-            wordkey = row * partitionCount 
-                             + (col * wordSize * 8) + i * 8 + j;
+    /* Visit the modified bits 64 at a time, lowest bit first. */
+    for( uint64_t i = 0; i < wordSize; i += 8 )
+    {
+        uint64_t changed = LoadBits64( newBytes, i, wordSize ) 
+                         ^ LoadBits64( oldBytes, i, wordSize );
 
-            //std::cout << "Key is " << wordkey << std::endl;
+        while( changed )
+        {
+            uint64_t bit = static_cast<uint64_t>( __builtin_ctzll( changed ) );
 
-            if( !DecrementLife( wordkey ) )
+            if( !DecrementLife( wordkey + i * 8 + bit ) )
                 rv = -1;
+
+            changed &= changed - 1;
         }
     }
 
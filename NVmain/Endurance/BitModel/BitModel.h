@@ -36,6 +36,8 @@
 
 #include "src/EnduranceModel.h"
 
+#include <vector>
+
 namespace NVM {
 
 class BitModel : public EnduranceModel
@@ -48,6 +50,9 @@ class BitModel : public EnduranceModel
 
     ncycles_t Read( NVMainRequest *request );
     ncycles_t Write( NVMainRequest *request, NVMDataBlock& oldData );
+
+  private:
+    std::vector<uint8_t> compareScratch;
 };
 
 };
@@ -32,6 +32,7 @@
 *******************************************************************************/
 
 #include "Endurance/ByteModel/ByteModel.h"
+#include "include/NVMBitOps.h"
 #include <iostream>
 
 using namespace NVM;
@@ -118,7 +119,7 @@ ncycles_t ByteModel::Write( NVMainRequest *request, NVMDataBlock& oldData )
     NVMAddress address = request->address;
 
     /*
-     *  The default life map is an stl map< uint64_t, uint64_t >. 
+     *  The default life map is an EnduranceLifeMap keyed by uint64_t.
      *  You may map row and col to this map_key however you want.
      *  It is up to you to ensure there are no collisions here.
      */
@@ -153,29 +154,39 @@ ncycles_t ByteModel::Write( NVMainRequest *request, NVMDataBlock& oldData )
     /* Size of a row in bytes */
     rowSize = p->COLS * wordSize;
 
-    /* Check each byte to see if it was modified */
-    for( int i = (int)wordSize - 1; i >= 0; --i )
+    /*
+     *  Think of each row being partitioned into 8-bit divisions. Each 
+     *  row has rowSize / 8 paritions. For the key we will use:
+     *
+     *  row * number of partitions + partition in this row
+     */
+    partitionCount = ( rowSize / 8 );
+    wordkey = row * partitionCount + col * wordSize;
+
+    compareScratch.resize( 2 * wordSize );
+
+    const uint8_t *newBytes = newData.GetBytes( wordSize, compareScratch.data( ) );
+    const uint8_t *oldBytes = oldData.GetBytes( wordSize, compareScratch.data( ) + wordSize );
+
+    /* Check each byte to see if it was modified, skipping unchanged 64-bit words. */
+    for( uint64_t offset = ((wordSize + 7) / 8) * 8; offset > 0; )
     {
-        uint8_t oldByte, newByte;
+        offset -= 8;
 
-        oldByte = oldData.GetByte( i );
-        newByte = newData.GetByte( i );
+        uint64_t changed = LoadBits64( newBytes, offset, wordSize ) 
+                         ^ LoadBits64( oldBytes, offset, wordSize );
 
-        if( oldByte == newByte ) 
+        if( changed == 0 )
             continue;
 
-        /*
-         *  Think of each row being partitioned into 8-bit divisions. Each 
-         *  row has rowSize / 8 paritions. For the key we will use:
-         *
-         *  row * number of partitions + partition in this row
-         */
-        partitionCount = ( rowSize / 8 );
+        for( int j = 7; j >= 0; --j )
+        {
+            if( ((changed >> (j * 8)) & 0xFF) == 0 )
+                continue;
 
-        wordkey = row * partitionCount + col * wordSize + i;
-      
-        if( !DecrementLife( wordkey ) )
-            rv = -1;  
+            if( !DecrementLife( wordkey + offset + j ) )
+                rv = -1;  
+        }
     }
 
     return rv;
@@ -88,7 +88,7 @@ ncycles_t RowModel::Write( NVMainRequest *request, NVMDataBlock& /*oldData*/ )
     NVMAddress address = request->address;
 
     /*
-     *  The default life map is an stl map< uint64_t, uint64_t >. 
+     *  The default life map is an EnduranceLifeMap keyed by uint64_t.
      *  You may map row and col to this map_key however you want.
      *  It is up to you to ensure there are no collisions here.
      */
@@ -131,7 +131,7 @@ void DRAMCache::SetConfig( Config *conf, bool createChildren )
             
             /* When selecting a child, use the channel field from a DRC decoder. */
             DRCDecoder *drcDecoder = new DRCDecoder( );
-            drcDecoder->SetConfig( config, createChildren );
+            drcDecoder->SetConfig( conf, createChildren );
             drcDecoder->SetTranslationMethod( drcMethod );
             drcDecoder->SetDefaultField( CHANNEL_FIELD );
             /* Set ignore bits for DRC decoder*/
@@ -235,7 +235,7 @@ bool DRAMCache::RequestComplete( NVMainRequest *req )
 {
     bool rv = false;
 
-    if( req->type == REFRESH )
+    if( req->type == REFRESH && req->owner != this )
         ProcessRefreshPulse( req );
     else if( req->owner == this )
     {
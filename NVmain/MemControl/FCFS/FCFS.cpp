@@ -98,6 +98,8 @@ void FCFS::RegisterStats( )
     AddStat(measuredQueueLatencies);
     AddStat(measuredTotalLatencies);
 
+    RegisterLatencyStats( );
+
     MemoryController::RegisterStats( );
 }
 
@@ -116,25 +118,8 @@ bool FCFS::RequestComplete( NVMainRequest * request )
         request->status = MEM_REQUEST_COMPLETE;
         request->completionCycle = GetEventQueue()->GetCurrentCycle();
 
-        /* Update the average latencies based on this request for READ/WRITE only. */
-        averageLatency = ((averageLatency * static_cast<double>(measuredLatencies))
-                           + static_cast<double>(request->completionCycle)
-                           - static_cast<double>(request->issueCycle))
-                       / static_cast<double>(measuredLatencies+1);
-        measuredLatencies += 1;
-
-        averageQueueLatency = ((averageQueueLatency 
-                                * static_cast<double>(measuredQueueLatencies))
-                                + static_cast<double>(request->issueCycle)
-                                - static_cast<double>(request->arrivalCycle))
-                            / static_cast<double>(measuredQueueLatencies+1);
-        measuredQueueLatencies += 1;
-
-        averageTotalLatency = ((averageTotalLatency * static_cast<double>(measuredTotalLatencies))
-                                + static_cast<double>(request->completionCycle)
-                                - static_cast<double>(request->arrivalCycle))
-                            / static_cast<double>(measuredTotalLatencies+1);
-        measuredTotalLatencies += 1;
+        /* Record the latencies of this request for READ/WRITE only. */
+        RecordLatency( request );
     }
 
     return MemoryController::RequestComplete( request );
@@ -197,6 +182,13 @@ void FCFS::Cycle( ncycle_t steps )
 
 void FCFS::CalculateStats( )
 {
+    measuredLatencies = readLatency.GetCount( ) + writeLatency.GetCount( );
+    measuredQueueLatencies = measuredLatencies;
+    measuredTotalLatencies = measuredLatencies;
+    averageLatency = MeanLatency( readLatency, writeLatency );
+    averageQueueLatency = MeanLatency( readQueueLatency, writeQueueLatency );
+    averageTotalLatency = MeanLatency( readTotalLatency, writeTotalLatency );
+
     MemoryController::CalculateStats( );
 }
 
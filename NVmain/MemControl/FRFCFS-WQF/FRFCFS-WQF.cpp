@@ -51,7 +51,8 @@ FRFCFS_WQF::FRFCFS_WQF( ) : readQueueId(0), writeQueueId(1)
     std::cout << "Created a First Ready First Come First Serve memory \
         controller with write queue!" << std::endl;
 
-    InitQueues( 2 );
+    /* Only Enqueue/Prequeue touch the queues, so they can be indexed. */
+    InitQueues( 2, true );
 
     readQueue = &(transactionQueues[readQueueId]);
     writeQueue = &(transactionQueues[writeQueueId]);
@@ -224,6 +225,8 @@ void FRFCFS_WQF::RegisterStats( )
     AddStat(measuredQueueLatencies);
     AddStat(measuredTotalLatencies);
 
+    RegisterLatencyStats( );
+
     MemoryController::RegisterStats( );
 }
 
@@ -302,29 +305,8 @@ bool FRFCFS_WQF::RequestComplete( NVMainRequest * request )
         request->status = MEM_REQUEST_COMPLETE; 
         request->completionCycle = GetEventQueue()->GetCurrentCycle();
 
-        /* 
-         * Update the average latencies based on this request for READ/WRITE 
-         * only 
-         */
-        averageLatency = ((averageLatency 
-                           * static_cast<double>(measuredLatencies))
-                           + static_cast<double>(request->completionCycle)
-                           - static_cast<double>(request->issueCycle))
-                       / static_cast<double>(measuredLatencies+1);
-        measuredLatencies += 1;
-
-        averageQueueLatency = ((averageQueueLatency 
-                                * static_cast<double>(measuredQueueLatencies))
-                                + static_cast<double>(request->issueCycle)
-                                - static_cast<double>(request->arrivalCycle))
-                            / static_cast<double>(measuredQueueLatencies+1);
-        measuredQueueLatencies += 1;
-
-        averageTotalLatency = ((averageTotalLatency * static_cast<double>(measuredTotalLatencies))
-                                + static_cast<double>(request->completionCycle)
-                                - static_cast<double>(request->arrivalCycle))
-                            / static_cast<double>(measuredTotalLatencies+1);
-        measuredTotalLatencies += 1;
+        /* Record the latencies of this request for READ/WRITE only. */
+        RecordLatency( request );
     }
 
     return MemoryController::RequestComplete( request );
@@ -512,6 +494,13 @@ void FRFCFS_WQF::Cycle( ncycle_t steps )
 
 void FRFCFS_WQF::CalculateStats( )
 {
+    measuredLatencies = readLatency.GetCount( ) + writeLatency.GetCount( );
+    measuredQueueLatencies = measuredLatencies;
+    measuredTotalLatencies = measuredLatencies;
+    averageLatency = MeanLatency( readLatency, writeLatency );
+    averageQueueLatency = MeanLatency( readQueueLatency, writeQueueLatency );
+    averageTotalLatency = MeanLatency( readTotalLatency, writeTotalLatency );
+
     if( total_drains > 0 )
     {
         average_writes_per_drain = static_cast<double>(total_drain_writes) / static_cast<double>(total_drains);
@@ -77,7 +77,8 @@ FRFCFS::FRFCFS( )
 
     psInterval = 0;
 
-    InitQueues( 1 );
+    /* Only Enqueue/Prequeue touch the queue, so it can be indexed. */
+    InitQueues( 1, true );
 
     memQueue = &(transactionQueues[0]);
 }
@@ -120,6 +121,8 @@ void FRFCFS::RegisterStats( )
     AddStat(measuredTotalLatencies);
     AddStat(write_pauses);
 
+    RegisterLatencyStats( );
+
     MemoryController::RegisterStats( );
 }
 
@@ -194,24 +197,8 @@ bool FRFCFS::RequestComplete( NVMainRequest * request )
         request->status = MEM_REQUEST_COMPLETE;
         request->completionCycle = GetEventQueue()->GetCurrentCycle();
 
-        /* Update the average latencies based on this request for READ/WRITE only. */
-        averageLatency = ((averageLatency * static_cast<double>(measuredLatencies))
-                           + static_cast<double>(request->completionCycle)
-                           - static_cast<double>(request->issueCycle))
-                       / static_cast<double>(measuredLatencies+1);
-        measuredLatencies += 1;
-
-        averageQueueLatency = ((averageQueueLatency * static_cast<double>(measuredQueueLatencies))
-                                + static_cast<double>(request->issueCycle)
-                                - static_cast<double>(request->arrivalCycle))
-                            / static_cast<double>(measuredQueueLatencies+1);
-        measuredQueueLatencies += 1;
-
-        averageTotalLatency = ((averageTotalLatency * static_cast<double>(measuredTotalLatencies))
-                                + static_cast<double>(request->completionCycle)
-                                - static_cast<double>(request->arrivalCycle))
-                            / static_cast<double>(measuredTotalLatencies+1);
-        measuredTotalLatencies += 1;
+        /* Record the latencies of this request for READ/WRITE only. */
+        RecordLatency( request );
     }
 
     return MemoryController::RequestComplete( request );
@@ -270,6 +257,13 @@ void FRFCFS::Cycle( ncycle_t steps )
 
 void FRFCFS::CalculateStats( )
 {
+    measuredLatencies = readLatency.GetCount( ) + writeLatency.GetCount( );
+    measuredQueueLatencies = measuredLatencies;
+    measuredTotalLatencies = measuredLatencies;
+    averageLatency = MeanLatency( readLatency, writeLatency );
+    averageQueueLatency = MeanLatency( readQueueLatency, writeQueueLatency );
+    averageTotalLatency = MeanLatency( readTotalLatency, writeTotalLatency );
+
     MemoryController::CalculateStats( );
 }
 
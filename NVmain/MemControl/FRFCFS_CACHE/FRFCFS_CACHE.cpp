@@ -46,6 +46,8 @@
 #include <iostream>
 #include <set>
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 using namespace NVM;
 
@@ -76,11 +78,33 @@ FRFCFS_CACHE::FRFCFS_CACHE( )
     starvation_precharges = 0;
 
     psInterval = 0;
+
+    DataCache = NULL;
+    writePolicy = SRAM_WRITE_THROUGH;
+    sramReadEnergy = 0.0;
+    sramWriteEnergy = 0.0;
+    writebackQueueSize = 32;
+    writebackHighWaterMark = 24;
+    outstandingRequests = 0;
+    pendingReads = 0;
+
     myCacheTries = 0;
     myCacheHits = 0;
+    myCacheMisses = 0;
     myCacheWrites = 0;
-
-    InitQueues( 1 );
+    myCacheWriteHits = 0;
+    myCacheWriteMisses = 0;
+    myCacheFills = 0;
+    myCacheEvictions = 0;
+    myCacheOccupancy = 0;
+    myCacheWritebacks = 0;
+    myCacheHitRate = 0.0;
+    myCacheReadEnergy = 0.0;
+    myCacheWriteEnergy = 0.0;
+    myCacheEnergy = 0.0;
+
+    /* Only Enqueue/Prequeue touch the queue, so it can be indexed. */
+    InitQueues( 1, true );
 
     memQueue = &(transactionQueues[0]);
 }
@@ -89,6 +113,14 @@ FRFCFS_CACHE::~FRFCFS_CACHE( )
 {
     std::cout << "FRFCFS_CACHE memory controller destroyed. " << memQueue->size( ) 
               << " commands still in memory queue." << std::endl;
+
+    while( !writebackQueue.empty( ) )
+    {
+        delete writebackQueue.front( );
+        writebackQueue.pop_front( );
+    }
+
+    delete DataCache;
 }
 
 void FRFCFS_CACHE::SetConfig( Config *conf, bool createChildren )
@@ -103,6 +135,85 @@ void FRFCFS_CACHE::SetConfig( Config *conf, bool createChildren )
         queueSize = static_cast<unsigned int>( conf->GetValue( "QueueSize" ) );
     }
 
+    /* SRAM cache geometry. The defaults are 2^22 64-byte lines, fully associative. */
+    uint64_t sramSize = 262144;
+    uint64_t sramAssoc = 0;
+    uint64_t sramLineSize = 64;
+    uint64_t sramLatency = 4;
+    MySRAMCache::ReplacementPolicy sramPolicy = MySRAMCache::RANDOM;
+
+    if( conf->KeyExists( "SRAMCacheSize" ) )
+        sramSize = conf->GetValueUL( "SRAMCacheSize" );
+    if( conf->KeyExists( "SRAMCacheAssociativity" ) )
+        sramAssoc = conf->GetValueUL( "SRAMCacheAssociativity" );
+    if( conf->KeyExists( "SRAMCacheLineSize" ) )
+        sramLineSize = conf->GetValueUL( "SRAMCacheLineSize" );
+    if( conf->KeyExists( "SRAMCacheLatency" ) )
+        sramLatency = conf->GetValueUL( "SRAMCacheLatency" );
+    if( conf->KeyExists( "SRAMCacheReadEnergy" ) )
+        sramReadEnergy = conf->GetEnergy( "SRAMCacheReadEnergy" );
+    if( conf->KeyExists( "SRAMCacheWriteEnergy" ) )
+        sramWriteEnergy = conf->GetEnergy( "SRAMCacheWriteEnergy" );
+
+    if( conf->KeyExists( "SRAMCacheReplacement" ) )
+    {
+        std::string replacement = conf->GetString( "SRAMCacheReplacement" );
+
+        if( replacement == "LRU" )
+            sramPolicy = MySRAMCache::LRU;
+        else if( replacement == "PLRU" )
+            sramPolicy = MySRAMCache::PLRU;
+        else if( replacement == "SRRIP" )
+            sramPolicy = MySRAMCache::SRRIP;
+        else if( replacement != "Random" )
+            std::cout << "NVMain Warning: Unknown SRAM cache replacement policy `"
+                      << replacement << "'. Defaulting to Random" << std::endl;
+    }
+
+    if( conf->KeyExists( "SRAMCacheWritePolicy" ) )
+    {
+        std::string policy = conf->GetString( "SRAMCacheWritePolicy" );
+
+        if( policy == "WriteThrough" )
+            writePolicy = SRAM_WRITE_THROUGH;
+        else if( policy == "WriteNoAllocate" )
+            writePolicy = SRAM_WRITE_NO_ALLOCATE;
+        else if( policy == "WriteBack" )
+            writePolicy = SRAM_WRITE_BACK;
+        else
+            std::cout << "NVMain Warning: Unknown SRAM cache write policy `"
+                      << policy << "'. Defaulting to WriteThrough" << std::endl;
+    }
+
+    if( conf->KeyExists( "SRAMCacheWritebackQueueSize" ) )
+        writebackQueueSize = conf->GetValueUL( "SRAMCacheWritebackQueueSize" );
+    if( conf->KeyExists( "SRAMCacheWritebackHighWaterMark" ) )
+        writebackHighWaterMark = conf->GetValueUL( "SRAMCacheWritebackHighWaterMark" );
+
+    uint64_t sramLines = (sramLineSize == 0) ? 0 : sramSize * 1024 / sramLineSize;
+    uint64_t sramWays = (sramAssoc == 0) ? sramLines : sramAssoc;
+
+    if( sramLines == 0 || (sramLines & (sramLines - 1)) != 0 
+        || (sramLineSize & (sramLineSize - 1)) != 0
+        || sramWays > sramLines || sramLines % sramWays != 0
+        || ((sramLines / sramWays) & (sramLines / sramWays - 1)) != 0
+        || (sramPolicy == MySRAMCache::PLRU && (sramWays & (sramWays - 1)) != 0) )
+    {
+        std::cerr << "NVMain Error: FRFCFS_CACHE needs a power of two number of "
+                  << "SRAMCacheSize / SRAMCacheLineSize lines and sets (and ways "
+                  << "for PLRU). Got " << sramSize << " KB, " << sramLineSize 
+                  << " byte lines, associativity " << sramAssoc << "." << std::endl;
+        exit(1);
+    }
+
+    uint64_t sramLineBits = 0;
+    while( (1ULL << sramLineBits) < sramLines )
+        sramLineBits++;
+
+    delete DataCache;
+    DataCache = new MySRAMCache( sramLineBits, sramLatency, sramAssoc,
+                                 sramLineSize, sramPolicy );
+
     MemoryController::SetConfig( conf, createChildren );
 
     SetDebugName( "FRFCFS_CACHE", conf );
@@ -124,7 +235,20 @@ void FRFCFS_CACHE::RegisterStats( )
     AddStat(write_pauses);
     AddStat(myCacheTries);
     AddStat(myCacheHits);
+    AddStat(myCacheMisses);
+    AddStat(myCacheHitRate);
     AddStat(myCacheWrites);
+    AddStat(myCacheWriteHits);
+    AddStat(myCacheWriteMisses);
+    AddStat(myCacheFills);
+    AddStat(myCacheEvictions);
+    AddStat(myCacheOccupancy);
+    AddStat(myCacheWritebacks);
+    AddUnitStat(myCacheReadEnergy, "nJ");
+    AddUnitStat(myCacheWriteEnergy, "nJ");
+    AddUnitStat(myCacheEnergy, "nJ");
+
+    RegisterLatencyStats( );
 
     MemoryController::RegisterStats( );
 }
@@ -135,8 +259,12 @@ bool FRFCFS_CACHE::IsIssuable( NVMainRequest * /*request*/, FailReason * /*fail*
 
     /*
      *  Limit the number of commands in the queue. This will stall the caches/CPU.
+     *  Writebacks complete without a response to the CPU, which would never be
+     *  told to retry, so only stall while one of its requests is outstanding.
      */ 
-    if( memQueue->size( ) >= queueSize )
+    if( outstandingRequests > 0 
+        && ( memQueue->size( ) >= queueSize 
+             || writebackQueue.size( ) >= writebackQueueSize ) )
     {
         rv = false;
     }
@@ -156,39 +284,67 @@ bool FRFCFS_CACHE::IssueCommand( NVMainRequest *req )
     }
 
     req->arrivalCycle = GetEventQueue()->GetCurrentCycle();
+    ++outstandingRequests;
+
+    uint64_t issueReqAddress = req->address.GetPhysicalAddress();
+    uint64_t issueReqSize = SRAMAccessSize( req );
+
     if( req->type == READ )
     {
         ++myCacheTries;
+        myCacheReadEnergy += sramReadEnergy;
 
-        uint64_t issueReqAddress = req->address.GetPhysicalAddress();
-        uint64_t issueReqSize = req->data.GetSize();
-        if(DataCache->hasData(issueReqAddress,
-           issueReqSize))
-    	{
+        /* Hits are copied straight into the request's own data block. */
+        if(DataCache->readData(issueReqAddress,
+                               req->data.IsValid() ? req->data.rawData : NULL,
+                               issueReqSize))
+        {
             ++mem_reads;
-	    ++myCacheHits;
+            ++myCacheHits;
             uint64_t proximoAcceso = req->arrivalCycle
-                                + DataCache->getLatenciaCiclos();
+                                   + DataCache->getLatenciaCiclos();
 
-	        req->data.rawData = DataCache->readData(
-                                issueReqAddress,
-	                            issueReqSize);
+            /* Served by the SRAM cache, so it spends no time in the queue. */
+            req->issueCycle = req->arrivalCycle;
 
-	        assert(req->data.rawData != nullptr);
-	        
-	        GetEventQueue()->InsertEvent(EventResponse, this, req,
-	                            proximoAcceso);      
+            GetEventQueue()->InsertEvent(EventResponse, this, req,
+                                         proximoAcceso);
             return true;
         }
+
+        ++myCacheMisses;
     }
     else
     {
-        if(req->data.IsValid())
+        bool writeHit = DataCache->hasData(issueReqAddress, issueReqSize);
+
+        if(writeHit)
+            ++myCacheWriteHits;
+        else
+            ++myCacheWriteMisses;
+
+        if(writeHit || writePolicy != SRAM_WRITE_NO_ALLOCATE)
         {
             ++myCacheWrites;
-            DataCache->writeData(req->address.GetPhysicalAddress(),
-                                req->data.rawData,
-                                req->data.GetSize());
+            myCacheWriteEnergy += sramWriteEnergy;
+            DataCache->writeData(issueReqAddress,
+                                req->data.IsValid() ? req->data.rawData : NULL,
+                                issueReqSize, writePolicy == SRAM_WRITE_BACK);
+        }
+
+        /* In write-back mode the write is absorbed by the SRAM cache. */
+        if(writePolicy == SRAM_WRITE_BACK)
+        {
+            ++mem_writes;
+
+            QueueWritebacks( req );
+            DrainWritebacks( );
+
+            req->issueCycle = req->arrivalCycle;
+
+            GetEventQueue()->InsertEvent(EventResponse, this, req,
+                                         req->arrivalCycle + DataCache->getLatenciaCiclos());
+            return true;
         }
     }
     
@@ -199,7 +355,10 @@ bool FRFCFS_CACHE::IssueCommand( NVMainRequest *req )
     Enqueue( 0, req );
     
     if(req->type == READ)
+    {
     	mem_reads++;
+        pendingReads++;
+    }
 	else
 	    mem_writes++;
 
@@ -236,36 +395,42 @@ bool FRFCFS_CACHE::RequestComplete( NVMainRequest * request )
         request->status = MEM_REQUEST_COMPLETE;
         request->completionCycle = GetEventQueue()->GetCurrentCycle();
 
-        if(request->type != WRITE)
+        /* Fill the SRAM cache with reads that had to go to memory. */
+        if((request->type == READ || request->type == READ_PRECHARGE)
+            && (request->flags & NVMainRequest::FLAG_ISSUED))
         {
-            if(request->data.IsValid())
+            uint64_t fillAddress = request->address.GetPhysicalAddress();
+
+            /*
+             *  A write absorbed while the read was in flight is newer than
+             *  the data memory returned, so don't overwrite it.
+             */
+            if(writePolicy != SRAM_WRITE_BACK
+                || !DataCache->hasData(fillAddress, SRAMAccessSize( request )))
             {
-                DataCache->writeData(request->address.GetPhysicalAddress(),
-                                    request->data.rawData,
-                                    request->data.GetSize());
+                ++myCacheFills;
+                myCacheWriteEnergy += sramWriteEnergy;
+                DataCache->writeData(fillAddress,
+                                    request->data.IsValid() ? request->data.rawData : NULL,
+                                    SRAMAccessSize( request ));
+
+                QueueWritebacks( request );
             }
+
+            --pendingReads;
         }
-        /* Update the average latencies based on this request for READ/WRITE only. */
-        averageLatency = ((averageLatency * static_cast<double>(measuredLatencies))
-                           + static_cast<double>(request->completionCycle)
-                           - static_cast<double>(request->issueCycle))
-                       / static_cast<double>(measuredLatencies+1);
-        measuredLatencies += 1;
-
-        averageQueueLatency = ((averageQueueLatency * static_cast<double>(measuredQueueLatencies))
-                                + static_cast<double>(request->issueCycle)
-                                - static_cast<double>(request->arrivalCycle))
-                            / static_cast<double>(measuredQueueLatencies+1);
-        measuredQueueLatencies += 1;
-
-        averageTotalLatency = ((averageTotalLatency * static_cast<double>(measuredTotalLatencies))
-                                + static_cast<double>(request->completionCycle)
-                                - static_cast<double>(request->arrivalCycle))
-                            / static_cast<double>(measuredTotalLatencies+1);
-        measuredTotalLatencies += 1;
+        /* Record the latencies of this request for READ/WRITE only. */
+        RecordLatency( request );
     }
 
-    return MemoryController::RequestComplete( request );
+    if( request->owner != this )
+        --outstandingRequests;
+
+    bool rv = MemoryController::RequestComplete( request );
+
+    DrainWritebacks( );
+
+    return rv;
 }
 
 void FRFCFS_CACHE::Cycle( ncycle_t steps )
@@ -316,11 +481,93 @@ void FRFCFS_CACHE::Cycle( ncycle_t steps )
     /* Issue any commands in the command queues. */
     CycleCommandQueues( );
 
+    /* Issuing a transaction may have made room for writebacks. */
+    DrainWritebacks( );
+
     MemoryController::Cycle( steps );
 }
 
+/*
+ *  Turn the dirty lines evicted by the last SRAM access into writes to
+ *  memory. They wait in the writeback queue until DrainWritebacks sends
+ *  them on.
+ */
+void FRFCFS_CACHE::QueueWritebacks( NVMainRequest *trigger )
+{
+    uint64_t victimAddress;
+    std::vector<uint8_t> victimData( DataCache->getLineSize( ) );
+    bool withData = trigger->data.IsValid( );
+
+    while( DataCache->takeDirtyVictim( victimAddress, 
+                                       withData ? &victimData[0] : NULL ) )
+    {
+        NVMainRequest *writeback = new NVMainRequest( );
+
+        /* Same channel as the request that evicted it. */
+        writeback->address = trigger->address;
+        writeback->address.SetPhysicalAddress( victimAddress );
+        writeback->owner = this;
+        writeback->type = WRITE;
+        writeback->arrivalCycle = GetEventQueue()->GetCurrentCycle();
+
+        if( withData )
+        {
+            writeback->data.SetSize( victimData.size( ) );
+            memcpy( writeback->data.rawData, &victimData[0], victimData.size( ) );
+        }
+
+        writebackQueue.push_back( writeback );
+
+        ++myCacheWritebacks;
+        myCacheReadEnergy += sramReadEnergy;
+    }
+}
+
+/*
+ *  Writebacks go to memory while no reads are waiting on it, or ahead of
+ *  reads once the queue reaches its high water mark.
+ */
+void FRFCFS_CACHE::DrainWritebacks( )
+{
+    while( !writebackQueue.empty( ) && memQueue->size( ) < queueSize
+           && ( pendingReads == 0 || writebackQueue.size( ) >= writebackHighWaterMark ) )
+    {
+        NVMainRequest *writeback = writebackQueue.front( );
+
+        writebackQueue.pop_front( );
+        writeback->arrivalCycle = GetEventQueue()->GetCurrentCycle();
+
+        Enqueue( 0, writeback );
+    }
+}
+
+/*
+ *  Requests without data (e.g., IgnoreData) still look up and fill the line
+ *  holding their address so the hit rate matches a run with data.
+ */
+uint64_t FRFCFS_CACHE::SRAMAccessSize( NVMainRequest *request )
+{
+    if( request->data.IsValid( ) )
+        return request->data.GetSize( );
+
+    return 1;
+}
+
 void FRFCFS_CACHE::CalculateStats( )
 {
+    measuredLatencies = readLatency.GetCount( ) + writeLatency.GetCount( );
+    measuredQueueLatencies = measuredLatencies;
+    measuredTotalLatencies = measuredLatencies;
+    averageLatency = MeanLatency( readLatency, writeLatency );
+    averageQueueLatency = MeanLatency( readQueueLatency, writeQueueLatency );
+    averageTotalLatency = MeanLatency( readTotalLatency, writeTotalLatency );
+
+    myCacheEvictions = DataCache->getEvictions( );
+    myCacheOccupancy = DataCache->getCurrSize( );
+    myCacheHitRate = (myCacheTries == 0) ? 0.0 
+                   : static_cast<double>(myCacheHits) / static_cast<double>(myCacheTries);
+    myCacheEnergy = myCacheReadEnergy + myCacheWriteEnergy;
+
     MemoryController::CalculateStats( );
 }
 
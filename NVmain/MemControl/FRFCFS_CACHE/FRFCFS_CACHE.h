@@ -58,10 +58,28 @@ class FRFCFS_CACHE : public MemoryController
     void CalculateStats( );
 
   private:
+    enum SRAMWritePolicy
+    {
+        SRAM_WRITE_THROUGH,     /* writes update (and allocate) lines, then go to memory */
+        SRAM_WRITE_NO_ALLOCATE, /* like write-through, but write misses bypass the cache */
+        SRAM_WRITE_BACK         /* writes only dirty the line, dirty victims are written back */
+    };
+
     NVMTransactionQueue *memQueue;
 
     /* Cached Configuration Variables*/
     uint64_t queueSize;
+    SRAMWritePolicy writePolicy;
+    double sramReadEnergy, sramWriteEnergy;
+    uint64_t writebackQueueSize, writebackHighWaterMark;
+
+    /* Write-back state */
+    std::deque<NVMainRequest *> writebackQueue;
+    uint64_t outstandingRequests, pendingReads;
+
+    uint64_t SRAMAccessSize( NVMainRequest *request );
+    void QueueWritebacks( NVMainRequest *trigger );
+    void DrainWritebacks( );
 
     /* Stats */
     uint64_t measuredLatencies, measuredQueueLatencies, measuredTotalLatencies;
@@ -73,9 +91,13 @@ class FRFCFS_CACHE : public MemoryController
     uint64_t write_pauses;
     
     /* Cache */
-    MySRAMCache *DataCache = new MySRAMCache(22, 4);
+    MySRAMCache *DataCache;
     /* Cache Stats */
-    uint64_t myCacheTries, myCacheHits, myCacheWrites;
+    uint64_t myCacheTries, myCacheHits, myCacheMisses, myCacheWrites;
+    uint64_t myCacheWriteHits, myCacheWriteMisses, myCacheFills;
+    uint64_t myCacheEvictions, myCacheOccupancy, myCacheWritebacks;
+    double myCacheHitRate;
+    double myCacheReadEnergy, myCacheWriteEnergy, myCacheEnergy;
 };
 
 };
@@ -1,198 +1,502 @@
 #include "MySRAMCache.h"
-#define TAMANYO 64
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <iostream>
+
+MySRAMCache::MySRAMCache( uint64_t n, uint64_t lat, uint64_t assoc,
+                          uint64_t lineBytes, ReplacementPolicy policy_ )
+    : currSize(0), evictions(0), latenciaCiclos(lat), policy(policy_)
+{
+    maxSize = 1ULL << n;
+    numWays = (assoc == 0) ? maxSize : assoc;
+    lineSize = lineBytes;
+
+    assert( numWays <= maxSize && maxSize % numWays == 0 );
+    assert( numWays < NO_WAY );
+    assert( lineSize > 0 && (lineSize & (lineSize - 1)) == 0 );
+
+    numSets = maxSize / numWays;
+    assert( (numSets & (numSets - 1)) == 0 );
+
+    /* El árbol PLRU necesita un número de vías potencia de 2 */
+    assert( policy != PLRU || (numWays & (numWays - 1)) == 0 );
+
+    lineShift = 0;
+    while( (1ULL << lineShift) < lineSize )
+        lineShift++;
+
+    setIndexMask = numSets - 1;
+    maskWords = (lineSize + 63) / 64;
+
+    tags = mapArray<uint64_t>( maxSize );
+    validMask = mapArray<uint64_t>( maxSize * maskWords );
+    dirtyMask = mapArray<uint64_t>( maxSize * maskWords );
+    lineData = mapArray<uint8_t>( maxSize * lineSize );
+    setUsed = mapArray<uint64_t>( numSets );
+    setLines = mapArray<uint64_t>( numSets );
+
+    lruPrev = lruNext = lruHead = lruTail = NULL;
+    plruBits = rrpv = NULL;
+
+    if( policy == LRU )
+    {
+        lruPrev = mapArray<uint32_t>( maxSize );
+        lruNext = mapArray<uint32_t>( maxSize );
+        lruHead = mapArray<uint32_t>( numSets );
+        lruTail = mapArray<uint32_t>( numSets );
+
+        /* Listas vacías: NO_WAY tiene todos los bits a 1 */
+        memset( lruHead, 0xFF, numSets * sizeof(uint32_t) );
+        memset( lruTail, 0xFF, numSets * sizeof(uint32_t) );
+    }
+    else if( policy == PLRU )
+    {
+        plruBits = mapArray<uint8_t>( maxSize );
+    }
+    else if( policy == SRRIP )
+    {
+        rrpv = mapArray<uint8_t>( maxSize );
+    }
+    else
+    {
+        srand(2021);
+    }
+}
 
 MySRAMCache::~MySRAMCache( )
 {
-  
+    std::vector<std::pair<void *, uint64_t> >::iterator it;
+
+    for( it = mappings.begin( ); it != mappings.end( ); it++ )
+        munmap( it->first, it->second );
+}
+
+/*
+*   Las páginas anónimas se entregan a cero y no ocupan memoria hasta que
+*   se escriben, así que una caché grande y poco usada es barata.
+*/
+template<typename T> T *MySRAMCache::mapArray(uint64_t count)
+{
+    uint64_t bytes = std::max<uint64_t>( count * sizeof(T), 1 );
+    void *mapping = mmap( NULL, bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+    if( mapping == MAP_FAILED )
+    {
+        std::cerr << "MySRAMCache: Could not map " << bytes << " bytes!" << std::endl;
+        exit(1);
+    }
+
+    mappings.push_back( std::make_pair( mapping, bytes ) );
+
+    return static_cast<T *>( mapping );
 }
 
 bool MySRAMCache::hasData(uint64_t addr, uint64_t size)
 {
-  uint64_t moddedAddr = addr;
-  uint64_t tag = moddedAddr & mascaraDir;
-  uint64_t desplz = moddedAddr & mascaraDesplz;
-  uint64_t porLeer = size;
-
-  while(porLeer)
-  { 
-    if(!memoria.count(tag))
-      return false;
-
-    porLeer = porLeer - (TAMANYO - desplz);
-    if(porLeer < 1) //Asegurar el valor a 0 para finalizar el bucle
-      porLeer = 0;
-
-    moddedAddr += (TAMANYO - desplz);
-
-    tag = moddedAddr & mascaraDir;
-    desplz = moddedAddr & mascaraDesplz;
-  }  
-
-  return true;
-}
-
-uint8_t* MySRAMCache::readData(uint64_t addr, uint64_t size)
-{
-  uint64_t moddedAddr = addr;
-  uint64_t tag = moddedAddr & mascaraDir;
-  uint64_t desplz = moddedAddr & mascaraDesplz;
-  uint64_t porLeer = size;
-  uint8_t *rv = new uint8_t[size];
-  uint64_t posBaseRV = 0;
-  std::vector<MySRAMCacheEntry> linea;
-
-  while(porLeer)
-  {
-    //Leer datos de la dirección (alineada a TAMANYO Bytes)
-    linea = memoria[tag];
-
-    //Copiar los valores al vector de retorno
-    int i = 0;
-    for(;i + desplz < TAMANYO && porLeer; i++)
-    {
-      
-      if(linea[i + desplz].getVal())
-        rv[posBaseRV + i] = linea[i + desplz].getDato();
-      else
-        rv[posBaseRV + i] = 0;
-      --porLeer;
-    }
-    posBaseRV = i;
-    
-    /*
-    *   Actualizar la dirección añadiendo los bytes que hemos escrito + 1
-    *   para indicar que queremos empezar a leer la primera palabra del 
-    *   siguiente bloque alineado con TAMANYO bytes.
-    */
-    moddedAddr +=  i;
-
-    //Calcular la nueva etiqueta y el nuevo desplazamiento
-    tag = moddedAddr & mascaraDir;
-    desplz = moddedAddr & mascaraDesplz;
- }
-  //Devolver el puntero al primer elemento (array) con los datos leidos.
-  return rv;
-}
-
-bool MySRAMCache::writeData(uint64_t addr, uint8_t* data, uint64_t size)
-{
-  assert(data != 0x0);
-  uint64_t moddedAddr = addr;
-  uint64_t tag = moddedAddr & mascaraDir;
-  uint64_t desplz = moddedAddr & mascaraDesplz;
-  uint64_t porEscribir = size;
-  uint64_t posBaseData = 0;
-
-
-  while(porEscribir)
-  {
-    if(hasData(tag,porEscribir)) //Actualizar una linea ya existente
-    {
-      //Leer datos de la dirección (alineada a TAMANYO Bytes)
-      std::vector<MySRAMCacheEntry>linea = memoria[tag];
-
-      /*
-      *   Insertar modificaciones hasta que no quepa más en la linea de cache
-      *   (que corresponde a un bloque de TAMANYO Bytes)
-      */
-      int i = 0;
-      for(; i + desplz < TAMANYO && porEscribir; ++i)
-      {
-        MySRAMCacheEntry datoAGuardar(data[i + posBaseData]);
-        linea[i+desplz] = datoAGuardar;
-        --porEscribir;
-      }
-      posBaseData = i;
-
-      //Guardar la linea modificada
-      memoria[tag] = linea;
-
-      /*
-      *   Actualizar la dirección añadiendo los bytes que hemos escrito + 1
-      *   para indicar que queremos empezar a leer la primera palabra del
-      *   siguiente bloque alineado con TAMANYO bytes.
-      */
-      moddedAddr +=  i;
-
-      //Calcular la nueva etiqueta y el nuevo desplazamiento
-      tag = moddedAddr & mascaraDir;
-      desplz = moddedAddr & mascaraDesplz;
-    }
-    else //Añadir una linea nueva
-    {
-
-      //Crear una línea nueva de TAMANYO entradas
-      std::vector<MySRAMCacheEntry> wv(TAMANYO);
-
-      //Añadir los datos a esta nueva línea
-      int i = 0;
-      for(; i < TAMANYO ; ++i)
-      {
-        wv[i] = MySRAMCacheEntry(0);
-      }
-
-      //Añadir los datos a esta nueva línea
-      for(i = 0; i + desplz < TAMANYO && porEscribir ; ++i)
-      {
-        if(&wv + i + desplz != 0)
-          wv[i+desplz] = MySRAMCacheEntry(data[i]);
-        else
-          wv[i+desplz] = MySRAMCacheEntry(0);
-        --porEscribir;
-      }
+    uint64_t lineAddr = addr >> lineShift;
+    uint64_t desplz = addr & (lineSize - 1);
+    uint64_t porLeer = size;
+
+    while(porLeer)
+    {
+        uint64_t bytes = std::min( porLeer, lineSize - desplz );
+        uint64_t slot = findLine(lineAddr);
+
+        if(slot == NO_LINE || !testBytes(validMask + slot * maskWords, desplz, bytes))
+            return false;
+
+        porLeer -= bytes;
+        desplz = 0;
+        ++lineAddr;
+    }
+
+    return true;
+}
+
+bool MySRAMCache::readData(uint64_t addr, uint8_t* data, uint64_t size)
+{
+    uint64_t lineAddr = addr >> lineShift;
+    uint64_t desplz = addr & (lineSize - 1);
+    uint64_t porLeer = size;
+    uint8_t *pos = data;
+
+    /* Caso habitual: el acceso cabe en una línea, se busca una sola vez */
+    if(size != 0 && size <= lineSize - desplz)
+    {
+        uint64_t slot = findLine(lineAddr);
+
+        if(slot == NO_LINE || !testBytes(validMask + slot * maskWords, desplz, size))
+            return false;
 
-      /*
-       * No cabría una linea nueva y por lo tanto
-       * habría que sustituir una existente por la nueva
-       */
-      if(currSize + 1 > maxSize)
-      {
-        uint64_t indexToBeReplaced = rand() % maxSize; //[0, maxSize - 1]
-        uint64_t tagToBeReplaced = dirArray[indexToBeReplaced];
-        
-        invalidateData(tagToBeReplaced,porEscribir);
+        if(data != NULL)
+            memcpy(data, lineData + slot * lineSize + desplz, size);
 
-        dirArray[indexToBeReplaced] = tag;
+        touchLine(slot);
 
-        assert(currSize < maxSize);
-      }
-      else
-        dirArray[currSize] = tag;
+        return true;
+    }
+
+    if(!hasData(addr, size))
+        return false;
 
-      //Incrementar el tamaño
-      ++currSize;
+    while(porLeer)
+    {
+        uint64_t bytes = std::min( porLeer, lineSize - desplz );
+        uint64_t slot = findLine(lineAddr);
 
-      //Guardar la línea nueva
-      memoria[tag] = wv;
+        if(pos != NULL)
+        {
+            memcpy(pos, lineData + slot * lineSize + desplz, bytes);
+            pos += bytes;
+        }
 
-      /*
-      *   Actualizar la dirección añadiendo los bytes que hemos escrito + 1
-      *   para indicar que queremos empezar a leer la primera palabra del 
-      *   siguiente bloque alineado con TAMANYO bytes.
-      */
-      moddedAddr +=  i;
+        touchLine(slot);
 
-      //Calcular la nueva etiqueta y el nuevo desplazamiento
-      tag = moddedAddr & mascaraDir;
-      desplz = moddedAddr & mascaraDesplz;
+        porLeer -= bytes;
+        desplz = 0;
+        ++lineAddr;
     }
-  }
 
-  return true;
+    return true;
+}
+
+bool MySRAMCache::writeData(uint64_t addr, uint8_t* data, uint64_t size, bool dirty)
+{
+    uint64_t lineAddr = addr >> lineShift;
+    uint64_t desplz = addr & (lineSize - 1);
+    uint64_t porEscribir = size;
+    const uint8_t *pos = data;
+
+    while(porEscribir)
+    {
+        uint64_t bytes = std::min( porEscribir, lineSize - desplz );
+        uint64_t slot = findLine(lineAddr);
+
+        if(slot == NO_LINE)
+            slot = allocateLine(lineAddr);
+        else
+            touchLine(slot);
+
+        if(pos != NULL)
+            memcpy(lineData + slot * lineSize + desplz, pos, bytes);
+
+        markBytes(validMask + slot * maskWords, desplz, bytes);
+
+        if(dirty)
+            markBytes(dirtyMask + slot * maskWords, desplz, bytes);
+
+        if(pos != NULL)
+            pos += bytes;
+
+        porEscribir -= bytes;
+        desplz = 0;
+        ++lineAddr;
+    }
+
+    return true;
 }
 
 bool MySRAMCache::invalidateData(uint64_t addr, uint64_t size)
 {
-  uint64_t tag = addr & mascaraDir;
-  
-  if(!hasData(tag,size))
-  {
+    uint64_t lineAddr = addr >> lineShift;
+    uint64_t lastLine = (addr + std::max<uint64_t>( size, 1 ) - 1) >> lineShift;
+    bool rv = false;
+
+    for( ; lineAddr <= lastLine; ++lineAddr )
+    {
+        uint64_t slot = findLine(lineAddr);
+
+        if(slot != NO_LINE)
+        {
+            evictLine(slot);
+            rv = true;
+        }
+    }
+
+    return rv;
+}
+
+bool MySRAMCache::takeDirtyVictim(uint64_t &addr, uint8_t *data)
+{
+    if(victimLines.empty())
+        return false;
+
+    addr = victimLines.back() << lineShift;
+
+    if(data != NULL)
+        memcpy(data, &victimData[victimData.size() - lineSize], lineSize);
+
+    victimLines.pop_back();
+    victimData.resize(victimData.size() - lineSize);
+
+    return true;
+}
+
+uint64_t MySRAMCache::findLine(uint64_t lineAddr)
+{
+    if(numWays > LINEAR_WAYS)
+    {
+        std::unordered_map<uint64_t, uint64_t>::iterator it = lineIndex.find(lineAddr);
+
+        return (it == lineIndex.end( )) ? NO_LINE : it->second;
+    }
+
+    uint64_t base = (lineAddr & setIndexMask) * numWays;
+    uint64_t tag = lineAddr + 1;
+
+    for(uint64_t way = 0; way < numWays; way++)
+    {
+        if(tags[base + way] == tag)
+            return base + way;
+    }
+
+    return NO_LINE;
+}
+
+/*
+*   Reserva una línea a cero y válida. Se usan primero las vías libres en
+*   orden, como el dirArray original, y sólo si el conjunto está lleno se
+*   reemplaza una víctima.
+*/
+uint64_t MySRAMCache::allocateLine(uint64_t lineAddr)
+{
+    uint64_t set = lineAddr & setIndexMask;
+    uint64_t base = set * numWays;
+    uint64_t slot = NO_LINE;
+
+    if(setUsed[set] < numWays)
+    {
+        slot = base + setUsed[set]++;
+    }
+    else if(setLines[set] < numWays)
+    {
+        /* Hueco dejado por una invalidación */
+        for(uint64_t way = 0; way < numWays && slot == NO_LINE; way++)
+        {
+            if(tags[base + way] == 0)
+                slot = base + way;
+        }
+    }
+    else
+    {
+        slot = chooseVictim(set);
+
+        /* Guardar las víctimas sucias hasta que se escriban en memoria */
+        if(lineDirty(slot))
+        {
+            victimLines.push_back(tags[slot] - 1);
+            victimData.insert(victimData.end(), lineData + slot * lineSize,
+                              lineData + (slot + 1) * lineSize);
+        }
+
+        evictLine(slot);
+        ++evictions;
+    }
+
+    assert(slot != NO_LINE && tags[slot] == 0);
+
+    tags[slot] = lineAddr + 1;
+    memset(lineData + slot * lineSize, 0, lineSize);
+    memset(dirtyMask + slot * maskWords, 0, maskWords * sizeof(uint64_t));
+    markBytes(validMask + slot * maskWords, 0, lineSize);
+
+    if(numWays > LINEAR_WAYS)
+        lineIndex[lineAddr] = slot;
+
+    ++setLines[set];
+    ++currSize;
+    insertLine(slot);
+
+    return slot;
+}
+
+uint64_t MySRAMCache::chooseVictim(uint64_t set)
+{
+    uint64_t base = set * numWays;
+
+    if(policy == LRU)
+    {
+        return base + lruTail[set];
+    }
+    else if(policy == PLRU)
+    {
+        uint64_t node = 0;
+
+        while(node < numWays - 1)
+            node = 2 * node + 1 + plruBits[base + node];
+
+        return base + node - (numWays - 1);
+    }
+    else if(policy == SRRIP)
+    {
+        /* Equivale a envejecer el conjunto hasta que alguna vía llegue a 3 */
+        uint64_t victim = base;
+
+        for(uint64_t way = 1; way < numWays; way++)
+        {
+            if(rrpv[base + way] > rrpv[victim])
+                victim = base + way;
+        }
+
+        uint8_t age = static_cast<uint8_t>(3 - rrpv[victim]);
+
+        if(age != 0)
+        {
+            for(uint64_t way = 0; way < numWays; way++)
+                rrpv[base + way] = static_cast<uint8_t>(rrpv[base + way] + age);
+        }
+
+        return victim;
+    }
+
+    return base + (rand() % numWays); //[0, numWays - 1]
+}
+
+void MySRAMCache::evictLine(uint64_t slot)
+{
+    uint64_t set = slot / numWays;
+
+    removeLine(slot);
+
+    if(numWays > LINEAR_WAYS)
+        lineIndex.erase(tags[slot] - 1);
+
+    tags[slot] = 0;
+    memset(validMask + slot * maskWords, 0, maskWords * sizeof(uint64_t));
+    memset(dirtyMask + slot * maskWords, 0, maskWords * sizeof(uint64_t));
+
+    --setLines[set];
+    --currSize;
+}
+
+bool MySRAMCache::lineDirty(uint64_t slot)
+{
+    for(uint64_t word = 0; word < maskWords; word++)
+    {
+        if(dirtyMask[slot * maskWords + word] != 0)
+            return true;
+    }
+
     return false;
-  }
+}
+
+void MySRAMCache::touchLine(uint64_t slot)
+{
+    if(policy == LRU)
+    {
+        uint64_t set = slot / numWays;
+        uint32_t way = static_cast<uint32_t>(slot - set * numWays);
+
+        if(lruHead[set] != way)
+        {
+            removeLine(slot);
+            insertLine(slot);
+        }
+    }
+    else if(policy == PLRU)
+    {
+        insertLine(slot);
+    }
+    else if(policy == SRRIP)
+    {
+        rrpv[slot] = 0;
+    }
+}
+
+void MySRAMCache::insertLine(uint64_t slot)
+{
+    uint64_t set = slot / numWays;
+    uint64_t base = set * numWays;
+    uint32_t way = static_cast<uint32_t>(slot - base);
+
+    if(policy == LRU)
+    {
+        /* La línea pasa a ser la más reciente (cabeza de la lista) */
+        lruPrev[slot] = NO_WAY;
+        lruNext[slot] = lruHead[set];
+
+        if(lruHead[set] != NO_WAY)
+            lruPrev[base + lruHead[set]] = way;
+        else
+            lruTail[set] = way;
+
+        lruHead[set] = way;
+    }
+    else if(policy == PLRU)
+    {
+        /* Cada nodo del camino apunta a la mitad contraria a la accedida */
+        uint64_t node = way + numWays - 1;
+
+        while(node > 0)
+        {
+            uint64_t parent = (node - 1) / 2;
 
-  /* Eliminar de memoria*/
-  memoria.erase(tag);
-  --currSize;
-  return true;
+            plruBits[base + parent] = (node == 2 * parent + 1) ? 1 : 0;
+            node = parent;
+        }
+    }
+    else if(policy == SRRIP)
+    {
+        rrpv[slot] = 2;
+    }
+}
+
+void MySRAMCache::removeLine(uint64_t slot)
+{
+    if(policy != LRU)
+        return;
+
+    uint64_t set = slot / numWays;
+    uint64_t base = set * numWays;
+    uint32_t prev = lruPrev[slot];
+    uint32_t next = lruNext[slot];
+
+    if(prev != NO_WAY)
+        lruNext[base + prev] = next;
+    else
+        lruHead[set] = next;
+
+    if(next != NO_WAY)
+        lruPrev[base + next] = prev;
+    else
+        lruTail[set] = prev;
+}
+
+void MySRAMCache::markBytes(uint64_t *mask, uint64_t offset, uint64_t size)
+{
+    uint64_t end = offset + size;
+
+    while(offset < end)
+    {
+        uint64_t bit = offset & 63;
+        uint64_t bits = std::min<uint64_t>( 64 - bit, end - offset );
+        uint64_t m = (bits == 64) ? ~0ULL : (((1ULL << bits) - 1) << bit);
+
+        mask[offset >> 6] |= m;
+        offset += bits;
+    }
+}
+
+bool MySRAMCache::testBytes(const uint64_t *mask, uint64_t offset, uint64_t size)
+{
+    uint64_t end = offset + size;
+
+    while(offset < end)
+    {
+        uint64_t bit = offset & 63;
+        uint64_t bits = std::min<uint64_t>( 64 - bit, end - offset );
+        uint64_t m = (bits == 64) ? ~0ULL : (((1ULL << bits) - 1) << bit);
+
+        if((mask[offset >> 6] & m) != m)
+            return false;
+
+        offset += bits;
+    }
 
+    return true;
 }
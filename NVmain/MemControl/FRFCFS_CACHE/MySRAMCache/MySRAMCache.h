@@ -2,138 +2,150 @@
 * Esta clase es la representación del elemento "SRAM Cache Tags"
 * del HMC
 */
-#include "MyUIntStack.h"
-#include <math.h>
-#include <assert.h>
+#ifndef __MYSRAMCACHE_H__
+#define __MYSRAMCACHE_H__
 
-#include <string>
-#include <vector>
-#include <deque>
-#include <iostream>
-#include <list> 
-#include <iterator>
+#include <stdint.h>
 #include <unordered_map>
-#include <bitset>
-
-#define OUT
-
-/*
-*   Clase auxiliar que representa un byte de una línea de caché
-*/
-class MySRAMCacheEntry
-{
-  public:
-    MySRAMCacheEntry( )
-    {
-      dato = 0;
-      val[0] = 0; 
-
-    };
-
-    MySRAMCacheEntry( uint8_t data )
-    {
-      dato = data;
-      val[0] = 1;
-    };
-
-    ~MySRAMCacheEntry( )
-    {
-      
-    };
-
-    uint8_t getDato() const { return dato; }
-    void setDato(const uint8_t &dato_) { dato = dato_; }
-
-    void setVal() {val[0] = 1;}
-    void resetVal() {val[0] = 0;}
-    bool getVal() {return val[0];}
-
-  private:
-    uint8_t dato;
-    std::bitset<1> val;
-
-};
+#include <utility>
+#include <vector>
 
 /*
 *   Clase que implementa la funcionalidad de la caché
+*
+*   Las líneas se guardan en arrays planos indexados por (conjunto * vías + vía):
+*   etiquetas, máscaras de bytes válidos/sucios, datos y el estado de reemplazo.
+*   Los arrays se reservan con mmap, de modo que sólo ocupan memoria las líneas
+*   que se llegan a usar y los datos quedan alineados a línea de caché.
 */
 class MySRAMCache
 {
-
-  typedef std::unordered_map<uint64_t, std::vector<MySRAMCacheEntry>> memoria_cache;
   public:
    /*
-    * Crea una caché con máximo 2^n líneas (de 64 bits cada una)
-    * y lat ciclos de latencia
+    * Políticas de reemplazo disponibles. RANDOM usa rand() con la misma
+    * semilla que la versión original para que los aciertos y fallos no cambien.
+    */
+    enum ReplacementPolicy { LRU, PLRU, SRRIP, RANDOM };
+
+   /*
+    * Crea una caché con 2^n líneas de lineBytes bytes y lat ciclos de latencia
     *
-    * @param n exponente del tamaño máximo de memoria.
-    * @param lat ciclos de latencia de la caché  
+    * @param n exponente del número de líneas.
+    * @param lat ciclos de latencia de la caché
+    * @param assoc vías por conjunto (0 para una caché totalmente asociativa).
+    * @param lineBytes tamaño de línea en bytes (potencia de 2).
+    * @param policy política de reemplazo.
     */
-  public:
-    MySRAMCache( uint64_t n, uint64_t lat ) : currSize(0)
-    {
-      //LRU = new MyUIntStack();
-      maxSize = pow(2, n);
-      latenciaCiclos = lat;
-      srand(2021);
-      dirArray.resize(maxSize);
-    };
+    MySRAMCache( uint64_t n, uint64_t lat, uint64_t assoc = 0,
+                 uint64_t lineBytes = 64, ReplacementPolicy policy = RANDOM );
     ~MySRAMCache( );
 
    /*
     * Comprueba si una dirección de memoria tiene datos válidos.
     *
     * @param addr Dirección a comprobar si tiene dato
-    * @return TRUE si tiene un dato. FALSE si no.
+    * @param size Numero de bytes a comprobar
+    * @return TRUE si todos los bytes son válidos. FALSE si no.
     */
     bool hasData(uint64_t addr, uint64_t size);
 
    /*
-    * Devuelve la palabra que se encuentra en una dirección de memoria
+    * Lee una palabra de la caché si todos sus bytes son válidos, copiándola
+    * en el buffer del llamante y actualizando el estado de reemplazo.
     *
-    * 
     * @param addr Dirección de memoria a leer
+    * @param data Buffer de al menos size bytes (NULL para no copiar nada)
     * @param size Numero de bytes a leer desde la dirección de memoria
-    * @return Un array de uint8_t o nullptr si no existe una entrada en memoria.
+    * @return TRUE si ha habido acierto. FALSE si no (data no se modifica).
     */
-    uint8_t* readData(uint64_t addr, uint64_t size);
+    bool readData(uint64_t addr, uint8_t* data, uint64_t size);
 
    /*
-    * Guarda una cantidad de bytes desde una dirección de memoria
-    * 
+    * Guarda una cantidad de bytes desde una dirección de memoria, reservando
+    * las líneas que no estén en la caché.
+    *
     * @param addr Dirección de memoria donde guardar el dato
-    * @param data Dato a guardar (como uint64_t)
+    * @param data Dato a guardar (NULL para sólo reservar las líneas)
     * @param size Numero de bytes a guardar
+    * @param dirty TRUE para marcar los bytes escritos como sucios.
     * @return TRUE si no ha habido problemas. FALSE si no.
     */
-    bool writeData(uint64_t addr, uint8_t* data, uint64_t size);
+    bool writeData(uint64_t addr, uint8_t* data, uint64_t size, bool dirty = false);
 
    /*
-    * Invalida la palabra de una dirección de memoria
+    * Invalida las líneas que contienen un rango de direcciones
     *
     * @param addr Dirección cuya palabra se quiere invalidar.
     * @param size Numero de bytes a invalidar.
-    * @return TRUE si no ha habido problemas. FALSE si no.
+    * @return TRUE si se ha invalidado alguna línea. FALSE si no.
     */
     bool invalidateData(uint64_t addr, uint64_t size);
 
    /*
-    * Getters y Setters
+    * Saca una línea sucia que ha sido reemplazada y debe escribirse en memoria
+    *
+    * @param addr Dirección de la línea reemplazada.
+    * @param data Buffer de getLineSize() bytes para sus datos (puede ser NULL).
+    * @return TRUE si había una línea sucia pendiente. FALSE si no.
     */
-    inline void setMaxSize(uint64_t maxSize_) {maxSize = maxSize_;}
-    inline void setCurrSize(uint64_t currSize_) {currSize = currSize_;}
+    bool takeDirtyVictim(uint64_t &addr, uint8_t *data);
 
+   /*
+    * Getters
+    */
     inline uint64_t getMaxSize() {return maxSize;}
     inline uint64_t getCurrSize(){return currSize;}
-    
+    inline uint64_t getEvictions(){return evictions;}
+    inline uint64_t getSets() {return numSets;}
+    inline uint64_t getWays() {return numWays;}
+    inline uint64_t getLineSize() {return lineSize;}
+    inline ReplacementPolicy getReplacementPolicy() {return policy;}
+
     inline uint64_t getLatenciaCiclos(){return latenciaCiclos;}
+
   private:
-    memoria_cache memoria;                        //Variable que almacena los datos
-    //MyUIntStack *LRU;                             //Variable que representa LRU
-    const uint64_t mascaraDir =    18446744073709551552ULL;  //Variable para la etiqueta
-    const uint64_t mascaraDesplz = 0x000000000000003F;  //Variable para el desplazamiento
+    static const uint64_t NO_LINE = ~0ULL;    //Hueco inexistente
+    static const uint32_t NO_WAY = ~0U;       //Fin de la lista LRU
+    static const uint64_t LINEAR_WAYS = 16;   //Máximo de vías buscadas en lineal
+
+    uint64_t findLine(uint64_t lineAddr);
+    uint64_t allocateLine(uint64_t lineAddr);
+    uint64_t chooseVictim(uint64_t set);
+    void evictLine(uint64_t slot);
+    bool lineDirty(uint64_t slot);
+
+    void touchLine(uint64_t slot);
+    void insertLine(uint64_t slot);
+    void removeLine(uint64_t slot);
+
+    void markBytes(uint64_t *mask, uint64_t offset, uint64_t size);
+    bool testBytes(const uint64_t *mask, uint64_t offset, uint64_t size);
+
+    template<typename T> T *mapArray(uint64_t count);
+
     uint64_t maxSize, currSize;                   //Variables para gestionar el tamaño
+    uint64_t evictions;                           //Líneas válidas reemplazadas
     uint64_t latenciaCiclos;                      //Variable que contiene la latencia
-    std::vector<uint64_t> dirArray;		  //Vector para reemplazo RANDOM.	
-  protected:
+    ReplacementPolicy policy;
+
+    uint64_t numSets, numWays, lineSize;          //Geometría de la caché
+    uint64_t lineShift, setIndexMask, maskWords;
+
+    uint64_t *tags;                               //Dirección de línea + 1 (0 = inválida)
+    uint64_t *validMask, *dirtyMask;              //Un bit por byte de cada línea
+    uint8_t *lineData;                            //Datos, alineados a línea
+    uint64_t *setUsed;                            //Vías ocupadas alguna vez por conjunto
+    uint64_t *setLines;                           //Líneas válidas por conjunto
+
+    uint32_t *lruPrev, *lruNext;                  //Lista LRU por conjunto (MRU primero)
+    uint32_t *lruHead, *lruTail;
+    uint8_t *plruBits;                            //Árbol PLRU (vías - 1 nodos)
+    uint8_t *rrpv;                                //Valores de re-referencia de SRRIP
+
+    std::unordered_map<uint64_t, uint64_t> lineIndex; //Búsqueda en conjuntos anchos
+    std::vector<uint64_t> victimLines;            //Líneas sucias reemplazadas
+    std::vector<uint8_t> victimData;              //y sus datos
+    std::vector<std::pair<void *, uint64_t> > mappings;
 };
+
+#endif
@@ -304,7 +304,7 @@ bool LH_Cache::RequestComplete( NVMainRequest *req )
         /* If it is a hit, issue a request to the bank for the cache line */
         if( !miss )
         {
-            commandQueues[queueId].push_back( MakeDRCRequest( req ) );
+            EnqueueCommand( queueId, MakeDRCRequest( req ) );
 
             drcHits++;
         }
@@ -391,7 +391,7 @@ bool LH_Cache::RequestComplete( NVMainRequest *req )
                 &measuredHitQueueLatencies );
     }
 
-    if( req->type == REFRESH )
+    if( req->type == REFRESH && req->owner != this )
         ProcessRefreshPulse( req );
     else if( req->owner == this )
     {
@@ -575,10 +575,10 @@ bool LH_Cache::IssueDRCCommands( NVMainRequest *req )
 
         req->issueCycle = GetEventQueue()->GetCurrentCycle();
 
-        commandQueues[queueId].push_back( MakeActivateRequest( req ) );
-        commandQueues[queueId].push_back( MakeTagRequest( req, DRC_TAGREAD1 ) );
-        commandQueues[queueId].push_back( MakeTagRequest( req, DRC_TAGREAD2 ) );
-        commandQueues[queueId].push_back( MakeTagRequest( req, DRC_TAGREAD3 ) );
+        EnqueueCommand( queueId, MakeActivateRequest( req ) );
+        EnqueueCommand( queueId, MakeTagRequest( req, DRC_TAGREAD1 ) );
+        EnqueueCommand( queueId, MakeTagRequest( req, DRC_TAGREAD2 ) );
+        EnqueueCommand( queueId, MakeTagRequest( req, DRC_TAGREAD3 ) );
         bankLocked[rank][bank] = true;
 
         rv = true;
@@ -592,11 +592,11 @@ bool LH_Cache::IssueDRCCommands( NVMainRequest *req )
 
         req->issueCycle = GetEventQueue()->GetCurrentCycle();
 
-        commandQueues[queueId].push_back( MakePrechargeRequest( req ) );
-        commandQueues[queueId].push_back( MakeActivateRequest( req ) );
-        commandQueues[queueId].push_back( MakeTagRequest( req, DRC_TAGREAD1 ) );
-        commandQueues[queueId].push_back( MakeTagRequest( req, DRC_TAGREAD2 ) );
-        commandQueues[queueId].push_back( MakeTagRequest( req, DRC_TAGREAD3 ) );
+        EnqueueCommand( queueId, MakePrechargeRequest( req ) );
+        EnqueueCommand( queueId, MakeActivateRequest( req ) );
+        EnqueueCommand( queueId, MakeTagRequest( req, DRC_TAGREAD1 ) );
+        EnqueueCommand( queueId, MakeTagRequest( req, DRC_TAGREAD2 ) );
+        EnqueueCommand( queueId, MakeTagRequest( req, DRC_TAGREAD3 ) );
         bankLocked[rank][bank] = true;
 
         rv = true;
@@ -607,9 +607,9 @@ bool LH_Cache::IssueDRCCommands( NVMainRequest *req )
 
         req->issueCycle = GetEventQueue()->GetCurrentCycle();
 
-        commandQueues[queueId].push_back( MakeTagRequest( req, DRC_TAGREAD1 ) );
-        commandQueues[queueId].push_back( MakeTagRequest( req, DRC_TAGREAD2 ) );
-        commandQueues[queueId].push_back( MakeTagRequest( req, DRC_TAGREAD3 ) );
+        EnqueueCommand( queueId, MakeTagRequest( req, DRC_TAGREAD1 ) );
+        EnqueueCommand( queueId, MakeTagRequest( req, DRC_TAGREAD2 ) );
+        EnqueueCommand( queueId, MakeTagRequest( req, DRC_TAGREAD3 ) );
         bankLocked[rank][bank] = true;
 
         rv = true;
@@ -639,9 +639,9 @@ bool LH_Cache::IssueFillCommands( NVMainRequest *req )
 
         req->issueCycle = GetEventQueue()->GetCurrentCycle();
 
-        commandQueues[queueId].push_back( MakeActivateRequest( req ) );
-        commandQueues[queueId].push_back( MakeTagWriteRequest( req ) );
-        commandQueues[queueId].push_back( req );
+        EnqueueCommand( queueId, MakeActivateRequest( req ) );
+        EnqueueCommand( queueId, MakeTagWriteRequest( req ) );
+        EnqueueCommand( queueId, req );
 
         rv = true;
     }
@@ -655,10 +655,10 @@ bool LH_Cache::IssueFillCommands( NVMainRequest *req )
 
         req->issueCycle = GetEventQueue()->GetCurrentCycle();
 
-        commandQueues[queueId].push_back( MakePrechargeRequest( req ) );
-        commandQueues[queueId].push_back( MakeActivateRequest( req ) );
-        commandQueues[queueId].push_back( MakeTagWriteRequest( req ) );
-        commandQueues[queueId].push_back( req );
+        EnqueueCommand( queueId, MakePrechargeRequest( req ) );
+        EnqueueCommand( queueId, MakeActivateRequest( req ) );
+        EnqueueCommand( queueId, MakeTagWriteRequest( req ) );
+        EnqueueCommand( queueId, req );
 
         rv = true;
     }
@@ -668,8 +668,8 @@ bool LH_Cache::IssueFillCommands( NVMainRequest *req )
 
         req->issueCycle = GetEventQueue()->GetCurrentCycle();
 
-        commandQueues[queueId].push_back( MakeTagWriteRequest( req ) );
-        commandQueues[queueId].push_back( req );
+        EnqueueCommand( queueId, MakeTagWriteRequest( req ) );
+        EnqueueCommand( queueId, req );
 
         rv = true;
     }
@@ -274,7 +274,7 @@ bool LO_Cache::RequestComplete( NVMainRequest *req )
 {
     bool rv = false;
 
-    if( req->type == REFRESH )
+    if( req->type == REFRESH && req->owner != this )
     {
         ProcessRefreshPulse( req );
     }
@@ -147,7 +147,7 @@ bool PredictorDRC::RequestComplete( NVMainRequest *req )
      */
     bool rv = false;
 
-    if( req->type == REFRESH )
+    if( req->type == REFRESH && req->owner != this )
         ProcessRefreshPulse( req );
     else if( req->owner == this )
     {
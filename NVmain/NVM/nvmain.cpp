@@ -37,6 +37,7 @@
 #include "src/Interconnect.h"
 #include "src/SimInterface.h"
 #include "src/EventQueue.h"
+#include "src/EventQueueFactory.h"
 #include "Interconnect/InterconnectFactory.h"
 #include "MemControl/MemoryControllerFactory.h"
 #include "traceWriter/TraceWriterFactory.h"
@@ -46,8 +47,11 @@
 #include "include/NVMHelpers.h"
 #include "Prefetchers/PrefetcherFactory.h"
 
+#include <algorithm>
 #include <sstream>
 #include <cassert>
+#include <limits>
+#include <thread>
 
 using namespace NVM;
 
@@ -57,6 +61,9 @@ NVMain::NVMain( )
     translator = NULL;
     memoryControllers = NULL;
     channelConfig = NULL;
+    channelQueues = NULL;
+    parallelChannels = false;
+    channelDataNeeded = false;
     syncValue = 0.0f;
     preTracer = NULL;
 
@@ -66,6 +73,8 @@ NVMain::NVMain( )
     prefetcher = NULL;
     successfulPrefetches = 0;
     unsuccessfulPrefetches = 0;
+    requestAllocations = 0;
+    requestHeapAllocations = 0;
 }
 
 NVMain::~NVMain( )
@@ -84,6 +93,14 @@ NVMain::~NVMain( )
         delete [] memoryControllers;
     }
 
+    if( channelQueues )
+    {
+        for( unsigned int i = 0; i < numChannels; i++ )
+            delete channelQueues[i];
+
+        delete [] channelQueues;
+    }
+
     if( translator )
         delete translator;
 
@@ -187,6 +204,25 @@ void NVMain::SetConfig( Config *conf, std::string memoryName, bool createChildre
 
                 channelConfig[i]->Read( channelConfigFile );
             }
+        }
+
+        /* 
+         *  Channels only share this object, so they can get their own event
+         *  queue and run on separate threads. Completions are handed back
+         *  here after each window (see DeliverChannelCompletions).
+         */
+        if( p->ParallelChannels && channels > 1 )
+            parallelChannels = ParallelChannelsSupported( channels );
+
+        if( parallelChannels )
+        {
+            channelQueues = new EventQueue* [channels];
+            channelCompletions.resize( channels );
+        }
+
+        for( int i = 0; i < channels; i++ )
+        {
+            std::stringstream confString;
 
             /* Initialize memory controller */
             memoryControllers[i] = 
@@ -203,13 +239,38 @@ void NVMain::SetConfig( Config *conf, std::string memoryName, bool createChildre
             AddChild( memoryControllers[i] );
             memoryControllers[i]->SetParent( this );
 
+            if( parallelChannels )
+            {
+                channelQueues[i] = EventQueueFactory::CreateEventQueue( channelConfig[i] );
+                memoryControllers[i]->SetEventQueue( channelQueues[i] );
+                GetEventQueue( )->AddPartition( channelQueues[i] );
+            }
+
             /* Set Config recursively. */
             memoryControllers[i]->SetConfig( channelConfig[i], createChildren );
 
             /* Register statistics. */
             memoryControllers[i]->RegisterStats( );
+
+            if( ChannelDataNeeded( channelConfig[i] ) )
+                channelDataNeeded = true;
         }
 
+        if( parallelChannels )
+        {
+            ncounter_t threads = p->ParallelChannelThreads;
+
+            if( threads == 0 )
+                threads = std::min<ncounter_t>( channels, 
+                              std::thread::hardware_concurrency( ) );
+
+            GetEventQueue( )->SetPartitionThreads( threads );
+            GetEventQueue( )->SetPartitionCallback( this, 
+                    (CallbackPtr)&NVMain::DeliverChannelCompletions );
+
+            std::cout << "NVMain: Simulating " << channels << " channels on "
+                      << threads << " threads." << std::endl;
+        }
     }
 
     if( p->MemoryPrefetcher != "none" )
@@ -249,6 +310,15 @@ void NVMain::SetConfig( Config *conf, std::string memoryName, bool createChildre
     }
 
     RegisterStats( );
+
+    /* Everything should be read by now, see Config::Seal. */
+    config->Seal( );
+
+    if( channelConfig )
+    {
+        for( unsigned int i = 0; i < numChannels; i++ )
+            channelConfig[i]->Seal( );
+    }
 }
 
 bool NVMain::IsIssuable( NVMainRequest *request, FailReason *reason )
@@ -259,7 +329,7 @@ bool NVMain::IsIssuable( NVMainRequest *request, FailReason *reason )
     assert( request != NULL );
 
     GetDecoder( )->Translate( request->address.GetPhysicalAddress( ), 
-                           &row, &col, &rank, &bank, &channel, &subarray );
+                           &row, &col, &bank, &rank, &channel, &subarray );
 
     rv = memoryControllers[channel]->IsIssuable( request, reason );
 
@@ -280,11 +350,11 @@ void NVMain::GeneratePrefetches( NVMainRequest *request, std::vector<NVMAddress>
         pfRequest->isPrefetch = true;
         pfRequest->owner = this;
         
-        /* Translate the address, then copy to the address struct, and copy to request. */
-        GetDecoder( )->Translate( request->address.GetPhysicalAddress( ), 
+        /* Translate the prefetch address; the trigger request is already translated. */
+        GetDecoder( )->Translate( pfRequest->address.GetPhysicalAddress( ), 
                                &row, &col, &bank, &rank, &channel, &subarray );
-        request->address.SetTranslatedAddress( row, col, bank, rank, channel, subarray );
-        request->bulkCmd = CMD_NOP;
+        pfRequest->address.SetTranslatedAddress( row, col, bank, rank, channel, subarray );
+        pfRequest->bulkCmd = CMD_NOP;
 
         //std::cout << "Prefetching 0x" << std::hex << (*iter).GetPhysicalAddress() << " (trigger 0x"
         //          << request->address.GetPhysicalAddress( ) << std::dec << std::endl;
@@ -461,6 +531,19 @@ bool NVMain::RequestComplete( NVMainRequest *request )
 {
     bool rv = false;
 
+    /* Channels may be running on other threads; finish this afterwards. */
+    if( parallelChannels && GetEventQueue( )->AdvancingPartitions( ) )
+    {
+        ncounter_t channel = request->address.GetChannel( );
+        ChannelCompletion completion;
+
+        completion.cycle = channelQueues[channel]->GetCurrentCycle( );
+        completion.request = request;
+        channelCompletions[channel].push_back( completion );
+
+        return true;
+    }
+
     if( request->owner == this )
     {
         if( request->isPrefetch )
@@ -519,12 +602,17 @@ void NVMain::RegisterStats( )
     AddStat(totalWriteRequests);
     AddStat(successfulPrefetches);
     AddStat(unsuccessfulPrefetches);
+    AddStat(requestAllocations);
+    AddStat(requestHeapAllocations);
 }
 
 void NVMain::CalculateStats( )
 {
     for( unsigned int i = 0; i < numChannels; i++ )
         memoryControllers[i]->CalculateStats( );
+
+    requestAllocations = NVMainRequest::GetPoolAllocations( );
+    requestHeapAllocations = NVMainRequest::GetPoolHeapAllocations( );
 }
 
 void NVMain::EnqueuePendingMemoryRequests( NVMainRequest *req )
@@ -532,3 +620,137 @@ void NVMain::EnqueuePendingMemoryRequests( NVMainRequest *req )
     pendingMemoryRequests.push(req);
 }
 
+bool NVMain::ParallelChannelsSupported( int channels )
+{
+    std::string reason = "";
+
+    if( p->MemoryPrefetcher != "none" )
+        reason = "prefetches are issued across channels";
+
+    if( p->debugOn )
+        reason = "debug output is shared by all channels";
+
+    if( !GetHooks( NVMHOOK_PREISSUE ).empty( ) 
+        || !GetHooks( NVMHOOK_POSTISSUE ).empty( ) )
+        reason = "hooks are shared by all channels";
+
+    if( GetParent( ) != NULL && dynamic_cast<MemoryController *>( 
+                                    GetParent( )->GetTrampoline( ) ) != NULL )
+        reason = "this memory backs a DRAM cache";
+
+    for( int i = 0; i < channels; i++ )
+    {
+        std::string controller = channelConfig[i]->GetString( "MEM_CTL" );
+
+        /* Only controllers without shared state below them are safe. */
+        if( controller != "FCFS" && controller != "FRFCFS" 
+            && controller != "FRFCFS-WQF" && controller != "FRFCFS_WQF"
+            && controller != "PerfectMemory" )
+            reason = "MEM_CTL " + controller + " is not channel-local";
+
+        if( channelConfig[i]->KeyExists( "EnduranceModel" ) 
+            && channelConfig[i]->GetString( "EnduranceModel" ) != "NullModel" )
+            reason = "endurance models share one random number generator";
+    }
+
+    if( reason != "" )
+    {
+        std::cout << "NVMain: ParallelChannels ignored, " << reason 
+                  << "." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ *  Whether anything in this memory system looks at the data of a request.
+ *  Simulators which have to copy the data into every request (e.g., gem5)
+ *  can leave it out when nothing does.
+ */
+bool NVMain::RequestDataNeeded( )
+{
+    if( p->PrintPreTrace || p->EchoPreTrace )
+        return true;
+
+    if( !GetHooks( NVMHOOK_PREISSUE ).empty( ) 
+        || !GetHooks( NVMHOOK_POSTISSUE ).empty( ) )
+        return true;
+
+    return channelDataNeeded;
+}
+
+/*
+ *  Whether the models configured for one channel look at request data. Read
+ *  while configuring, since the config is sealed afterwards.
+ */
+bool NVMain::ChannelDataNeeded( Config *conf )
+{
+    std::string controller = conf->GetString( "MEM_CTL" );
+
+    /* SRAM and DRAM caches keep the data they hold. */
+    if( controller != "FCFS" && controller != "FRFCFS" 
+        && controller != "FRFCFS-WQF" && controller != "FRFCFS_WQF"
+        && controller != "PerfectMemory" )
+        return true;
+
+    if( conf->KeyExists( "EnduranceModel" ) 
+        && conf->GetString( "EnduranceModel" ) != "NullModel" )
+        return true;
+
+    if( conf->KeyExists( "DataEncoder" ) 
+        && conf->GetString( "DataEncoder" ) != "default" )
+        return true;
+
+    /* MLC write timing and changed-bit counts depend on the data. */
+    if( conf->KeyExists( "MLCLevels" ) && conf->GetValueUL( "MLCLevels" ) > 1 )
+        return true;
+
+    if( conf->KeyExists( "UniformWrites" ) && !conf->GetBool( "UniformWrites" ) )
+        return true;
+
+    if( conf->KeyExists( "WriteAllBits" ) && !conf->GetBool( "WriteAllBits" ) )
+        return true;
+
+    /* Write energy counts the set and reset bits. */
+    if( conf->KeyExists( "EnergyModel" ) 
+        && conf->GetString( "EnergyModel" ) != "current" )
+        return true;
+
+    return false;
+}
+
+void NVMain::DeliverChannelCompletions( void * /*data*/ )
+{
+    std::vector<ncounter_t> next( channelCompletions.size( ), 0 );
+
+    /* 
+     *  Merge the channels' completions by cycle, lowest channel first on a
+     *  tie, which is the order the serial event queue would have used.
+     */
+    for( ;; )
+    {
+        ncounter_t channel = channelCompletions.size( );
+        ncycle_t cycle = std::numeric_limits<ncycle_t>::max( );
+
+        for( ncounter_t i = 0; i < channelCompletions.size( ); i++ )
+        {
+            if( next[i] < channelCompletions[i].size( ) 
+                && channelCompletions[i][next[i]].cycle < cycle )
+            {
+                channel = i;
+                cycle = channelCompletions[i][next[i]].cycle;
+            }
+        }
+
+        if( channel == channelCompletions.size( ) )
+            break;
+
+        RequestComplete( channelCompletions[channel][next[channel]].request );
+        next[channel]++;
+    }
+
+    for( ncounter_t i = 0; i < channelCompletions.size( ); i++ )
+        channelCompletions[i].clear( );
+}
+
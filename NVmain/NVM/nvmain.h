@@ -80,16 +80,32 @@ class NVMain : public NVMObject
 
     void EnqueuePendingMemoryRequests( NVMainRequest *request );
 
+    bool RequestDataNeeded( );
+
+    void DeliverChannelCompletions( void *data );
+
   private:
+    struct ChannelCompletion
+    {
+        ncycle_t cycle;
+        NVMainRequest *request;
+    };
+
     Config *config;
     Config **channelConfig;
     MemoryController **memoryControllers;
+    EventQueue **channelQueues;
+    std::vector< std::vector<ChannelCompletion> > channelCompletions;
+    bool parallelChannels;
+    bool channelDataNeeded;
     AddressTranslator *translator;
 
     ncounter_t totalReadRequests;
     ncounter_t totalWriteRequests;
     ncounter_t successfulPrefetches;
     ncounter_t unsuccessfulPrefetches;
+    ncounter_t requestAllocations;
+    ncounter_t requestHeapAllocations;
 
     unsigned int numChannels;
     double syncValue;
@@ -102,6 +118,8 @@ class NVMain : public NVMObject
     GenericTraceWriter *preTracer;
 
     void PrintPreTrace( NVMainRequest *request );
+    bool ParallelChannelsSupported( int channels );
+    bool ChannelDataNeeded( Config *conf );
     void GeneratePrefetches( NVMainRequest *request, std::vector<NVMAddress>& prefetchList );
 };
 
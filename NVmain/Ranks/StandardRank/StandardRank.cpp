@@ -190,7 +190,7 @@ void StandardRank::SetConfig( Config *c, bool createChildren )
 
 void StandardRank::RegisterStats( )
 {
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         AddUnitStat(totalEnergy, "mA*t");
         AddUnitStat(backgroundEnergy, "mA*t");
@@ -590,7 +590,7 @@ bool StandardRank::Refresh( NVMainRequest *request )
 
     state = STANDARDRANK_REFRESHING;
 
-    request->owner = this;
+    /* the request is handed back to its owner by RequestComplete() */
     GetEventQueue( )->InsertEvent( EventResponse, this, request, 
         GetEventQueue()->GetCurrentCycle() + p->tRFC );
 
@@ -852,7 +852,10 @@ void StandardRank::Notify( NVMainRequest *request )
 
 bool StandardRank::RequestComplete( NVMainRequest* req )
 {
-    if( req->owner == this )
+    /* Refreshes are returned to the memory controller that issued them. */
+    bool returnToOwner = ( req->owner != this && req->type == REFRESH );
+
+    if( req->owner == this || returnToOwner )
     {
         switch( req->type )
         {
@@ -873,6 +876,9 @@ bool StandardRank::RequestComplete( NVMainRequest* req )
                 break;
         }
 
+        if( returnToOwner )
+            return req->owner->RequestComplete( req );
+
         delete req;
         return true;
     }
@@ -891,7 +897,7 @@ void StandardRank::Cycle( ncycle_t steps )
         /* active powerdown */
         case STANDARDRANK_PDA:
             fastExitActiveCycles += steps;
-            if( p->EnergyModel == "current" )
+            if( p->energyModel == EnergyModel_Current )
                 backgroundEnergy += ( p->EIDD3P * (double)steps ) * (double)deviceCount;  
             else
                 backgroundEnergy += ( p->Epda * (double)steps );  
@@ -900,7 +906,7 @@ void StandardRank::Cycle( ncycle_t steps )
         /* precharge powerdown fast exit */
         case STANDARDRANK_PDPF:
             fastExitPrechargeCycles += steps;
-            if( p->EnergyModel == "current" )
+            if( p->energyModel == EnergyModel_Current )
                 backgroundEnergy += ( p->EIDD2P1 * (double)steps ) * (double)deviceCount;
             else 
                 backgroundEnergy += ( p->Epdpf * (double)steps );  
@@ -909,7 +915,7 @@ void StandardRank::Cycle( ncycle_t steps )
         /* precharge powerdown slow exit */
         case STANDARDRANK_PDPS:
             slowExitCycles += steps;
-            if( p->EnergyModel == "current" )
+            if( p->energyModel == EnergyModel_Current )
                 backgroundEnergy += ( p->EIDD2P0 * (double)steps ) * (double)deviceCount;  
             else 
                 backgroundEnergy += ( p->Epdps * (double)steps );  
@@ -919,7 +925,7 @@ void StandardRank::Cycle( ncycle_t steps )
         case STANDARDRANK_REFRESHING:
         case STANDARDRANK_OPEN:
             activeCycles += steps;
-            if( p->EnergyModel == "current" )
+            if( p->energyModel == EnergyModel_Current )
                 backgroundEnergy += ( p->EIDD3N * (double)steps ) * (double)deviceCount;  
             else
                 backgroundEnergy += ( p->Eactstdby * (double)steps );  
@@ -928,14 +934,14 @@ void StandardRank::Cycle( ncycle_t steps )
         /* precharge standby */
         case STANDARDRANK_CLOSED:
             standbyCycles += steps;
-            if( p->EnergyModel == "current" )
+            if( p->energyModel == EnergyModel_Current )
                 backgroundEnergy += ( p->EIDD2N * (double)steps ) * (double)deviceCount;  
             else
                 backgroundEnergy += ( p->Eprestdby * (double)steps );  
             break;
 
         default:
-            if( p->EnergyModel == "current" )
+            if( p->energyModel == EnergyModel_Current )
                 backgroundEnergy += ( p->EIDD2N * (double)steps ) * (double)deviceCount;  
             else
                 backgroundEnergy += ( p->Eprestdby * (double)steps );  
@@ -974,7 +980,7 @@ void StandardRank::CalculateStats( )
     /* Get simulation time in nanoseconds (ns). Since energy is in nJ, energy / ns = W */
     double simulationTime = 1.0;
     
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         simulationTime = GetEventQueue()->GetCurrentCycle() - lastReset;
     }
@@ -987,7 +993,7 @@ void StandardRank::CalculateStats( )
     if( simulationTime != 0 )
     {
         /* power in W */
-        if( p->EnergyModel == "current" )
+        if( p->energyModel == EnergyModel_Current )
         {
             backgroundPower = ( backgroundEnergy / (double)deviceCount * p->Voltage ) / (double)simulationTime / 1000.0; 
             activatePower = ( activateEnergy * p->Voltage ) / (double)simulationTime / 1000.0; 
@@ -1004,7 +1010,7 @@ void StandardRank::CalculateStats( )
     }
 
     /* Current mode is measured on a per-device basis. */
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         /* energy breakdown. device is in lockstep within a rank */
         activateEnergy *= (double)deviceCount;
@@ -0,0 +1,148 @@
+#!/usr/bin/python
+
+#
+# Converts an NVMain text trace (NVMV0 or NVMV1) into the binary trace
+# format read by the NVMainBinaryTrace trace reader. See
+# traceReader/NVMainBinaryTrace/NVMainBinaryTrace.h for the layout.
+#
+# Usage: NVMainTraceToBinary.py -i trace.nvt -o trace.nvb
+#
+
+from optparse import OptionParser
+import binascii
+import struct
+import sys
+
+
+NVMB_VERSION = 1
+NVMB_HAS_DATA = 0x1
+NVMB_HAS_OLD_DATA = 0x2
+
+NVMB_OP_WRITE = 0x1
+NVMB_DATA = 0x2
+NVMB_OLD_DATA = 0x4
+NVMB_THREAD = 0x8
+
+MASK64 = (1 << 64) - 1
+
+
+def zigzag(delta):
+    # Deltas wrap around at 64 bits like the C++ reader and writer.
+    delta &= MASK64
+    if delta >> 63:
+        delta -= 1 << 64
+    return ((delta << 1) ^ (delta >> 63)) & MASK64
+
+
+def varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return out
+
+
+parser = OptionParser()
+parser.add_option("-i", "--input", help="NVMain text trace to read")
+parser.add_option("-o", "--output", help="Binary trace to write")
+parser.add_option("-l", "--line-size", type="int", default=64, help="Data line size in bytes (default 64)")
+
+(options, args) = parser.parse_args()
+
+if not options.input or not options.output:
+    parser.print_help()
+    sys.exit(1)
+
+lineSize = options.line_size
+zeroLine = bytes(bytearray(lineSize))
+
+infile = open(options.input, 'r')
+outfile = open(options.output, 'wb')
+
+
+def write_header(flags):
+    outfile.write(b'NVMB')
+    outfile.write(struct.pack('<HHII', NVMB_VERSION, flags, lineSize, 0))
+
+
+# The flags are rewritten once we know whether the trace has data.
+flags = 0
+write_header(flags)
+
+# Like the text reader, the first line is always taken as the version line.
+firstLine = infile.readline()
+traceVersion = 0
+if firstLine[0:4] == "NVMV":
+    traceVersion = int(firstLine[4:].strip() or 0)
+
+lastCycle = 0
+lastAddress = 0
+lastThreadId = 0
+records = 0
+
+for line in infile:
+    fields = line.split()
+    if len(fields) < 3:
+        continue
+
+    cycle = int(fields[0])
+    address = int(fields[2], 16)
+    data = zeroLine
+    oldData = zeroLine
+    threadId = 0
+    tag = 0
+
+    if fields[1] == "W":
+        tag |= NVMB_OP_WRITE
+    elif fields[1] != "R":
+        print("Warning: Unknown operation `%s' on line %d, converting it to a read." % (fields[1], records + 2))
+
+    # The thread ID is always last. Traces written without data have no data fields.
+    if len(fields) > 3:
+        threadId = int(fields[-1])
+
+    payloads = fields[3:-1]
+    if len(payloads) > 0:
+        data = binascii.unhexlify(payloads[0])
+        flags |= NVMB_HAS_DATA
+        if traceVersion == 0:
+            flags |= NVMB_HAS_OLD_DATA
+    if len(payloads) > 1 and traceVersion != 0:
+        oldData = binascii.unhexlify(payloads[1])
+        flags |= NVMB_HAS_OLD_DATA
+
+    if len(data) != lineSize or len(oldData) != lineSize:
+        print("Error: Data on line %d is not %d bytes." % (records + 2, lineSize))
+        sys.exit(1)
+
+    record = bytearray()
+    record += varint(zigzag(cycle - lastCycle))
+    record += varint(zigzag(address - lastAddress))
+
+    if threadId != lastThreadId:
+        tag |= NVMB_THREAD
+        record += varint(threadId)
+
+    if data != zeroLine:
+        tag |= NVMB_DATA
+        record += data
+    if oldData != zeroLine:
+        tag |= NVMB_OLD_DATA
+        record += oldData
+
+    outfile.write(bytes(bytearray([tag])))
+    outfile.write(bytes(record))
+
+    lastCycle = cycle
+    lastAddress = address
+    lastThreadId = threadId
+    records = records + 1
+
+outfile.seek(0)
+write_header(flags)
+
+infile.close()
+outfile.close()
+
+print("Wrote %d accesses to %s" % (records, options.output))
@@ -45,6 +45,7 @@
 #include "SimInterface/Gem5Interface/Gem5Interface.h"
 #include "Simulators/gem5/nvmain_mem.hh"
 #include "Utils/HookFactory.h"
+#include "src/EventQueueFactory.h"
 
 #include "base/random.hh"
 #include "base/statistics.hh"
@@ -95,6 +96,7 @@ NVMainMemory::NVMainMemory(const Params *p)
     retryWrite = false;
     retryResp = false;
     m_requests_outstanding = 0;
+    m_requestData = true;
 
     /*
      * Modified by Tao @ 01/22/2013
@@ -118,6 +120,9 @@ NVMainMemory::NVMainMemory(const Params *p)
    tBURST = m_nvmainConfig->GetValue( "tBURST" );
    RATE = m_nvmainConfig->GetValue( "RATE" );
 
+   if( m_nvmainConfig->KeyExists( "CheckpointDirectory" ) )
+       m_checkpointDirectory = m_nvmainConfig->GetString( "CheckpointDirectory" );
+
    lastWakeup = curTick();
 }
 
@@ -144,7 +149,7 @@ NVMainMemory::init()
         m_nvmainPtr = new NVM::NVMain( );
         m_statsPtr = new NVM::Stats( );
         m_nvmainSimInterface = new NVM::Gem5Interface( );
-        m_nvmainEventQueue = new NVM::EventQueue( );
+        m_nvmainEventQueue = NVM::EventQueueFactory::CreateEventQueue( m_nvmainConfig );
         m_nvmainGlobalEventQueue = new NVM::GlobalEventQueue( );
         m_tagGenerator = new NVM::TagGenerator( 1000 );
 
@@ -159,6 +164,13 @@ NVMainMemory::init()
                                          std::ofstream::out | std::ofstream::app );
         }
 
+        if( m_nvmainConfig->KeyExists( "StatsFormat" )
+            && !m_statsPtr->SetFormat( m_nvmainConfig->GetString( "StatsFormat" ) ) )
+        {
+            std::cout << "NVMain: Unknown StatsFormat `" << m_nvmainConfig->GetString( "StatsFormat" )
+                      << "', printing stats as text." << std::endl;
+        }
+
         statPrinter.memory = this;
         statPrinter.forgdb = this;
 
@@ -203,6 +215,14 @@ NVMainMemory::init()
         m_nvmainGlobalEventQueue->AddSystem( m_nvmainPtr, m_nvmainConfig );
         m_nvmainPtr->SetConfig( m_nvmainConfig );
 
+        /* Only copy data from the backing store if some model looks at it. */
+        m_requestData = m_nvmainPtr->RequestDataNeeded( )
+                        || !GetHooks( NVMHOOK_PREISSUE ).empty( )
+                        || !GetHooks( NVMHOOK_POSTISSUE ).empty( );
+
+        if( !m_requestData )
+            std::cout << "NVMainMemory: No model uses request data, requests will carry none." << std::endl;
+
         masterInstance->allInstances.push_back(this);
     }
     else
@@ -294,53 +314,36 @@ AddrRangeList NVMainMemory::MemoryPort::getAddrRanges() const
 void
 NVMainMemory::SetRequestData(NVMainRequest *request, PacketPtr pkt)
 {
-    uint8_t *hostAddr;
-
-    request->data.SetSize( pkt->getSize() );
-    request->oldData.SetSize( pkt->getSize() );
-
-    if (pkt->isRead())
-    {
-	const RequestPtr dataReq = std::make_shared<Request>(pkt->getAddr(), pkt->getSize(), 0, Request::funcMasterId);
-        Packet *dataPkt = new Packet(dataReq, MemCmd::ReadReq);
-        dataPkt->allocate();
-        doFunctionalAccess(dataPkt);
+    if( !masterInstance->m_requestData )
+        return;
 
-        hostAddr = new uint8_t[ pkt->getSize() ];
-        memcpy( hostAddr, dataPkt->getPtr<uint8_t>(), pkt->getSize() );
+    unsigned size = pkt->getSize();
 
-        for(int i = 0; i < pkt->getSize(); i++ )
-        {
-            request->oldData.SetByte(i, *(hostAddr + i));
-            request->data.SetByte(i, *(hostAddr + i));
-        }
+    request->data.SetSize( size );
+    request->oldData.SetSize( size );
 
-        delete dataPkt;
-        delete [] hostAddr;
+    /*
+     *  The old data is whatever the backing store holds before the packet
+     *  is applied, which is also the data of a read. Copy it straight from
+     *  the host memory into the request's buffers.
+     */
+    if( pmemAddr != NULL )
+    {
+        memcpy( request->oldData.rawData, toHostAddr( pkt->getAddr() ), size );
     }
     else
     {
-	const RequestPtr dataReq = std::make_shared<Request>(pkt->getAddr(), pkt->getSize(), 0, Request::funcMasterId);
-        Packet *dataPkt = new Packet(dataReq, MemCmd::ReadReq);
-        dataPkt->allocate();
-        doFunctionalAccess(dataPkt);
-
-        uint8_t *hostAddrT = new uint8_t[ pkt->getSize() ];
-        memcpy( hostAddrT, dataPkt->getPtr<uint8_t>(), pkt->getSize() );
-
-        hostAddr = new uint8_t[ pkt->getSize() ];
-        memcpy( hostAddr, pkt->getPtr<uint8_t>(), pkt->getSize() );
-
-        for(int i = 0; i < pkt->getSize(); i++ )
-        {
-            request->oldData.SetByte(i, *(hostAddrT + i));
-            request->data.SetByte(i, *(hostAddr + i));
-        }
+        const RequestPtr dataReq = std::make_shared<Request>(pkt->getAddr(), size, 0, Request::funcMasterId);
+        Packet dataPkt(dataReq, MemCmd::ReadReq);
 
-        delete dataPkt;
-        delete [] hostAddrT;
-        delete [] hostAddr;
+        dataPkt.dataStatic( request->oldData.rawData );
+        doFunctionalAccess( &dataPkt );
     }
+
+    if (pkt->isRead())
+        memcpy( request->data.rawData, request->oldData.rawData, size );
+    else
+        memcpy( request->data.rawData, pkt->getConstPtr<uint8_t>(), size );
 }
 
 
@@ -438,9 +441,7 @@ NVMainMemory::MemoryPort::recvTimingReq(PacketPtr pkt)
 
             pkt->headerDelay = pkt->payloadDelay = 0;
 
-            memory.responseQueue.push_back(pkt);
-
-            memory.ScheduleResponse( );
+            memory.QueueResponse(pkt);
         } else {
             memory.pendingDelete.push_back(pkt);
         }
@@ -561,8 +562,8 @@ NVMainMemory::MemoryPort::recvTimingReq(PacketPtr pkt)
             memory.ScheduleClockEvent( nextWake );
         }
 
-        memory.masterInstance->m_request_map.insert( std::pair<NVMainRequest *, NVMainMemoryRequest *>( request, memRequest ) );
-        memory.m_requests_outstanding++;
+        request->reqInfo = static_cast<void *>( memRequest );
+        memory.masterInstance->m_requests_outstanding++;
 
         /*
          *  It seems gem5 will block until the packet gets a response, so create a copy of the request, so
@@ -572,16 +573,19 @@ NVMainMemory::MemoryPort::recvTimingReq(PacketPtr pkt)
         {
             NVMainMemoryRequest *requestCopy = new NVMainMemoryRequest( );
 
+            /* Completing the copy only needs to know what and whose it was, not the data. */
             requestCopy->request = new NVMainRequest( );
-            *(requestCopy->request) = *request;
+            requestCopy->request->type = request->type;
+            requestCopy->request->address = request->address;
+            requestCopy->request->owner = request->owner;
             requestCopy->packet = pkt;
             requestCopy->issueTick = curTick();
             requestCopy->atomic = false;
 
             memRequest->packet = NULL;
 
-            memory.masterInstance->m_request_map.insert( std::pair<NVMainRequest *, NVMainMemoryRequest *>( requestCopy->request, requestCopy ) );
-            memory.m_requests_outstanding++;
+            requestCopy->request->reqInfo = static_cast<void *>( requestCopy );
+            memory.masterInstance->m_requests_outstanding++;
 
             memory.RequestComplete( requestCopy->request );
         }
@@ -610,6 +614,9 @@ NVMainMemory::MemoryPort::recvTimingReq(PacketPtr pkt)
             memory.retryWrite = true;
         }
 
+        /* Completions only need to wake the ports that were turned away. */
+        memory.masterInstance->blockedInstances.push_back(&memory);
+
         delete request;
         request = NULL;
     }
@@ -635,7 +642,7 @@ void NVMainMemory::doFunctionalAccess(PacketPtr pkt)
 
 DrainState NVMainMemory::drain()
 {
-    if( !masterInstance->m_request_map.empty() )
+    if( masterInstance->m_requests_outstanding != 0 )
     {
         return DrainState::Draining;
     }
@@ -680,13 +687,11 @@ bool NVMainMemory::RequestComplete(NVM::NVMainRequest *req)
         return true;
     }
 
-    NVMainMemoryRequest *memRequest;
-    std::map<NVMainRequest *, NVMainMemoryRequest *>::iterator iter;
+    NVMainMemoryRequest *memRequest = static_cast<NVMainMemoryRequest *>( req->reqInfo );
+    assert(memRequest != NULL && memRequest->request == req);
 
-    // Find the mem request pointer in the map.
-    assert(masterInstance->m_request_map.count(req) != 0);
-    iter = masterInstance->m_request_map.find(req);
-    memRequest = iter->second;
+    assert(masterInstance->m_requests_outstanding > 0);
+    masterInstance->m_requests_outstanding--;
 
     if(!memRequest->atomic)
     {
@@ -701,16 +706,16 @@ bool NVMainMemory::RequestComplete(NVM::NVMainRequest *req)
             ownerInstance->access(memRequest->packet);
         }
 
-        for( auto retryIter = masterInstance->allInstances.begin(); 
-             retryIter != masterInstance->allInstances.end(); retryIter++ )
+        if( (isRead || isWrite) && !masterInstance->blockedInstances.empty() )
         {
-            if( (*retryIter)->retryRead && (isRead || isWrite) )
+            /* A retried port may be turned away again and block anew. */
+            std::vector<NVMainMemory *> retryInstances;
+            retryInstances.swap( masterInstance->blockedInstances );
+
+            for( auto retryIter = retryInstances.begin(); 
+                 retryIter != retryInstances.end(); retryIter++ )
             {
                 (*retryIter)->retryRead = false;
-                (*retryIter)->port.sendRetryReq();
-            }
-            if( (*retryIter)->retryWrite && (isRead || isWrite) )
-            {
                 (*retryIter)->retryWrite = false;
                 (*retryIter)->port.sendRetryReq();
             }
@@ -720,8 +725,7 @@ bool NVMainMemory::RequestComplete(NVM::NVMainRequest *req)
 
         if(respond)
         {
-            ownerInstance->responseQueue.push_back(memRequest->packet);
-            ownerInstance->ScheduleResponse( );
+            ownerInstance->QueueResponse(memRequest->packet);
 
             delete req;
             delete memRequest;
@@ -744,46 +748,42 @@ bool NVMainMemory::RequestComplete(NVM::NVMainRequest *req)
     }
 
 
-    masterInstance->m_request_map.erase(iter);
-    //assert(m_requests_outstanding > 0);
-    m_requests_outstanding--;
-
     return true;
 }
 
 
 void NVMainMemory::SendResponses( )
 {
-    if( responseQueue.empty() || retryResp == true )
+    if( retryResp == true )
         return;
 
+    /* Send every response that is due now in one go. */
+    while( !responseQueue.empty() && responseQueue.front().readyTick <= curTick() )
+    {
+        if( !port.sendTimingResp( responseQueue.front().packet ) )
+        {
+            DPRINTF(NVMain, "NVMainMemory: Retrying response.\n");
+            DPRINTF(NVMainMin, "NVMainMemory: Retrying response.\n");
 
-    bool success = port.sendTimingResp( responseQueue.front() );
+            retryResp = true;
+            return;
+        }
 
-    if( success )
-    {
         DPRINTF(NVMain, "NVMainMemory: Sending response.\n");
 
         responseQueue.pop_front( );
-
-        if( !responseQueue.empty( ) )
-            ScheduleResponse( );
-
-        CheckDrainState( );
     }
-    else
-    {
-        DPRINTF(NVMain, "NVMainMemory: Retrying response.\n");
-        DPRINTF(NVMainMin, "NVMainMemory: Retrying response.\n");
 
-        retryResp = true;
-    }
+    if( !responseQueue.empty( ) )
+        ScheduleResponse( );
+
+    CheckDrainState( );
 }
 
 
 void NVMainMemory::CheckDrainState( )
 {
-    if( drainManager != NULL && masterInstance->m_request_map.empty() )
+    if( drainManager != NULL && masterInstance->m_requests_outstanding == 0 )
     {
         DPRINTF(NVMain, "NVMainMemory: Drain completed.\n");
         DPRINTF(NVMainMin, "NVMainMemory: Drain completed.\n");
@@ -794,10 +794,23 @@ void NVMainMemory::CheckDrainState( )
 }
 
 
+void NVMainMemory::QueueResponse( PacketPtr pkt )
+{
+    NVMainMemoryResponse response;
+
+    response.packet = pkt;
+    response.readyTick = curTick() + clock;
+
+    responseQueue.push_back( response );
+
+    ScheduleResponse( );
+}
+
+
 void NVMainMemory::ScheduleResponse( )
 {
-    if( !respondEvent.scheduled( ) )
-        schedule(respondEvent, curTick() + clock);
+    if( !respondEvent.scheduled( ) && !responseQueue.empty( ) )
+        schedule(respondEvent, std::max( curTick(), responseQueue.front().readyTick ));
 }
 
 
@@ -815,10 +828,7 @@ void NVMainMemory::serialize(CheckpointOut &cp) const
     if (masterInstance != this)
         return;
 
-    std::string nvmain_chkpt_dir = "";
-
-    if( m_nvmainConfig->KeyExists( "CheckpointDirectory" ) )
-        nvmain_chkpt_dir = m_nvmainConfig->GetString( "CheckpointDirectory" );
+    std::string nvmain_chkpt_dir = m_checkpointDirectory;
 
     if( nvmain_chkpt_dir != "" )
     {
@@ -834,10 +844,7 @@ void NVMainMemory::unserialize(CheckpointIn &cp)
     if (masterInstance != this)
         return;
 
-    std::string nvmain_chkpt_dir = "";
-
-    if( m_nvmainConfig->KeyExists( "CheckpointDirectory" ) )
-        nvmain_chkpt_dir = m_nvmainConfig->GetString( "CheckpointDirectory" );
+    std::string nvmain_chkpt_dir = m_checkpointDirectory;
 
     if( nvmain_chkpt_dir != "" )
     {
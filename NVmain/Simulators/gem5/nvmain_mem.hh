@@ -100,6 +100,7 @@ class NVMainMemory : public AbstractMemory, public NVM::NVMObject
     EventWrapper<NVMainMemory, &NVMainMemory::SendResponses> respondEvent;
 
     void CheckDrainState( );
+    void QueueResponse( PacketPtr pkt );
     void ScheduleResponse( );
     void ScheduleClockEvent( Tick );
     void SetRequestData(NVM::NVMainRequest *request, PacketPtr pkt);
@@ -126,6 +127,7 @@ class NVMainMemory : public AbstractMemory, public NVM::NVMObject
         NVM::NVMain *nvmainPtr;
     };
 
+    /* Carried in the reqInfo of each request sent to NVMain. */
     struct NVMainMemoryRequest
     {
         PacketPtr packet;
@@ -134,6 +136,12 @@ class NVMainMemory : public AbstractMemory, public NVM::NVMObject
         bool atomic;
     };
 
+    struct NVMainMemoryResponse
+    {
+        PacketPtr packet;
+        Tick readyTick;
+    };
+
     DrainManager *drainManager;
 
     NVM::NVMain *m_nvmainPtr;
@@ -159,6 +167,9 @@ class NVMainMemory : public AbstractMemory, public NVM::NVMObject
     uint64_t tBURST;
     uint64_t RATE;
 
+    /* Read up front, the config is sealed once NVMain is configured. */
+    std::string m_checkpointDirectory;
+
     bool NVMainWarmUp;
 
     NVMainStatPrinter statPrinter;
@@ -166,6 +177,7 @@ class NVMainMemory : public AbstractMemory, public NVM::NVMObject
     Tick lastWakeup;
 
     uint64_t m_requests_outstanding;
+    bool m_requestData;
 
   public:
 
@@ -199,10 +211,10 @@ class NVMainMemory : public AbstractMemory, public NVM::NVMObject
     static NVMainMemory *masterInstance;
     NVMainMemory *otherInstance;
     std::vector<NVMainMemory *> allInstances;
+    std::vector<NVMainMemory *> blockedInstances;
     bool retryRead, retryWrite, retryResp;
-    std::deque<PacketPtr> responseQueue;
+    std::deque<NVMainMemoryResponse> responseQueue;
     std::vector<PacketPtr> pendingDelete;
-    std::map<NVM::NVMainRequest *, NVMainMemoryRequest *> m_request_map;
 
   protected:
 
@@ -0,0 +1,249 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+
+/*
+ *  Microbenchmark for physical address decoding. The translation method
+ *  for the memory system described by a config file is set up the same
+ *  way NVMain does, then a set of random addresses is decoded with the
+ *  precomputed shift/mask tables in AddressTranslator and with the old
+ *  loop which looked up the order, width and bus offset of every field on
+ *  each call. The results are checked against each other before timing,
+ *  and ReverseTranslate() is checked to undo Translate() with the bank and
+ *  channel XOR hashing enabled.
+ *
+ *  Usage: AddressTranslatorBenchmark CONFIG_FILE [ADDRESSES] [PARAM=value ...]
+ *  e.g.,  AddressTranslatorBenchmark Config/2D_DRAM_example.config 1000000
+ */
+
+#include "src/AddressTranslator.h"
+#include "src/Config.h"
+#include "src/TranslationMethod.h"
+#include "include/NVMHelpers.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace NVM;
+
+namespace {
+
+/* The decode loop used by AddressTranslator before it built shift/mask tables. */
+class LoopTranslator : public AddressTranslator
+{
+  public:
+    void Translate( uint64_t address, uint64_t *row, uint64_t *col, uint64_t *bank,
+                    uint64_t *rank, uint64_t *channel, uint64_t *subarray )
+    {
+        uint64_t refAddress;
+        MemoryPartition part;
+
+        uint64_t *partitions[6] = { row, col, bank, rank, channel, subarray };
+
+        int busOffsetBits = mlog2( 64 / 8 );
+        int burstBits = mlog2( (64 * 8) / 8 );
+        int lowColBits = burstBits - busOffsetBits;
+
+        refAddress = address >> busOffsetBits;
+        refAddress >>= lowColBits;
+
+        for( int i = 0; i < 6; i++ )
+        {
+            FindOrder( i, &part );
+
+            *partitions[part] = Modulo( refAddress, part );
+            refAddress = Divide( refAddress, part );
+        }
+    }
+
+    using AddressTranslator::Translate;
+};
+
+TranslationMethod *CreateMethod( Config *config )
+{
+    uint64_t rows, subarrays;
+
+    if( config->KeyExists( "MATHeight" ) )
+    {
+        rows = config->GetValue( "MATHeight" );
+        subarrays = config->GetValue( "ROWS" ) / rows;
+    }
+    else
+    {
+        rows = config->GetValue( "ROWS" );
+        subarrays = 1;
+    }
+
+    uint64_t cols = config->GetValue( "COLS" );
+    uint64_t banks = config->GetValue( "BANKS" );
+    uint64_t ranks = config->GetValue( "RANKS" );
+    uint64_t channels = config->GetValue( "CHANNELS" );
+
+    TranslationMethod *method = new TranslationMethod( );
+
+    method->SetBitWidths( mlog2( rows ), mlog2( cols ), mlog2( banks ),
+                          mlog2( ranks ), mlog2( channels ), mlog2( subarrays ) );
+    method->SetCount( rows, cols, banks, ranks, channels, subarrays );
+    method->SetAddressMappingScheme( config->GetString( "AddressMappingScheme" ) );
+
+    return method;
+}
+
+double RunBenchmark( AddressTranslator *translator, std::vector<uint64_t>& addresses,
+                     uint64_t& checksum )
+{
+    uint64_t row, col, bank, rank, channel, subarray;
+
+    checksum = 0;
+
+    clock_t start = clock( );
+
+    for( size_t i = 0; i < addresses.size( ); i++ )
+    {
+        translator->Translate( addresses[i], &row, &col, &bank, &rank, &channel, &subarray );
+        checksum += row + col + bank + rank + channel + subarray;
+    }
+
+    clock_t end = clock( );
+
+    return static_cast<double>(end - start) / CLOCKS_PER_SEC;
+}
+
+};
+
+int main( int argc, char *argv[] )
+{
+    if( argc < 2 )
+    {
+        std::cout << "Usage: AddressTranslatorBenchmark CONFIG_FILE [ADDRESSES] [PARAM=value ...]"
+                  << std::endl;
+        return 1;
+    }
+
+    uint64_t count = 1000000;
+    Config *config = new Config( );
+
+    config->Read( argv[1] );
+
+    if( argc > 2 )
+        count = strtoull( argv[2], NULL, 10 );
+
+    for( int curArg = 3; curArg < argc; ++curArg )
+    {
+        std::string clPair = argv[curArg];
+        std::string clParam = clPair.substr( 0, clPair.find_first_of("=") );
+        std::string clValue = clPair.substr( clPair.find_first_of("=") + 1, std::string::npos );
+
+        config->SetValue( clParam, clValue );
+    }
+
+    TranslationMethod *method = CreateMethod( config );
+
+    /* The hashed decoder is only used for the round trip check. */
+    Config *hashConfig = new Config( *config );
+    hashConfig->SetBool( "BankXORHash", true );
+    hashConfig->SetBool( "ChannelXORHash", true );
+
+    AddressTranslator *tableAT = new AddressTranslator( );
+    AddressTranslator *loopAT = new LoopTranslator( );
+    AddressTranslator *hashAT = new AddressTranslator( );
+
+    tableAT->SetConfig( config, false );
+    tableAT->SetTranslationMethod( method );
+    loopAT->SetTranslationMethod( method );
+    hashAT->SetConfig( hashConfig, false );
+    hashAT->SetTranslationMethod( method );
+
+    std::vector<uint64_t> addresses( count );
+
+    srand( 1 );
+    for( uint64_t i = 0; i < count; i++ )
+    {
+        uint64_t address = (static_cast<uint64_t>( rand( ) ) << 32) ^ rand( );
+
+        /* Cacheline aligned addresses anywhere in a 1TB space. */
+        addresses[i] = address & ((uint64_t(1) << 40) - 1) & ~uint64_t(63);
+    }
+
+    /* Sanity check the decoders before timing anything. */
+    for( uint64_t i = 0; i < count; i++ )
+    {
+        uint64_t tableFields[6], loopFields[6], hashFields[6];
+
+        tableAT->Translate( addresses[i], &tableFields[0], &tableFields[1], &tableFields[2],
+                            &tableFields[3], &tableFields[4], &tableFields[5] );
+        loopAT->Translate( addresses[i], &loopFields[0], &loopFields[1], &loopFields[2],
+                           &loopFields[3], &loopFields[4], &loopFields[5] );
+
+        for( int field = 0; field < 6; field++ )
+        {
+            if( tableFields[field] != loopFields[field] )
+            {
+                std::cout << "ERROR: Decoders differ for address 0x" << std::hex 
+                          << addresses[i] << std::dec << std::endl;
+                return 1;
+            }
+        }
+
+        hashAT->Translate( addresses[i], &hashFields[0], &hashFields[1], &hashFields[2],
+                           &hashFields[3], &hashFields[4], &hashFields[5] );
+
+        if( hashAT->ReverseTranslate( hashFields[0], hashFields[1], hashFields[2], 
+                                      hashFields[3], hashFields[4], hashFields[5] )
+            != tableAT->ReverseTranslate( tableFields[0], tableFields[1], tableFields[2],
+                                          tableFields[3], tableFields[4], tableFields[5] ) )
+        {
+            std::cout << "ERROR: Hashed round trip differs for address 0x" << std::hex
+                      << addresses[i] << std::dec << std::endl;
+            return 1;
+        }
+    }
+
+    uint64_t loopSum, tableSum;
+
+    std::cout << "Decoding " << count << " addresses." << std::endl;
+
+    double loopTime = RunBenchmark( loopAT, addresses, loopSum );
+    double tableTime = RunBenchmark( tableAT, addresses, tableSum );
+
+    std::cout << "Loop:    " << loopTime << " s (" 
+              << (loopTime * 1e9 / count) << " ns/address)" << std::endl;
+    std::cout << "Tables:  " << tableTime << " s (" 
+              << (tableTime * 1e9 / count) << " ns/address)" << std::endl;
+    std::cout << "Speedup: " << (loopTime / tableTime) << "x" << std::endl;
+
+    return (loopSum == tableSum) ? 0 : 1;
+}
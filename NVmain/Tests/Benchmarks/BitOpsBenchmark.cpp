@@ -0,0 +1,332 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+/*
+ *  Microbenchmark for the bit counting kernels in NVMBitOps. A set of random
+ *  data blocks is counted the way SubArray, FlipNWrite and the endurance
+ *  models used to (32-bit popcounts run once per cell value, and bit by bit
+ *  walks of each byte) and with each kernel this CPU supports. The results
+ *  are checked against each other before timing.
+ *
+ *  Usage: BitOpsBenchmark [BLOCKS] [BLOCK_BYTES]
+ *  e.g.,  BitOpsBenchmark 100000 64
+ */
+
+#include "include/NVMBitOps.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace NVM;
+
+namespace {
+
+const uint64_t flipPartitionBits = 32;
+
+/* Counting used by SubArray before the kernels existed. */
+uint64_t OldCount32( uint32_t data )
+{
+    uint32_t count = data;
+    count = count - ((count >> 1) & 0x55555555);
+    count = (count & 0x33333333) + ((count >> 2) & 0x33333333);
+    count = (((count + (count >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+
+    return count;
+}
+
+uint64_t OldCountMLC1( uint8_t value, const uint32_t *data, uint64_t words )
+{
+    uint64_t count = 0;
+
+    for( uint64_t i = 0; i < words; i++ )
+        count += OldCount32( data[i] );
+
+    return (value == 1) ? count : (words * 32 - count);
+}
+
+uint64_t OldCountMLC2( uint8_t value, const uint32_t *data, uint64_t words )
+{
+    uint64_t count = 0;
+
+    for( uint64_t i = 0; i < words; i++ )
+    {
+        uint32_t word = data[i];
+
+        if( value == 0 )
+            word ^= 0xFFFFFFFF;
+        else if( value == 1 )
+            word ^= 0xAAAAAAAA;
+        else if( value == 2 )
+            word ^= 0x55555555;
+
+        count += OldCount32( (word & 0x55555555) & ((word & 0xAAAAAAAA) >> 1) );
+    }
+
+    return count;
+}
+
+/* Bit by bit walk used by FlipNWrite and BitModel. */
+void OldDiffWalk( const uint8_t *a, const uint8_t *b, uint64_t bytes, 
+                  uint64_t *partitions, uint64_t& keySum )
+{
+    for( uint64_t i = 0; i < bytes; i++ )
+    {
+        if( a[i] == b[i] )
+            continue;
+
+        for( int j = 0; j < 8; j++ )
+        {
+            if( ((a[i] >> j) & 0x1) != ((b[i] >> j) & 0x1) )
+            {
+                partitions[(i * 8 + j) / flipPartitionBits]++;
+                keySum += i * 8 + j;
+            }
+        }
+    }
+}
+
+struct Results
+{
+    uint64_t ones;
+    uint64_t states[4];
+    uint64_t diffs;
+    uint64_t partitionSum;
+    uint64_t keySum;
+};
+
+double RunOld( std::vector<uint8_t>& data, uint64_t blocks, uint64_t blockBytes, Results& r )
+{
+    std::vector<uint64_t> partitions( (blockBytes * 8) / flipPartitionBits );
+    uint64_t words = blockBytes / 4;
+
+    r = Results( );
+
+    clock_t start = clock( );
+
+    for( uint64_t i = 0; i + 1 < blocks; i++ )
+    {
+        const uint32_t *block = reinterpret_cast<const uint32_t *>(&data[i * blockBytes]);
+
+        r.ones += OldCountMLC1( 1, block, words );
+        r.states[0] += OldCountMLC1( 0, block, words );
+
+        for( uint8_t value = 0; value < 4; value++ )
+            r.states[value] += OldCountMLC2( value, block, words );
+
+        for( size_t p = 0; p < partitions.size( ); p++ )
+            partitions[p] = 0;
+
+        OldDiffWalk( &data[i * blockBytes], &data[(i + 1) * blockBytes], blockBytes,
+                     partitions.data( ), r.keySum );
+
+        for( size_t p = 0; p < partitions.size( ); p++ )
+        {
+            r.diffs += partitions[p];
+            r.partitionSum += partitions[p] * (p + 1);
+        }
+    }
+
+    clock_t end = clock( );
+
+    return static_cast<double>(end - start) / CLOCKS_PER_SEC;
+}
+
+double RunKernels( std::vector<uint8_t>& data, uint64_t blocks, uint64_t blockBytes, Results& r )
+{
+    std::vector<uint64_t> partitions( (blockBytes * 8) / flipPartitionBits );
+
+    r = Results( );
+
+    clock_t start = clock( );
+
+    for( uint64_t i = 0; i + 1 < blocks; i++ )
+    {
+        const uint8_t *block = &data[i * blockBytes];
+        const uint8_t *next = &data[(i + 1) * blockBytes];
+        uint64_t states[4];
+
+        uint64_t ones = CountOnes( block, blockBytes );
+        r.ones += ones;
+        r.states[0] += blockBytes * 8 - ones;
+
+        CountCellStates( block, blockBytes, states );
+        for( int value = 0; value < 4; value++ )
+            r.states[value] += states[value];
+
+        CountDiffBitsByPartition( block, next, blockBytes, flipPartitionBits, 
+                                  partitions.data( ) );
+
+        for( size_t p = 0; p < partitions.size( ); p++ )
+            r.partitionSum += partitions[p] * (p + 1);
+
+        r.diffs += CountDiffBits( block, next, blockBytes );
+
+        for( uint64_t offset = 0; offset < blockBytes; offset += 8 )
+        {
+            uint64_t changed = LoadBits64( block, offset, blockBytes ) 
+                             ^ LoadBits64( next, offset, blockBytes );
+
+            while( changed )
+            {
+                r.keySum += offset * 8 + __builtin_ctzll( changed );
+                changed &= changed - 1;
+            }
+        }
+    }
+
+    clock_t end = clock( );
+
+    return static_cast<double>(end - start) / CLOCKS_PER_SEC;
+}
+
+bool SameResults( Results& a, Results& b )
+{
+    return a.ones == b.ones && a.states[0] == b.states[0] && a.states[1] == b.states[1]
+        && a.states[2] == b.states[2] && a.states[3] == b.states[3] && a.diffs == b.diffs
+        && a.partitionSum == b.partitionSum && a.keySum == b.keySum;
+}
+
+bool CheckInvert( uint64_t blockBytes )
+{
+    std::vector<uint8_t> inverted( blockBytes ), original( blockBytes );
+
+    for( uint64_t start = 0; start < blockBytes * 8; start += 3 )
+    {
+        for( uint64_t end = start; end <= blockBytes * 8; end += 5 )
+        {
+            for( uint64_t i = 0; i < blockBytes; i++ )
+                inverted[i] = original[i] = static_cast<uint8_t>( rand( ) );
+
+            InvertBits( inverted.data( ), start, end );
+
+            for( uint64_t bit = 0; bit < blockBytes * 8; bit++ )
+            {
+                bool flipped = ((inverted[bit / 8] ^ original[bit / 8]) >> (bit % 8)) & 0x1;
+
+                if( flipped != (bit >= start && bit < end) )
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+};
+
+int main( int argc, char *argv[] )
+{
+    uint64_t blocks = 100000;
+    uint64_t blockBytes = 64;
+
+    if( argc > 1 )
+        blocks = strtoull( argv[1], NULL, 10 );
+    if( argc > 2 )
+        blockBytes = strtoull( argv[2], NULL, 10 );
+
+    if( blocks < 2 || blockBytes == 0 || blockBytes % 4 != 0 )
+    {
+        std::cout << "Usage: BitOpsBenchmark [BLOCKS] [BLOCK_BYTES]" << std::endl;
+        std::cout << "BLOCKS must be at least 2 and BLOCK_BYTES a multiple of 4." << std::endl;
+        return 1;
+    }
+
+    std::vector<uint32_t> words( (blocks * blockBytes) / 4 );
+    std::vector<uint8_t> data( blocks * blockBytes );
+
+    srand( 1 );
+    for( size_t i = 0; i < words.size( ); i++ )
+        words[i] = (static_cast<uint32_t>( rand( ) ) << 16) ^ static_cast<uint32_t>( rand( ) );
+
+    /* Sparse changes between neighbouring blocks, as between old and new data. */
+    for( size_t i = 0; i < words.size( ); i++ )
+    {
+        if( i >= blockBytes / 4 && rand( ) % 4 != 0 )
+            words[i] = words[i - blockBytes / 4] ^ (1U << (rand( ) % 32));
+    }
+
+    memcpy( data.data( ), words.data( ), data.size( ) );
+
+    if( !CheckInvert( blockBytes ) )
+    {
+        std::cout << "ERROR: InvertBits inverted the wrong bits." << std::endl;
+        return 1;
+    }
+
+    Results oldResults, kernelResults;
+    BitOpsKernel defaultKernel = GetBitOpsKernel( );
+
+    std::cout << "Counting " << blocks << " blocks of " << blockBytes << " bytes." << std::endl;
+
+    double oldTime = RunOld( data, blocks, blockBytes, oldResults );
+
+    std::cout << std::left << std::setw( 10 ) << "Old:" << oldTime << " s (" 
+              << (oldTime * 1e9 / blocks) << " ns/block)" << std::endl;
+
+    int rv = 0;
+
+    for( int kernel = BitOpsGeneric; kernel <= BitOpsAVX2; kernel++ )
+    {
+        if( !SetBitOpsKernel( static_cast<BitOpsKernel>( kernel ) ) )
+        {
+            std::cout << GetBitOpsKernelName( static_cast<BitOpsKernel>( kernel ) ) 
+                      << " is not supported on this CPU." << std::endl;
+            continue;
+        }
+
+        double kernelTime = RunKernels( data, blocks, blockBytes, kernelResults );
+
+        std::string name = GetBitOpsKernelName( static_cast<BitOpsKernel>( kernel ) );
+
+        std::cout << std::setw( 10 ) << (name + ":") << kernelTime << " s (" << (kernelTime * 1e9 / blocks) << " ns/block, "
+                  << (oldTime / kernelTime) << "x)" << std::endl;
+
+        if( !SameResults( oldResults, kernelResults ) )
+        {
+            std::cout << "ERROR: " << GetBitOpsKernelName( static_cast<BitOpsKernel>( kernel ) )
+                      << " results differ from the old code." << std::endl;
+            rv = 1;
+        }
+    }
+
+    SetBitOpsKernel( defaultKernel );
+
+    std::cout << "Default kernel: " << GetBitOpsKernelName( defaultKernel ) << std::endl;
+
+    return rv;
+}
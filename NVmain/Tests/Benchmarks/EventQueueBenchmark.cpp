@@ -0,0 +1,227 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+/*
+ *  Microbenchmark for the event queue backends. A set of objects keeps
+ *  rescheduling wakeups, responses and prioritized callbacks the same way
+ *  the memory controller and ranks/banks do (including the duplicate checks
+ *  before wakeup and callback inserts). Each backend is driven through Loop() and
+ *  Process() and the order of dispatched events is hashed so the backends
+ *  can be checked for identical scheduling.
+ *
+ *  Usage: EventQueueBenchmark [EVENTS] [OBJECTS]
+ */
+
+#include "src/EventQueue.h"
+#include "src/EventQueueFactory.h"
+#include "src/NVMObject.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace NVM;
+
+namespace {
+
+const int benchPriorities[] = { -10, 0, 10, 20, 30, 40 };
+
+class BenchObject : public NVMObject
+{
+  public:
+    BenchObject( ncounter_t id, uint64_t *hash, ncounter_t *dispatched )
+        : objectId( id ), seed( id * 2654435761ULL + 1 ), 
+          orderHash( hash ), dispatchCount( dispatched ) { }
+
+    void Cycle( ncycle_t )
+    {
+        Record( 1 );
+        Reschedule( );
+    }
+
+    bool RequestComplete( NVMainRequest * )
+    {
+        Record( 2 );
+        Reschedule( );
+        return true;
+    }
+
+    void WakeupCallback( void * )
+    {
+        Record( 3 );
+        Reschedule( );
+    }
+
+    void Reschedule( )
+    {
+        EventQueue *queue = GetEventQueue( );
+        ncycle_t now = queue->GetCurrentCycle( );
+        uint64_t r = Next( );
+
+        /* Mostly short delays, occasionally far-future events like refresh. */
+        ncycle_t delay = (r % 16 == 0) ? 3000 + (r >> 8) % 4000 : 1 + (r >> 8) % 64;
+        int priority = benchPriorities[(r >> 20) % 6];
+
+        switch( (r >> 24) % 3 )
+        {
+            case 0:
+                if( queue->FindEvent( EventCycle, this, NULL, now + delay ) == NULL )
+                    queue->InsertEvent( EventCycle, this, now + delay, NULL, priority );
+                else
+                    queue->InsertEvent( EventCycle, this, now + delay + 1 );
+                break;
+
+            case 1:
+                queue->InsertEvent( EventResponse, this, (NVMainRequest *)NULL, 
+                                    now + delay );
+                break;
+
+            default:
+                if( queue->FindCallback( this, 
+                        (CallbackPtr)&BenchObject::WakeupCallback,
+                        now + delay, NULL, priority ) == NULL )
+                {
+                    queue->InsertCallback( this, 
+                        (CallbackPtr)&BenchObject::WakeupCallback,
+                        now + delay, NULL, priority );
+                }
+                else
+                {
+                    /* Keep the object alive if the wakeup was a duplicate. */
+                    queue->InsertEvent( EventCycle, this, now + delay + 1 );
+                }
+                break;
+        }
+    }
+
+  private:
+    ncounter_t objectId;
+    uint64_t seed;
+    uint64_t *orderHash;
+    ncounter_t *dispatchCount;
+
+    uint64_t Next( )
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed >> 16;
+    }
+
+    void Record( uint64_t kind )
+    {
+        uint64_t value = (GetEventQueue( )->GetCurrentCycle( ) << 16) 
+                       ^ (objectId << 2) ^ kind;
+
+        *orderHash = (*orderHash ^ value) * 1099511628211ULL;
+        (*dispatchCount)++;
+    }
+};
+
+class BenchRoot : public NVMObject
+{
+  public:
+    void Cycle( ncycle_t ) { }
+};
+
+double RunBenchmark( std::string queueType, ncounter_t events, 
+                     ncounter_t objects, uint64_t *hash )
+{
+    EventQueue *queue = EventQueueFactory::CreateEventQueue( queueType );
+    BenchRoot *root = new BenchRoot( );
+    std::vector<BenchObject *> children;
+    ncounter_t dispatched = 0;
+
+    *hash = 14695981039346656037ULL;
+
+    root->SetEventQueue( queue );
+
+    for( ncounter_t i = 0; i < objects; i++ )
+    {
+        BenchObject *child = new BenchObject( i, hash, &dispatched );
+
+        root->AddChild( child );
+        child->SetParent( root );
+        children.push_back( child );
+    }
+
+    for( ncounter_t i = 0; i < objects; i++ )
+        children[i]->Reschedule( );
+
+    clock_t start = clock( );
+
+    while( dispatched < events )
+    {
+        queue->Loop( queue->GetNextEvent( ) - queue->GetCurrentCycle( ) );
+    }
+
+    clock_t end = clock( );
+
+    return static_cast<double>(end - start) / CLOCKS_PER_SEC;
+}
+
+};
+
+int main( int argc, char *argv[] )
+{
+    ncounter_t events = 10000000;
+    ncounter_t objects = 64;
+
+    if( argc > 1 )
+        events = strtoull( argv[1], NULL, 10 );
+    if( argc > 2 )
+        objects = strtoull( argv[2], NULL, 10 );
+
+    std::cout << "Dispatching " << events << " events across " << objects
+              << " objects." << std::endl;
+
+    uint64_t mapHash, calendarHash;
+    double mapTime = RunBenchmark( "Map", events, objects, &mapHash );
+    double calendarTime = RunBenchmark( "Calendar", events, objects, &calendarHash );
+
+    std::cout << "Map:      " << mapTime << " s (" 
+              << (events / mapTime / 1e6) << " Mevents/s)" << std::endl;
+    std::cout << "Calendar: " << calendarTime << " s (" 
+              << (events / calendarTime / 1e6) << " Mevents/s)" << std::endl;
+    std::cout << "Speedup:  " << (mapTime / calendarTime) << "x" << std::endl;
+
+    if( mapHash != calendarHash )
+    {
+        std::cout << "ERROR: Event order differs between backends!" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Event order is identical." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+/*
+ *  Microbenchmark for event scheduling through NVMObject pointers. The
+ *  memory system described by a config file is built, then every object
+ *  in the hierarchy (ranks, banks, subarrays, ...) is repeatedly scheduled,
+ *  looked up and descheduled on the event queue. The cached hook used by
+ *  InsertEvent/FindEvent is compared against the old lookup which scanned
+ *  the parent's children list on each call.
+ *
+ *  Usage: HookLookupBenchmark CONFIG_FILE [ROUNDS] [PARAM=value ...]
+ *  e.g.,  HookLookupBenchmark Config/PCM_ISSCC_2012_4GB.config 100 MATHeight=256
+ */
+
+#include "src/Config.h"
+#include "src/EventQueue.h"
+#include "src/NVMObject.h"
+#include "src/TagGenerator.h"
+#include "NVM/nvmain.h"
+#include "SimInterface/NullInterface/NullInterface.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace NVM;
+
+namespace {
+
+class BenchRoot : public NVMObject
+{
+  public:
+    void Cycle( ncycle_t ) { }
+};
+
+/* The lookup done by InsertEvent/FindEvent before hooks were cached. */
+NVMObject_hook *ScanForHook( NVMObject *recipient )
+{
+    std::vector<NVMObject_hook *>& children = recipient->GetParent( )->GetTrampoline( )->GetChildren( );
+    std::vector<NVMObject_hook *>::iterator it;
+
+    for( it = children.begin(); it != children.end(); it++ )
+    {
+        if( (*it)->GetTrampoline() == recipient )
+            return (*it);
+    }
+
+    return NULL;
+}
+
+void CollectObjects( NVMObject *object, std::vector<NVMObject *>& objects )
+{
+    std::vector<NVMObject_hook *>& children = object->GetChildren( );
+
+    for( size_t i = 0; i < children.size( ); i++ )
+    {
+        objects.push_back( children[i]->GetTrampoline( ) );
+        CollectObjects( children[i]->GetTrampoline( ), objects );
+    }
+}
+
+double RunBenchmark( bool cached, std::vector<NVMObject *>& objects, 
+                     ncounter_t rounds )
+{
+    EventQueue *queue = new EventQueue( );
+    std::vector<Event *> events( objects.size( ) );
+
+    clock_t start = clock( );
+
+    for( ncounter_t round = 0; round < rounds; round++ )
+    {
+        ncycle_t base = round * objects.size( ) + 1;
+
+        for( size_t i = 0; i < objects.size( ); i++ )
+        {
+            if( cached )
+                queue->InsertEvent( EventCycle, objects[i], base + i );
+            else
+                queue->InsertEvent( EventCycle, ScanForHook( objects[i] ), base + i );
+        }
+
+        for( size_t i = 0; i < objects.size( ); i++ )
+        {
+            if( cached )
+                events[i] = queue->FindEvent( EventCycle, objects[i], NULL, base + i );
+            else
+                events[i] = queue->FindEvent( EventCycle, ScanForHook( objects[i] ), 
+                                              NULL, base + i );
+        }
+
+        for( size_t i = 0; i < objects.size( ); i++ )
+        {
+            queue->RemoveEvent( events[i], base + i );
+            delete events[i];
+        }
+    }
+
+    clock_t end = clock( );
+
+    delete queue;
+
+    return static_cast<double>(end - start) / CLOCKS_PER_SEC;
+}
+
+};
+
+int main( int argc, char *argv[] )
+{
+    if( argc < 2 )
+    {
+        std::cout << "Usage: HookLookupBenchmark CONFIG_FILE [ROUNDS] [PARAM=value ...]"
+                  << std::endl;
+        return 1;
+    }
+
+    ncounter_t rounds = 100;
+    Config *config = new Config( );
+    SimInterface *simInterface = new NullInterface( );
+    BenchRoot *root = new BenchRoot( );
+    NVMain *nvmain = new NVMain( );
+
+    config->Read( argv[1] );
+    config->SetSimInterface( simInterface );
+
+    if( argc > 2 )
+        rounds = strtoull( argv[2], NULL, 10 );
+
+    for( int curArg = 3; curArg < argc; ++curArg )
+    {
+        std::string clPair = argv[curArg];
+        std::string clParam = clPair.substr( 0, clPair.find_first_of("=") );
+        std::string clValue = clPair.substr( clPair.find_first_of("=") + 1, std::string::npos );
+
+        config->SetValue( clParam, clValue );
+    }
+
+    root->SetStats( new Stats( ) );
+    root->SetTagGenerator( new TagGenerator( 1000 ) );
+    root->SetEventQueue( new EventQueue( ) );
+    root->SetGlobalEventQueue( new GlobalEventQueue( ) );
+
+    root->AddChild( nvmain );
+    nvmain->SetParent( root );
+
+    simInterface->SetConfig( config, true );
+    nvmain->SetConfig( config, "defaultMemory", true );
+
+    std::vector<NVMObject *> objects;
+    CollectObjects( root, objects );
+
+    /* Sanity check the cached hooks before timing anything. */
+    for( size_t i = 0; i < objects.size( ); i++ )
+    {
+        if( objects[i]->GetSelfHook( ) != ScanForHook( objects[i] ) )
+        {
+            std::cout << "ERROR: Cached hook differs for object " << i << std::endl;
+            return 1;
+        }
+    }
+
+    ncounter_t events = rounds * objects.size( );
+
+    std::cout << "Scheduling " << events << " events across " << objects.size( )
+              << " objects." << std::endl;
+
+    double scanTime = RunBenchmark( false, objects, rounds );
+    double cachedTime = RunBenchmark( true, objects, rounds );
+
+    std::cout << "Scan:    " << scanTime << " s (" 
+              << (scanTime * 1e9 / events) << " ns/event)" << std::endl;
+    std::cout << "Cached:  " << cachedTime << " s (" 
+              << (cachedTime * 1e9 / events) << " ns/event)" << std::endl;
+    std::cout << "Speedup: " << (scanTime / cachedTime) << "x" << std::endl;
+
+    return 0;
+}
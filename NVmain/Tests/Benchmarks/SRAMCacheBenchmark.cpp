@@ -0,0 +1,194 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+/*
+ *  Microbenchmark for read hits in the FRFCFS_CACHE SRAM cache. A working
+ *  set that fits in the cache is written once, then read back over and
+ *  over. The old hit path (a lookup followed by a read into a freshly
+ *  allocated buffer) is compared against reading straight into the
+ *  request's data block. The data read is hashed so both paths can be
+ *  checked for identical results.
+ *
+ *  Usage: SRAMCacheBenchmark [HITS] [ASSOCIATIVITY] [LRU|PLRU|SRRIP|Random]
+ */
+
+#include "include/NVMDataBlock.h"
+#include "MemControl/FRFCFS_CACHE/MySRAMCache/MySRAMCache.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace NVM;
+
+namespace {
+
+const uint64_t lineBytes = 64;
+const uint64_t cacheLines = 16;      /* 2^16 lines, 4 MB */
+const uint64_t workingSet = 32768;
+
+uint64_t HashData( uint64_t hash, const uint8_t *data, uint64_t size )
+{
+    for( uint64_t i = 0; i < size; i++ )
+        hash = (hash ^ data[i]) * 1099511628211ULL;
+
+    return hash;
+}
+
+double RunBenchmark( bool allocate, MySRAMCache *cache, 
+                     std::vector<uint64_t>& addresses, uint64_t hits, 
+                     uint64_t *hash )
+{
+    NVMDataBlock block;
+
+    block.SetSize( lineBytes );
+    *hash = 14695981039346656037ULL;
+
+    clock_t start = clock( );
+
+    for( uint64_t i = 0; i < hits; i++ )
+    {
+        uint64_t address = addresses[i % addresses.size( )];
+
+        if( allocate )
+        {
+            /* The hit path before reads were copied into the request. */
+            if( !cache->hasData( address, lineBytes ) )
+                continue;
+
+            uint8_t *buffer = new uint8_t[lineBytes];
+            cache->readData( address, buffer, lineBytes );
+            *hash = HashData( *hash, buffer, 8 );
+            delete [] buffer;
+        }
+        else
+        {
+            if( !cache->readData( address, block.rawData, lineBytes ) )
+                continue;
+
+            *hash = HashData( *hash, block.rawData, 8 );
+        }
+    }
+
+    clock_t end = clock( );
+
+    return static_cast<double>(end - start) / CLOCKS_PER_SEC;
+}
+
+MySRAMCache *CreateCache( uint64_t assoc, MySRAMCache::ReplacementPolicy policy,
+                          std::vector<uint64_t>& addresses )
+{
+    MySRAMCache *cache = new MySRAMCache( cacheLines, 4, assoc, lineBytes, policy );
+    uint8_t line[lineBytes];
+
+    for( uint64_t i = 0; i < addresses.size( ); i++ )
+    {
+        for( uint64_t byte = 0; byte < lineBytes; byte++ )
+            line[byte] = static_cast<uint8_t>( addresses[i] >> 6 ) + byte;
+
+        cache->writeData( addresses[i], line, lineBytes );
+    }
+
+    return cache;
+}
+
+};
+
+int main( int argc, char *argv[] )
+{
+    uint64_t hits = 20000000;
+    uint64_t assoc = 16;
+    MySRAMCache::ReplacementPolicy policy = MySRAMCache::LRU;
+
+    if( argc > 1 )
+        hits = strtoull( argv[1], NULL, 10 );
+    if( argc > 2 )
+        assoc = strtoull( argv[2], NULL, 10 );
+    if( argc > 3 )
+    {
+        std::string name = argv[3];
+
+        if( name == "PLRU" )
+            policy = MySRAMCache::PLRU;
+        else if( name == "SRRIP" )
+            policy = MySRAMCache::SRRIP;
+        else if( name == "Random" )
+            policy = MySRAMCache::RANDOM;
+    }
+
+    /* Scattered line addresses, all of which stay in the cache. */
+    std::vector<uint64_t> addresses( workingSet );
+    uint64_t seed = 1;
+
+    for( uint64_t i = 0; i < workingSet; i++ )
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        addresses[i] = (i + ((seed >> 40) << 16)) * lineBytes;
+    }
+
+    std::cout << "Reading " << hits << " hits from a " << workingSet 
+              << " line working set, ";
+    if( assoc == 0 )
+        std::cout << "fully associative." << std::endl;
+    else
+        std::cout << assoc << "-way." << std::endl;
+
+    uint64_t allocateHash, copyHash;
+
+    MySRAMCache *cache = CreateCache( assoc, policy, addresses );
+    double allocateTime = RunBenchmark( true, cache, addresses, hits, &allocateHash );
+    delete cache;
+
+    cache = CreateCache( assoc, policy, addresses );
+    double copyTime = RunBenchmark( false, cache, addresses, hits, &copyHash );
+    delete cache;
+
+    std::cout << "Allocate: " << allocateTime << " s (" 
+              << (hits / allocateTime / 1e6) << " M hits/s)" << std::endl;
+    std::cout << "In place: " << copyTime << " s (" 
+              << (hits / copyTime / 1e6) << " M hits/s)" << std::endl;
+    std::cout << "Speedup:  " << (allocateTime / copyTime) << "x" << std::endl;
+
+    if( allocateHash != copyHash )
+    {
+        std::cout << "ERROR: Data read differs between hit paths!" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Data read is identical." << std::endl;
+
+    return 0;
+}
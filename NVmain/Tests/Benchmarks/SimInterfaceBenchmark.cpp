@@ -0,0 +1,287 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+/*
+ *  Microbenchmark for the data tracked by SimInterface for endurance
+ *  modeling. Random lines in a memory footprint are read back and then
+ *  overwritten, the way SubArray fetches the old data before each write,
+ *  using the paged store in SimInterface and the map of heap allocated
+ *  blocks it replaced. The data and access counts returned by both are
+ *  compared, and a memory image file is checked to be read but never
+ *  written.
+ *
+ *  Usage: SimInterfaceBenchmark [WRITES] [FOOTPRINT_MB]
+ *  e.g.,  SimInterfaceBenchmark 1000000 256
+ */
+
+#include "src/Config.h"
+#include "SimInterface/NullInterface/NullInterface.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace NVM;
+
+namespace {
+
+const uint64_t lineSize = 64;
+
+/* The store used by SimInterface before it kept pages. */
+class MapStore
+{
+  public:
+    int GetDataAtAddress( uint64_t address, NVMDataBlock *data )
+    {
+        if( !memoryData.count( address ) )
+            return 0;
+
+        if( data )
+            *data = *memoryData[address];
+
+        return 1;
+    }
+
+    void SetDataAtAddress( uint64_t address, NVMDataBlock& data )
+    {
+        if( !accessCounts.count( address ) )
+        {
+            NVMDataBlock *newData = new NVMDataBlock( );
+            memoryData[address] = newData;
+            *newData = data;
+            accessCounts[address] = 0;
+        }
+        else
+        {
+            *memoryData[address] = data;
+            accessCounts[address]++;
+        }
+    }
+
+    unsigned int GetAccessCount( uint64_t address )
+    {
+        return accessCounts.count( address ) ? accessCounts[address] : 0;
+    }
+
+  private:
+    std::map<uint64_t, NVMDataBlock *> memoryData;
+    std::map<uint64_t, unsigned int> accessCounts;
+};
+
+uint64_t ResidentBytes( )
+{
+    std::ifstream statm( "/proc/self/statm" );
+    uint64_t pages = 0, resident = 0;
+
+    statm >> pages >> resident;
+
+    return resident * static_cast<uint64_t>( sysconf( _SC_PAGESIZE ) );
+}
+
+void FillLine( NVMDataBlock& block, uint64_t seed )
+{
+    for( uint64_t i = 0; i < lineSize; i++ )
+        block.rawData[i] = static_cast<uint8_t>( (seed >> (i % 8)) + i );
+}
+
+template<class Store>
+double RunBenchmark( Store *store, std::vector<uint64_t>& addresses, uint64_t& checksum )
+{
+    NVMDataBlock newData, oldData;
+
+    newData.SetSize( lineSize );
+    checksum = 0;
+
+    clock_t start = clock( );
+
+    for( size_t i = 0; i < addresses.size( ); i++ )
+    {
+        if( store->GetDataAtAddress( addresses[i], &oldData ) )
+            checksum += oldData.GetByte( i % lineSize );
+
+        FillLine( newData, i );
+        store->SetDataAtAddress( addresses[i], newData );
+    }
+
+    clock_t end = clock( );
+
+    return static_cast<double>(end - start) / CLOCKS_PER_SEC;
+}
+
+bool CheckImage( )
+{
+    char imageFile[] = "/tmp/SimInterfaceBenchmarkXXXXXX";
+    int fd = mkstemp( imageFile );
+    std::vector<uint8_t> image( 2 * 4096 + 100 );
+
+    for( size_t i = 0; i < image.size( ); i++ )
+        image[i] = static_cast<uint8_t>( i * 7 );
+
+    if( fd < 0 || write( fd, image.data( ), image.size( ) ) 
+                  != static_cast<ssize_t>( image.size( ) ) )
+    {
+        std::cout << "ERROR: Could not write " << imageFile << std::endl;
+        return false;
+    }
+    close( fd );
+
+    Config *config = new Config( );
+    NullInterface *simInterface = new NullInterface( );
+    bool rv = true;
+
+    config->SetValue( "MemoryImageFile", imageFile );
+    simInterface->SetConfig( config, false );
+
+    NVMDataBlock block;
+
+    /* Lines inside the image read as its contents. */
+    if( !simInterface->GetDataAtAddress( 4096 + 64, &block ) 
+        || block.GetSize( ) != lineSize
+        || memcmp( block.rawData, &image[4096 + 64], lineSize ) != 0 )
+        rv = false;
+
+    /* Lines past the end of the file have not been written. */
+    if( simInterface->GetDataAtAddress( 3 * 4096, NULL ) )
+        rv = false;
+
+    FillLine( block, 42 );
+    simInterface->SetDataAtAddress( 64, block );
+
+    NVMDataBlock readBack;
+
+    if( !simInterface->GetDataAtAddress( 64, &readBack ) 
+        || memcmp( readBack.rawData, block.rawData, lineSize ) != 0
+        || simInterface->GetAccessCount( 64 ) != 1 )
+        rv = false;
+
+    delete simInterface;
+
+    /* The mapping is private, so the file must be unchanged. */
+    std::vector<uint8_t> after( image.size( ) );
+    FILE *check = fopen( imageFile, "rb" );
+
+    if( check == NULL || fread( after.data( ), 1, after.size( ), check ) != after.size( ) 
+        || after != image )
+        rv = false;
+
+    if( check != NULL )
+        fclose( check );
+
+    unlink( imageFile );
+    delete config;
+
+    return rv;
+}
+
+};
+
+int main( int argc, char *argv[] )
+{
+    uint64_t writes = 1000000;
+    uint64_t footprint = 256;
+
+    if( argc > 1 )
+        writes = strtoull( argv[1], NULL, 10 );
+    if( argc > 2 )
+        footprint = strtoull( argv[2], NULL, 10 );
+
+    if( footprint == 0 )
+    {
+        std::cout << "Usage: SimInterfaceBenchmark [WRITES] [FOOTPRINT_MB]" << std::endl;
+        return 1;
+    }
+
+    if( !CheckImage( ) )
+    {
+        std::cout << "ERROR: Memory image was not read back correctly." << std::endl;
+        return 1;
+    }
+
+    uint64_t lines = (footprint << 20) / lineSize;
+    std::vector<uint64_t> addresses( writes );
+
+    srand( 1 );
+    for( uint64_t i = 0; i < writes; i++ )
+    {
+        uint64_t line = ((static_cast<uint64_t>( rand( ) ) << 31) ^ rand( )) % lines;
+        addresses[i] = line * lineSize;
+    }
+
+    std::cout << "Writing " << writes << " lines in a " << footprint << " MB footprint." 
+              << std::endl;
+
+    NullInterface *pagedStore = new NullInterface( );
+    MapStore *mapStore = new MapStore( );
+    uint64_t pagedSum, mapSum;
+
+    uint64_t startBytes = ResidentBytes( );
+    double pagedTime = RunBenchmark( pagedStore, addresses, pagedSum );
+    uint64_t pagedBytes = ResidentBytes( ) - startBytes;
+
+    startBytes = ResidentBytes( );
+    double mapTime = RunBenchmark( mapStore, addresses, mapSum );
+    uint64_t mapBytes = ResidentBytes( ) - startBytes;
+
+    std::cout << "Map:     " << mapTime << " s (" << (mapTime * 1e9 / writes) 
+              << " ns/write), " << (mapBytes >> 20) << " MB" << std::endl;
+    std::cout << "Paged:   " << pagedTime << " s (" << (pagedTime * 1e9 / writes) 
+              << " ns/write), " << (pagedBytes >> 20) << " MB" << std::endl;
+    std::cout << "Speedup: " << (mapTime / pagedTime) << "x" << std::endl;
+
+    /* Both stores must end up with the same data and counts. */
+    for( uint64_t i = 0; i < writes; i += 97 )
+    {
+        NVMDataBlock pagedData, mapData;
+
+        pagedStore->GetDataAtAddress( addresses[i], &pagedData );
+        mapStore->GetDataAtAddress( addresses[i], &mapData );
+
+        if( memcmp( pagedData.rawData, mapData.rawData, lineSize ) != 0
+            || pagedStore->GetAccessCount( addresses[i] ) 
+               != mapStore->GetAccessCount( addresses[i] ) )
+        {
+            std::cout << "ERROR: Stores differ at address 0x" << std::hex 
+                      << addresses[i] << std::dec << std::endl;
+            return 1;
+        }
+    }
+
+    return (pagedSum == mapSum) ? 0 : 1;
+}
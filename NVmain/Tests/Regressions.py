@@ -55,6 +55,17 @@ if not os.path.isfile(gem5exec) or not os.access(gem5exec, os.X_OK):
     testgem5 = False
 
 
+#
+# Find a tool (e.g., valgrind) some tests run the simulator under.
+#
+def findtool(tool):
+    for path in os.environ["PATH"].split(os.pathsep):
+        toolexec = os.path.join(path, tool)
+        if os.path.isfile(toolexec) and os.access(toolexec, os.X_OK):
+            return toolexec
+    return None
+
+
 #
 # Read in the list of config files to test
 #
@@ -80,6 +91,13 @@ for trace in testdata["traces"]:
         sys.stdout.write("Testing " + testdata["tests"][idx]["name"] + " with " + trace + " ... ")
         sys.stdout.flush()
 
+        if "tool" in testdata["tests"][idx]:
+            tool = testdata["tests"][idx]["tool"].split(" ")
+            if findtool(tool[0]) is None:
+                print("[Skipped, %s not found]" % tool[0])
+                continue
+            command = tool + command
+
         try:
             subprocess.check_call(command, stdout=testlog, stderr=subprocess.STDOUT)
         except subprocess.CalledProcessError as e:
@@ -94,12 +112,19 @@ for trace in testdata["traces"]:
         checkcount = 0
         checkcounter = 0
         passedchecks = []
+        failedforbids = []
         
         for check in testdata["tests"][idx]["checks"]:
             checkcount = checkcount + 1
 
+        # Output which must not show up, e.g., leaks reported by the tool
+        forbids = testdata["tests"][idx].get("forbid", [])
+
         with open(options.tempfile, 'r') as flog:
             for line in flog:
+                for forbid in forbids:
+                    if forbid in line and not forbid in failedforbids:
+                        failedforbids.append(forbid)
                 for check in testdata["tests"][idx]["checks"]:
                     if check in line:
                         checkcounter = checkcounter + 1
@@ -121,7 +146,7 @@ for trace in testdata["traces"]:
                             except ZeroDivisionError:
                                 print("Warning: Stat '%s' has reference value (%s) or check value (%s) of zero." % (checkstat, refvalue, checkvalue))
 
-        if checkcounter == checkcount:
+        if checkcounter == checkcount and not failedforbids:
             print("[Passed %d/%d]" % (checkcounter, checkcount))
             shutil.copyfile(options.tempfile, faillog)
         else:
@@ -132,5 +157,8 @@ for trace in testdata["traces"]:
                 if not check in passedchecks:
                     print("Check %s failed." % check)
 
+            for forbid in failedforbids:
+                print("Found forbidden output %s." % forbid)
+
 
 
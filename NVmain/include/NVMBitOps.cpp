@@ -0,0 +1,412 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#include "include/NVMBitOps.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NVM_BITOPS_X86
+#endif
+
+using namespace NVM;
+
+namespace {
+
+#define BITOPS_INLINE inline __attribute__((always_inline))
+
+const uint64_t evenBits = 0x5555555555555555ULL;
+
+BITOPS_INLINE uint64_t LoadWord( const uint8_t *data, uint64_t offset, uint64_t bytes )
+{
+    return LoadBits64( data, offset, bytes );
+}
+
+BITOPS_INLINE uint64_t MaskBits( uint64_t first, uint64_t count )
+{
+    return (count >= 64) ? ~0ULL : (((1ULL << count) - 1) << first);
+}
+
+struct GenericPopcount
+{
+    static BITOPS_INLINE uint64_t Count( uint64_t x )
+    {
+        x = x - ((x >> 1) & evenBits);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+
+        return (x * 0x0101010101010101ULL) >> 56;
+    }
+};
+
+/* Compiles to the popcount instruction in functions built for a CPU that has one. */
+struct BuiltinPopcount
+{
+    static BITOPS_INLINE uint64_t Count( uint64_t x )
+    {
+        return static_cast<uint64_t>( __builtin_popcountll( x ) );
+    }
+};
+
+template<class Popcount>
+BITOPS_INLINE uint64_t CountOnesWords( const uint8_t *data, uint64_t offset, uint64_t bytes )
+{
+    uint64_t count = 0;
+
+    for( ; offset < bytes; offset += 8 )
+        count += Popcount::Count( LoadWord( data, offset, bytes ) );
+
+    return count;
+}
+
+template<class Popcount>
+BITOPS_INLINE uint64_t CountDiffWords( const uint8_t *a, const uint8_t *b, 
+                                       uint64_t offset, uint64_t bytes )
+{
+    uint64_t count = 0;
+
+    for( ; offset < bytes; offset += 8 )
+        count += Popcount::Count( LoadWord( a, offset, bytes ) ^ LoadWord( b, offset, bytes ) );
+
+    return count;
+}
+
+template<class Popcount>
+BITOPS_INLINE void CountStateWords( const uint8_t *data, uint64_t offset, uint64_t bytes, 
+                                    uint64_t counts[4] )
+{
+    for( ; offset < bytes; offset += 8 )
+    {
+        uint64_t word = LoadWord( data, offset, bytes );
+        uint64_t low = word & evenBits;
+        uint64_t high = (word >> 1) & evenBits;
+
+        counts[1] += Popcount::Count( low & ~high );
+        counts[2] += Popcount::Count( high & ~low );
+        counts[3] += Popcount::Count( low & high );
+    }
+}
+
+template<class Popcount>
+BITOPS_INLINE void CountPartitionWords( const uint8_t *a, const uint8_t *b, uint64_t bytes,
+                                        uint64_t partitionBits, uint64_t *counts )
+{
+    uint64_t partitions = (bytes * 8) / partitionBits;
+    uint64_t totalBits = partitions * partitionBits;
+    uint64_t bit = 0;
+
+    for( uint64_t i = 0; i < partitions; i++ )
+        counts[i] = 0;
+
+    while( bit < totalBits )
+    {
+        uint64_t wordStart = bit & ~63ULL;
+        uint64_t wordEnd = (wordStart + 64 < totalBits) ? wordStart + 64 : totalBits;
+        uint64_t diff = LoadWord( a, wordStart / 8, bytes ) ^ LoadWord( b, wordStart / 8, bytes );
+
+        /* Split the word at partition boundaries. */
+        while( bit < wordEnd )
+        {
+            uint64_t partition = bit / partitionBits;
+            uint64_t partitionEnd = (partition + 1) * partitionBits;
+            uint64_t end = (partitionEnd < wordEnd) ? partitionEnd : wordEnd;
+
+            counts[partition] += Popcount::Count( diff & MaskBits( bit - wordStart, end - bit ) );
+            bit = end;
+        }
+    }
+}
+
+void FinishStates( uint64_t bytes, uint64_t counts[4] )
+{
+    counts[0] = bytes * 4 - counts[1] - counts[2] - counts[3];
+}
+
+/* Portable kernels. */
+uint64_t CountOnesGeneric( const uint8_t *data, uint64_t bytes )
+{
+    return CountOnesWords<GenericPopcount>( data, 0, bytes );
+}
+
+uint64_t CountDiffGeneric( const uint8_t *a, const uint8_t *b, uint64_t bytes )
+{
+    return CountDiffWords<GenericPopcount>( a, b, 0, bytes );
+}
+
+void CountStatesGeneric( const uint8_t *data, uint64_t bytes, uint64_t counts[4] )
+{
+    counts[1] = counts[2] = counts[3] = 0;
+    CountStateWords<GenericPopcount>( data, 0, bytes, counts );
+    FinishStates( bytes, counts );
+}
+
+void CountPartitionsGeneric( const uint8_t *a, const uint8_t *b, uint64_t bytes,
+                             uint64_t partitionBits, uint64_t *counts )
+{
+    CountPartitionWords<GenericPopcount>( a, b, bytes, partitionBits, counts );
+}
+
+#ifdef NVM_BITOPS_X86
+#define BITOPS_POPCNT __attribute__((target("popcnt")))
+#define BITOPS_AVX2 __attribute__((target("avx2,popcnt")))
+#else
+#define BITOPS_POPCNT
+#endif
+
+/* Kernels using the hardware popcount on 64-bit words. */
+BITOPS_POPCNT uint64_t CountOnesPopcnt( const uint8_t *data, uint64_t bytes )
+{
+    return CountOnesWords<BuiltinPopcount>( data, 0, bytes );
+}
+
+BITOPS_POPCNT uint64_t CountDiffPopcnt( const uint8_t *a, const uint8_t *b, uint64_t bytes )
+{
+    return CountDiffWords<BuiltinPopcount>( a, b, 0, bytes );
+}
+
+BITOPS_POPCNT void CountStatesPopcnt( const uint8_t *data, uint64_t bytes, uint64_t counts[4] )
+{
+    counts[1] = counts[2] = counts[3] = 0;
+    CountStateWords<BuiltinPopcount>( data, 0, bytes, counts );
+    FinishStates( bytes, counts );
+}
+
+BITOPS_POPCNT void CountPartitionsPopcnt( const uint8_t *a, const uint8_t *b, uint64_t bytes,
+                                          uint64_t partitionBits, uint64_t *counts )
+{
+    CountPartitionWords<BuiltinPopcount>( a, b, bytes, partitionBits, counts );
+}
+
+#ifdef NVM_BITOPS_X86
+/*
+ *  AVX2 kernels count 32 bytes at a time by looking up the popcount of each
+ *  nibble with a byte shuffle, then summing the bytes of each 64-bit lane.
+ */
+BITOPS_AVX2 BITOPS_INLINE __m256i Popcount256( __m256i v )
+{
+    const __m256i lookup = _mm256_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                             0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+    const __m256i lowNibbles = _mm256_set1_epi8( 0x0f );
+
+    __m256i low = _mm256_and_si256( v, lowNibbles );
+    __m256i high = _mm256_and_si256( _mm256_srli_epi16( v, 4 ), lowNibbles );
+    __m256i counts = _mm256_add_epi8( _mm256_shuffle_epi8( lookup, low ),
+                                      _mm256_shuffle_epi8( lookup, high ) );
+
+    return _mm256_sad_epu8( counts, _mm256_setzero_si256( ) );
+}
+
+BITOPS_AVX2 BITOPS_INLINE uint64_t SumLanes( __m256i v )
+{
+    return static_cast<uint64_t>( _mm256_extract_epi64( v, 0 ) ) 
+         + static_cast<uint64_t>( _mm256_extract_epi64( v, 1 ) )
+         + static_cast<uint64_t>( _mm256_extract_epi64( v, 2 ) ) 
+         + static_cast<uint64_t>( _mm256_extract_epi64( v, 3 ) );
+}
+
+BITOPS_AVX2 uint64_t CountOnesAVX2( const uint8_t *data, uint64_t bytes )
+{
+    __m256i total = _mm256_setzero_si256( );
+    uint64_t offset = 0;
+
+    for( ; offset + 32 <= bytes; offset += 32 )
+    {
+        __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(data + offset) );
+        total = _mm256_add_epi64( total, Popcount256( v ) );
+    }
+
+    return SumLanes( total ) + CountOnesWords<BuiltinPopcount>( data, offset, bytes );
+}
+
+BITOPS_AVX2 uint64_t CountDiffAVX2( const uint8_t *a, const uint8_t *b, uint64_t bytes )
+{
+    __m256i total = _mm256_setzero_si256( );
+    uint64_t offset = 0;
+
+    for( ; offset + 32 <= bytes; offset += 32 )
+    {
+        __m256i va = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(a + offset) );
+        __m256i vb = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(b + offset) );
+        total = _mm256_add_epi64( total, Popcount256( _mm256_xor_si256( va, vb ) ) );
+    }
+
+    return SumLanes( total ) + CountDiffWords<BuiltinPopcount>( a, b, offset, bytes );
+}
+
+BITOPS_AVX2 void CountStatesAVX2( const uint8_t *data, uint64_t bytes, uint64_t counts[4] )
+{
+    const __m256i even = _mm256_set1_epi8( 0x55 );
+    __m256i total01 = _mm256_setzero_si256( );
+    __m256i total10 = _mm256_setzero_si256( );
+    __m256i total11 = _mm256_setzero_si256( );
+    uint64_t offset = 0;
+
+    for( ; offset + 32 <= bytes; offset += 32 )
+    {
+        __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(data + offset) );
+        __m256i low = _mm256_and_si256( v, even );
+        __m256i high = _mm256_and_si256( _mm256_srli_epi16( v, 1 ), even );
+
+        total01 = _mm256_add_epi64( total01, Popcount256( _mm256_andnot_si256( high, low ) ) );
+        total10 = _mm256_add_epi64( total10, Popcount256( _mm256_andnot_si256( low, high ) ) );
+        total11 = _mm256_add_epi64( total11, Popcount256( _mm256_and_si256( low, high ) ) );
+    }
+
+    counts[1] = SumLanes( total01 );
+    counts[2] = SumLanes( total10 );
+    counts[3] = SumLanes( total11 );
+    CountStateWords<BuiltinPopcount>( data, offset, bytes, counts );
+    FinishStates( bytes, counts );
+}
+#endif
+
+struct BitOpsTable
+{
+    uint64_t (*countOnes)( const uint8_t *, uint64_t );
+    uint64_t (*countDiff)( const uint8_t *, const uint8_t *, uint64_t );
+    void (*countStates)( const uint8_t *, uint64_t, uint64_t * );
+    void (*countPartitions)( const uint8_t *, const uint8_t *, uint64_t, uint64_t, uint64_t * );
+};
+
+const BitOpsTable kernelTables[] = 
+{
+    { CountOnesGeneric, CountDiffGeneric, CountStatesGeneric, CountPartitionsGeneric },
+    { CountOnesPopcnt, CountDiffPopcnt, CountStatesPopcnt, CountPartitionsPopcnt },
+#ifdef NVM_BITOPS_X86
+    /* Partitions are usually narrower than a vector, so they stay on popcnt. */
+    { CountOnesAVX2, CountDiffAVX2, CountStatesAVX2, CountPartitionsPopcnt },
+#endif
+};
+
+bool KernelSupported( BitOpsKernel kernel )
+{
+#ifdef NVM_BITOPS_X86
+    __builtin_cpu_init( );
+
+    if( kernel == BitOpsAVX2 )
+        return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "popcnt" );
+    else if( kernel == BitOpsPopcnt )
+        return __builtin_cpu_supports( "popcnt" );
+#else
+    if( kernel == BitOpsAVX2 )
+        return false;
+#endif
+
+    return true;
+}
+
+BitOpsKernel DetectKernel( )
+{
+    if( KernelSupported( BitOpsAVX2 ) )
+        return BitOpsAVX2;
+    else if( KernelSupported( BitOpsPopcnt ) )
+        return BitOpsPopcnt;
+
+    return BitOpsGeneric;
+}
+
+/* Start out portable so calls made during static initialization are safe. */
+BitOpsKernel activeKernel = BitOpsGeneric;
+const BitOpsTable *activeTable = &kernelTables[BitOpsGeneric];
+
+bool kernelDetected = SetBitOpsKernel( DetectKernel( ) );
+
+};
+
+BitOpsKernel NVM::GetBitOpsKernel( )
+{
+    return activeKernel;
+}
+
+bool NVM::SetBitOpsKernel( BitOpsKernel kernel )
+{
+    if( !KernelSupported( kernel ) )
+        return false;
+
+    activeKernel = kernel;
+    activeTable = &kernelTables[kernel];
+
+    return true;
+}
+
+const char *NVM::GetBitOpsKernelName( BitOpsKernel kernel )
+{
+    if( kernel == BitOpsAVX2 )
+        return "AVX2";
+    else if( kernel == BitOpsPopcnt )
+        return "popcnt";
+
+    return "generic";
+}
+
+uint64_t NVM::CountOnes( const uint8_t *data, uint64_t bytes )
+{
+    return activeTable->countOnes( data, bytes );
+}
+
+uint64_t NVM::CountDiffBits( const uint8_t *a, const uint8_t *b, uint64_t bytes )
+{
+    return activeTable->countDiff( a, b, bytes );
+}
+
+void NVM::CountCellStates( const uint8_t *data, uint64_t bytes, uint64_t counts[4] )
+{
+    activeTable->countStates( data, bytes, counts );
+}
+
+void NVM::CountDiffBitsByPartition( const uint8_t *a, const uint8_t *b, uint64_t bytes,
+                                    uint64_t partitionBits, uint64_t *counts )
+{
+    activeTable->countPartitions( a, b, bytes, partitionBits, counts );
+}
+
+void NVM::InvertBits( uint8_t *data, uint64_t startBit, uint64_t endBit )
+{
+    if( startBit >= endBit )
+        return;
+
+    uint64_t firstByte = startBit / 8;
+    uint64_t lastByte = (endBit - 1) / 8;
+
+    if( firstByte == lastByte )
+    {
+        data[firstByte] ^= static_cast<uint8_t>( MaskBits( startBit % 8, endBit - startBit ) );
+        return;
+    }
+
+    data[firstByte] ^= static_cast<uint8_t>( MaskBits( startBit % 8, 8 - startBit % 8 ) );
+
+    for( uint64_t i = firstByte + 1; i < lastByte; i++ )
+        data[i] = static_cast<uint8_t>( ~data[i] );
+
+    data[lastByte] ^= static_cast<uint8_t>( MaskBits( 0, endBit - lastByte * 8 ) );
+}
@@ -0,0 +1,108 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#ifndef __NVMBITOPS_H__
+#define __NVMBITOPS_H__
+
+#include <stdint.h>
+#include <cstring>
+
+namespace NVM {
+
+/*
+ *  Bit counting kernels used to model data-dependent writes. Data is read
+ *  as little-endian 64-bit words, so bit b of byte i is bit (8 * i + b) of
+ *  the buffer. Buffers need no particular alignment.
+ *
+ *  The kernel is chosen once for the CPU we run on: AVX2 if available,
+ *  otherwise the hardware popcount instruction, otherwise a portable
+ *  bit-twiddling version. All kernels return identical results.
+ */
+enum BitOpsKernel
+{
+    BitOpsGeneric = 0,
+    BitOpsPopcnt,
+    BitOpsAVX2
+};
+
+BitOpsKernel GetBitOpsKernel( );
+/* Returns false (and keeps the current kernel) if the CPU lacks support. */
+bool SetBitOpsKernel( BitOpsKernel kernel );
+const char *GetBitOpsKernelName( BitOpsKernel kernel );
+
+/* Number of bits set in the first bytes of data. */
+uint64_t CountOnes( const uint8_t *data, uint64_t bytes );
+
+/* Number of bits that differ between a and b. */
+uint64_t CountDiffBits( const uint8_t *a, const uint8_t *b, uint64_t bytes );
+
+/*
+ *  Number of 2-bit MLC cells in each state, indexed by the value of the
+ *  cell (00, 01, 10, 11) where the odd bit is the most significant.
+ */
+void CountCellStates( const uint8_t *data, uint64_t bytes, uint64_t counts[4] );
+
+/*
+ *  Number of differing bits between a and b in each partitionBits wide
+ *  partition. counts must hold (bytes * 8) / partitionBits entries; bits
+ *  past the last whole partition are ignored.
+ */
+void CountDiffBitsByPartition( const uint8_t *a, const uint8_t *b, uint64_t bytes,
+                               uint64_t partitionBits, uint64_t *counts );
+
+/* Invert bits [startBit, endBit) of data in place. */
+void InvertBits( uint8_t *data, uint64_t startBit, uint64_t endBit );
+
+/*
+ *  The 64 bits starting at byte offset of data, in the order above. Bytes
+ *  past the end of the buffer read as zero.
+ */
+inline uint64_t LoadBits64( const uint8_t *data, uint64_t offset, uint64_t bytes )
+{
+    uint64_t word = 0;
+
+    if( offset + 8 <= bytes )
+        memcpy( &word, data + offset, 8 );
+    else if( offset < bytes )
+        memcpy( &word, data + offset, bytes - offset );
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64( word );
+#endif
+
+    return word;
+}
+
+};
+
+#endif
@@ -36,6 +36,7 @@
 #include <cassert>
 #include <cstring>
 #include <iostream>
+#include <utility>
 
 using namespace NVM;
 
@@ -46,16 +47,45 @@ NVMDataBlock::NVMDataBlock( )
     size = 0;
 }
 
+NVMDataBlock::NVMDataBlock( NVMDataBlock&& m )
+{
+    rawData = NULL;
+    isValid = false;
+    size = 0;
+
+    *this = std::move( m );
+}
+
 NVMDataBlock::~NVMDataBlock( )
 {
-    delete[] rawData;
+    Release( );
+}
+
+bool NVMDataBlock::OwnsHeapData( ) const
+{
+    return (rawData != NULL && rawData != inlineData);
+}
+
+void NVMDataBlock::Allocate( uint64_t s )
+{
+    if( s <= inlineSize )
+        rawData = inlineData;
+    else
+        rawData = new uint8_t[s];
+}
+
+void NVMDataBlock::Release( )
+{
+    if( OwnsHeapData( ) )
+        delete[] rawData;
+
     rawData = NULL;
 }
 
 void NVMDataBlock::SetSize( uint64_t s )
 {
     assert( rawData == NULL );
-    rawData = new uint8_t[s];
+    Allocate( s );
     size = s;
     isValid = true;
 }
@@ -77,6 +107,23 @@ uint8_t NVMDataBlock::GetByte( uint64_t byte )
     return rv;
 }
 
+const uint8_t *NVMDataBlock::GetBytes( uint64_t bytes, uint8_t *scratch ) const
+{
+    if( isValid && rawData != NULL && bytes <= size )
+        return rawData;
+
+    uint64_t available = (isValid && rawData != NULL) ? size : 0;
+
+    if( available > bytes )
+        available = bytes;
+
+    if( available > 0 )
+        memcpy( scratch, rawData, available );
+    memset( scratch + available, 0, bytes - available );
+
+    return scratch;
+}
+
 void NVMDataBlock::SetByte( uint64_t byte, uint8_t value )
 {
     if( byte <= size )
@@ -111,15 +158,52 @@ void NVMDataBlock::Print( std::ostream& out ) const
 
 NVMDataBlock& NVMDataBlock::operator=( const NVMDataBlock& m )
 {
+    if( this == &m )
+        return *this;
+
     if( m.rawData )
     {
-        if( rawData == NULL )
-            rawData = new uint8_t[m.size];
+        /* Reuse the current buffer unless it is too small. */
+        if( rawData == NULL || size < m.size )
+        {
+            Release( );
+            Allocate( m.size );
+        }
+        memcpy(rawData, m.rawData, m.size);
+    }
+    isValid = m.isValid;
+    size = m.size;
+
+    return *this;
+}
+
+NVMDataBlock& NVMDataBlock::operator=( NVMDataBlock&& m )
+{
+    if( this == &m )
+        return *this;
+
+    if( m.OwnsHeapData( ) )
+    {
+        /* Take over the heap buffer instead of copying it. */
+        Release( );
+        rawData = m.rawData;
+    }
+    else if( m.rawData )
+    {
+        if( rawData == NULL || size < m.size )
+        {
+            Release( );
+            Allocate( m.size );
+        }
         memcpy(rawData, m.rawData, m.size);
     }
     isValid = m.isValid;
     size = m.size;
 
+    m.rawData = NULL;
+    m.isValid = false;
+    m.size = 0;
+
     return *this;
 }
 
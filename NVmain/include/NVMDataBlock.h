@@ -40,10 +40,18 @@
 
 namespace NVM {
 
+/*
+ *  Data of a memory request. Blocks of up to inlineSize bytes (one 64-byte
+ *  cache line) are stored inside the object itself so creating or copying a
+ *  request does not touch the heap. Larger blocks are allocated on the heap.
+ *  rawData always points to the storage in use, and buffers assigned to it
+ *  directly are owned by the block as before.
+ */
 class NVMDataBlock
 {
   public:
     NVMDataBlock( );
+    NVMDataBlock( NVMDataBlock&& m );
     ~NVMDataBlock( );
 
     void SetSize( uint64_t s );
@@ -52,18 +60,34 @@ class NVMDataBlock
     uint8_t GetByte( uint64_t byte );
     void SetByte( uint64_t byte, uint8_t value );
 
+    /*
+     *  Returns the first bytes bytes of the block for word-wide reads. If the
+     *  block is invalid or shorter, the available bytes are copied into
+     *  scratch (zero padded, as GetByte would read them) and scratch is
+     *  returned instead.
+     */
+    const uint8_t *GetBytes( uint64_t bytes, uint8_t *scratch ) const;
+
     void SetValid( bool valid );
     bool IsValid( );
 
     void Print( std::ostream& out ) const;
     
     NVMDataBlock& operator=( const NVMDataBlock& m );
+    NVMDataBlock& operator=( NVMDataBlock&& m );
+
+    static const uint64_t inlineSize = 64;
 
     uint8_t *rawData;
   
   private:
     bool isValid;
     uint64_t size;
+    uint8_t inlineData[inlineSize];
+
+    bool OwnsHeapData( ) const;
+    void Allocate( uint64_t s );
+    void Release( );
 
     NVMDataBlock( const NVMDataBlock& ) { }
 };
@@ -0,0 +1,161 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+
+#include "include/NVMainRequest.h"
+
+#include <mutex>
+#include <new>
+#include <vector>
+
+using namespace NVM;
+
+namespace {
+
+/* Free requests are linked through their own storage. */
+struct FreeRequest
+{
+    FreeRequest *next;
+};
+
+const ncounter_t requestSlabSize = 256;
+
+struct RequestPool
+{
+    FreeRequest *freeRequests;
+    ncounter_t allocations;
+    ncounter_t heapAllocations;
+};
+
+/*
+ *  Slabs are never returned to the system. Requests may still be in flight
+ *  when static destructors run, and a request freed by another thread just
+ *  joins that thread's pool. Every thread's pool is registered so the
+ *  counters cover requests made by channel worker threads as well.
+ */
+thread_local RequestPool *requestPool = NULL;
+
+std::mutex poolListLock;
+std::vector<RequestPool *> *poolList = NULL;
+
+RequestPool& GetRequestPool( )
+{
+    if( requestPool == NULL )
+    {
+        requestPool = new RequestPool( );
+        requestPool->freeRequests = NULL;
+        requestPool->allocations = 0;
+        requestPool->heapAllocations = 0;
+
+        std::lock_guard<std::mutex> guard( poolListLock );
+        if( poolList == NULL )
+            poolList = new std::vector<RequestPool *>( );
+        poolList->push_back( requestPool );
+    }
+
+    return *requestPool;
+}
+
+}
+
+void *NVMainRequest::operator new( size_t size )
+{
+    if( size != sizeof(NVMainRequest) )
+        return ::operator new( size );
+
+    RequestPool& pool = GetRequestPool( );
+
+    if( pool.freeRequests == NULL )
+    {
+        uint8_t *slab = static_cast<uint8_t *>(
+                ::operator new( requestSlabSize * sizeof(NVMainRequest) ) );
+
+        for( ncounter_t i = 0; i < requestSlabSize; i++ )
+        {
+            FreeRequest *request = reinterpret_cast<FreeRequest *>(
+                    slab + i * sizeof(NVMainRequest) );
+
+            request->next = pool.freeRequests;
+            pool.freeRequests = request;
+        }
+
+        pool.heapAllocations += requestSlabSize;
+    }
+
+    FreeRequest *request = pool.freeRequests;
+    pool.freeRequests = request->next;
+    pool.allocations++;
+
+    return request;
+}
+
+void NVMainRequest::operator delete( void *ptr, size_t size )
+{
+    if( ptr == NULL )
+        return;
+
+    if( size != sizeof(NVMainRequest) )
+    {
+        ::operator delete( ptr );
+        return;
+    }
+
+    RequestPool& pool = GetRequestPool( );
+    FreeRequest *request = static_cast<FreeRequest *>(ptr);
+
+    request->next = pool.freeRequests;
+    pool.freeRequests = request;
+}
+
+/* Only meaningful while no other thread is allocating. */
+ncounter_t NVMainRequest::GetPoolAllocations( )
+{
+    ncounter_t allocations = 0;
+
+    std::lock_guard<std::mutex> guard( poolListLock );
+    for( size_t i = 0; poolList != NULL && i < poolList->size( ); i++ )
+        allocations += (*poolList)[i]->allocations;
+
+    return allocations;
+}
+
+ncounter_t NVMainRequest::GetPoolHeapAllocations( )
+{
+    ncounter_t heapAllocations = 0;
+
+    std::lock_guard<std::mutex> guard( poolListLock );
+    for( size_t i = 0; poolList != NULL && i < poolList->size( ); i++ )
+        heapAllocations += (*poolList)[i]->heapAllocations;
+
+    return heapAllocations;
+}
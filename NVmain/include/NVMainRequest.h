@@ -37,6 +37,7 @@
 #include "include/NVMAddress.h"
 #include "include/NVMDataBlock.h"
 #include "include/NVMTypes.h"
+#include <cstddef>
 #include <iostream>
 #include <signal.h>
 
@@ -135,12 +136,25 @@ class NVMainRequest
         writeProgress = 0;
         cancellations = 0;
         owner = NULL;
+        trigger = NULL;
     };
 
     ~NVMainRequest( )
     { 
     };
 
+    /* 
+     *  Requests are allocated from a per-thread pool of recycled objects, so
+     *  the trace drivers, prefetcher and controllers creating and completing
+     *  requests do not go to the heap once the pool has warmed up.
+     */
+    static void *operator new( size_t size );
+    static void operator delete( void *ptr, size_t size );
+
+    /* Number of requests handed out by this thread's pool, and of those, how many needed new memory. */
+    static ncounter_t GetPoolAllocations( );
+    static ncounter_t GetPoolHeapAllocations( );
+
     NVMAddress address;            //< Address of request
     OpType type;                   //< Operation type of request (read, write, etc)
     BulkCommand bulkCmd;           //< Bulk Commands (i.e., Read+Precharge, Write+Precharge, etc)
@@ -157,6 +171,7 @@ class NVMainRequest
     uint64_t programCounter;       //< Program counter of CPU issuing request
     ncounter_t burstCount;         //< Number of bursts (used for variable-size requests.
     NVMObject *owner;              //< Pointer to the object that created this request
+    NVMainRequest *trigger;        //< Transaction a controller command was made for (valid until the command issues)
 
     ncycle_t arrivalCycle;         //< When the request arrived at the memory controller
     ncycle_t queueCycle;           //< When the memory controller accepted (queued) the request
@@ -201,6 +216,7 @@ const NVMainRequest& NVMainRequest::operator=( const NVMainRequest& m )
     pfTrigger = m.pfTrigger;
     programCounter = m.programCounter;
     owner = m.owner;
+    trigger = m.trigger;
 
     arrivalCycle = m.arrivalCycle;
     queueCycle = m.queueCycle;
@@ -54,6 +54,14 @@ AddressTranslator::AddressTranslator( )
     burstLength = 8; 
 
     lowColBits = 0;
+
+    tablesValid = false;
+    tableGeneration = 0;
+    bankXORHash = false;
+    channelXORHash = false;
+    channelHashShift = 0;
+    lastValid = false;
+    lastAddress = 0;
 }
 
 
@@ -62,9 +70,25 @@ AddressTranslator::~AddressTranslator( )
 }
 
 
+void AddressTranslator::SetConfig( Config *config, bool /*createChildren*/ )
+{
+    bankXORHash = false;
+    channelXORHash = false;
+
+    if( config->KeyExists( "BankXORHash" ) )
+        bankXORHash = config->GetBool( "BankXORHash" );
+
+    if( config->KeyExists( "ChannelXORHash" ) )
+        channelXORHash = config->GetBool( "ChannelXORHash" );
+
+    tablesValid = false;
+}
+
+
 void AddressTranslator::SetTranslationMethod( TranslationMethod *m )
 {
     method = m;
+    tablesValid = false;
 }
 
 
@@ -86,67 +110,22 @@ uint64_t AddressTranslator::ReverseTranslate( const uint64_t& row,
         exit(1);
     }
 
-    uint64_t unitAddr = 1;
-    uint64_t phyAddr = 0;
-    MemoryPartition part = MEM_UNKNOWN;
+    CheckTables( );
 
-    int busOffsetBits = mlog2( busWidth / 8 );
-    int burstBits = mlog2( (busWidth * burstLength) / 8 );
-    lowColBits = burstBits - busOffsetBits;
-
-    /* first of all, add the bus width */
-    unitAddr <<= busOffsetBits;
+    uint64_t phyAddr = 0;
+    uint64_t fields[6] = { row, col, bank, rank, channel, subarray };
 
-    /* then, add the lowest column bits */
-    unitAddr <<= lowColBits;
+    /* The hash is its own inverse, so apply it again to get the stored field. */
+    if( bankXORHash )
+        fields[MEM_BANK] ^= ( row & fieldMask[MEM_BANK] );
 
-    unsigned channelBits, rankBits, bankBits, rowBits, colBits, subarrayBits;
+    if( channelXORHash )
+        fields[MEM_CHANNEL] ^= ( ( row >> channelHashShift ) & fieldMask[MEM_CHANNEL] );
 
-    method->GetBitWidths( &rowBits, &colBits, &bankBits, 
-                          &rankBits, &channelBits, &subarrayBits );
-
-    for( int i = 0; i < 6 ; i++ )
+    for( int i = 0; i < 6; i++ )
     {
-        /* 0->4, low to high, FindOrder() will find the correct one */
-        FindOrder( i, &part );
-
-        switch( part )
-        {
-            case MEM_ROW:
-                  phyAddr += ( row * unitAddr ); 
-                  unitAddr <<= rowBits;
-                  break;
-
-            case MEM_COL:
-                  phyAddr += ( col * unitAddr ); 
-                  unitAddr <<= ( colBits /*- lowColBits*/ );
-                  break;
-
-            case MEM_BANK:
-                  phyAddr += ( bank * unitAddr ); 
-                  unitAddr <<= bankBits;
-                  break;
-
-            case MEM_RANK:
-                  phyAddr += ( rank * unitAddr ); 
-                  unitAddr <<= rankBits;
-                  break;
-
-            case MEM_CHANNEL:
-                  phyAddr += ( channel * unitAddr ); 
-                  unitAddr <<= channelBits;
-                  break;
-
-            case MEM_SUBARRAY:
-                  phyAddr += ( subarray * unitAddr ); 
-                  unitAddr <<= subarrayBits;
-                  break;
-
-            case MEM_UNKNOWN:
-            default:
-                  std::cerr << "Address Translator: No partition found for address " << std::endl;
-                  break;
-        }
+        if( fieldMapped[i] )
+            phyAddr += ( fields[i] << fieldShift[i] );
     }
 
     return phyAddr;
@@ -160,6 +139,7 @@ uint64_t AddressTranslator::ReverseTranslate( const uint64_t& row,
 void AddressTranslator::SetBusWidth( int bits )
 {
     busWidth = bits;
+    tablesValid = false;
 }
 
 /* 
@@ -170,6 +150,7 @@ void AddressTranslator::SetBusWidth( int bits )
 void AddressTranslator::SetBurstLength( int beat )
 {
     burstLength = beat;
+    tablesValid = false;
 }
 
 /*
@@ -189,9 +170,6 @@ void AddressTranslator::Translate( NVMainRequest *request, uint64_t *row, uint64
 void AddressTranslator::Translate( uint64_t address, uint64_t *row, uint64_t *col, uint64_t *bank,
 				   uint64_t *rank, uint64_t *channel, uint64_t *subarray )
 {
-    uint64_t refAddress;
-    MemoryPartition part;
-
     uint64_t *partitions[6] = { row, col, bank, rank, channel, subarray };
 
     if( GetTranslationMethod( ) == NULL )
@@ -200,34 +178,27 @@ void AddressTranslator::Translate( uint64_t address, uint64_t *row, uint64_t *co
         return;
     }
 
-    int busOffsetBits = mlog2( busWidth / 8 );
-    int burstBits = mlog2( (busWidth * burstLength) / 8 );
-    lowColBits = burstBits - busOffsetBits;
+    CheckTables( );
 
-    /* first of all, truncate the bus offset bits */
-    refAddress = address >> busOffsetBits;
+    /* The same address is usually decoded again on its way to the channel. */
+    if( !lastValid || address != lastAddress )
+    {
+        for( int i = 0; i < 6; i++ )
+            lastFields[i] = ( address >> fieldShift[i] ) & fieldMask[i];
 
-    /* then, truncate the lowest column bits */
-    refAddress >>= lowColBits;
+        if( bankXORHash )
+            lastFields[MEM_BANK] ^= ( lastFields[MEM_ROW] & fieldMask[MEM_BANK] );
 
-    /* 0->4, low to high, FindOrder() will find the correct one */
-    for( int i = 0; i < 6; i++ )
-    {
-        FindOrder( i, &part );
+        if( channelXORHash )
+            lastFields[MEM_CHANNEL] ^= ( ( lastFields[MEM_ROW] >> channelHashShift ) 
+                                         & fieldMask[MEM_CHANNEL] );
 
-        /* 
-         *  The new memsize does not include this partition, so dividing by the
-         *  new memsize will give us the right channel/rank/bank/whatever.
-         */
-        *partitions[part] = Modulo( refAddress, part );
-
-        /*
-         *  "Mask off" the first partition number we got. For example if memsize = 1000
-         *  and the address is 8343, the partition would be 8, and we will look at 343 
-         *  to determine the rest of the address now.
-         */
-        refAddress = Divide( refAddress, part );
+        lastAddress = address;
+        lastValid = true;
     }
+
+    for( int i = 0; i < 6; i++ )
+        *partitions[i] = lastFields[i];
 } 
 
 uint64_t AddressTranslator::Translate( NVMainRequest *request )
@@ -323,6 +294,68 @@ void AddressTranslator::SetDefaultField( TranslationField f )
     defaultField = f;
 }
 
+/*
+ * BuildTables() lays the fields out from low to high order above the bus
+ * offset and low column bits, recording where each one starts and its mask
+ */
+void AddressTranslator::BuildTables( )
+{
+    unsigned bitWidths[6];
+    uint64_t shift;
+
+    method->GetBitWidths( &bitWidths[MEM_ROW], &bitWidths[MEM_COL], &bitWidths[MEM_BANK],
+                          &bitWidths[MEM_RANK], &bitWidths[MEM_CHANNEL], &bitWidths[MEM_SUBARRAY] );
+
+    int busOffsetBits = mlog2( busWidth / 8 );
+    int burstBits = mlog2( (busWidth * burstLength) / 8 );
+    lowColBits = burstBits - busOffsetBits;
+
+    /* first of all, skip the bus offset bits and the lowest column bits */
+    shift = busOffsetBits + lowColBits;
+
+    for( int i = 0; i < 6; i++ )
+    {
+        fieldShift[i] = 0;
+        fieldMask[i] = 0;
+        fieldMapped[i] = false;
+    }
+
+    /* 0->5, low to high, FindOrder() will find the correct one */
+    for( int i = 0; i < 6; i++ )
+    {
+        MemoryPartition part;
+
+        FindOrder( i, &part );
+
+        if( part == MEM_UNKNOWN )
+            continue;
+
+        /* Fields beyond the top of the address always decode to zero. */
+        if( shift < 64 )
+        {
+            fieldShift[part] = shift;
+            fieldMask[part] = ( bitWidths[part] < 64 ) ? ( (uint64_t(1) << bitWidths[part]) - 1 ) 
+                                                       : ~uint64_t(0);
+            fieldMapped[part] = true;
+        }
+
+        shift += bitWidths[part];
+    }
+
+    /* Use different row bits for the channel when the bank is also hashed. */
+    channelHashShift = bankXORHash ? bitWidths[MEM_BANK] : 0;
+
+    tableGeneration = method->GetGeneration( );
+    tablesValid = true;
+    lastValid = false;
+}
+
+void AddressTranslator::CheckTables( )
+{
+    if( !tablesValid || tableGeneration != method->GetGeneration( ) )
+        BuildTables( );
+}
+
 /*
  * Divide() right shift the physical address for address translation
  */
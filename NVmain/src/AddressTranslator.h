@@ -60,7 +60,7 @@ class AddressTranslator
     AddressTranslator( );
     virtual ~AddressTranslator( );
 
-    virtual void SetConfig( Config * /*config*/, bool /*createChildren*/ = true ) { }
+    virtual void SetConfig( Config *config, bool createChildren = true );
 
     void SetBusWidth( int );
     void SetBurstLength( int );
@@ -99,6 +99,34 @@ class AddressTranslator
     int burstLength;
     int lowColBits;
 
+    /*
+     *  Shift and mask of each field in a physical address, indexed by
+     *  MemoryPartition. Built from the translation method, bus width and
+     *  burst length on first use and again whenever any of them change.
+     */
+    bool tablesValid;
+    uint64_t tableGeneration;
+    uint64_t fieldShift[6];
+    uint64_t fieldMask[6];
+    bool fieldMapped[6];
+
+    /*
+     *  Optional permutation-based interleaving: the bank and/or channel are
+     *  XORed with the low row bits so rows that conflict in one bank are
+     *  spread across banks (channels).
+     */
+    bool bankXORHash;
+    bool channelXORHash;
+    uint64_t channelHashShift;
+
+    /* Fields of the last address decoded by Translate(). */
+    bool lastValid;
+    uint64_t lastAddress;
+    uint64_t lastFields[6];
+
+    void BuildTables( );
+    void CheckTables( );
+
     Stats *stats;
     std::string statName;
 
@@ -0,0 +1,327 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#include "src/CalendarEventQueue.h"
+#include "src/NVMObject.h"
+
+#include <limits>
+#include <assert.h>
+
+using namespace NVM;
+
+/* Number of events allocated at once when the event pool runs dry. */
+static const ncounter_t eventSlabSize = 256;
+
+CalendarEventQueue::CalendarEventQueue( ncounter_t bucketCount_ )
+{
+    /* Use a power-of-two ring of at least one bitmap word. */
+    bucketCount = 64;
+    while( bucketCount < bucketCount_ )
+        bucketCount <<= 1;
+
+    bucketMask = bucketCount - 1;
+    windowStart = 0;
+
+    buckets.assign( bucketCount, NULL );
+    occupied.assign( bucketCount / 64, 0 );
+
+    freeEvents = NULL;
+}
+
+CalendarEventQueue::~CalendarEventQueue( )
+{
+    std::vector<Event *>::iterator it;
+
+    for( it = eventSlabs.begin( ); it != eventSlabs.end( ); it++ )
+        delete [] (*it);
+}
+
+Event *CalendarEventQueue::AllocateEvent( )
+{
+    if( freeEvents == NULL )
+    {
+        Event *slab = new Event[eventSlabSize];
+
+        for( ncounter_t i = 0; i < eventSlabSize; i++ )
+        {
+            slab[i].next = freeEvents;
+            freeEvents = &slab[i];
+        }
+
+        eventSlabs.push_back( slab );
+    }
+
+    Event *event = freeEvents;
+    freeEvents = event->next;
+
+    *event = Event( );
+    event->pooled = true;
+
+    return event;
+}
+
+void CalendarEventQueue::FreeEvent( Event *event )
+{
+    UnindexEvent( event );
+
+    /* Events created outside of the queue are owned by the queue once inserted. */
+    if( !event->pooled )
+    {
+        delete event;
+        return;
+    }
+
+    event->next = freeEvents;
+    freeEvents = event;
+}
+
+bool CalendarEventQueue::InWindow( ncycle_t when ) const
+{
+    return (when >= windowStart && when - windowStart < bucketCount);
+}
+
+Event **CalendarEventQueue::GetBucket( ncycle_t when )
+{
+    if( InWindow( when ) )
+    {
+        ncounter_t index = when & bucketMask;
+
+        occupied[index >> 6] |= (1ULL << (index & 63));
+
+        return &buckets[index];
+    }
+
+    return &overflow[when];
+}
+
+Event *CalendarEventQueue::GetBucketHead( ncycle_t when ) const
+{
+    if( InWindow( when ) )
+        return buckets[when & bucketMask];
+
+    std::map<ncycle_t, Event *>::const_iterator it = overflow.find( when );
+
+    return (it == overflow.end( )) ? NULL : it->second;
+}
+
+void CalendarEventQueue::ReleaseBucket( ncycle_t when )
+{
+    if( InWindow( when ) )
+    {
+        ncounter_t index = when & bucketMask;
+
+        if( buckets[index] == NULL )
+            occupied[index >> 6] &= ~(1ULL << (index & 63));
+    }
+    else
+    {
+        std::map<ncycle_t, Event *>::iterator it = overflow.find( when );
+
+        if( it != overflow.end( ) && it->second == NULL )
+            overflow.erase( it );
+    }
+}
+
+void CalendarEventQueue::AdvanceWindow( ncycle_t start )
+{
+    /* 
+     *  Nothing pending is before start, so the buckets which are now part of
+     *  the window are empty. Pull any far-future events that fall inside.
+     */
+    windowStart = start;
+
+    std::map<ncycle_t, Event *>::iterator it = overflow.lower_bound( start );
+
+    while( it != overflow.end( ) && InWindow( it->first ) )
+    {
+        ncounter_t index = it->first & bucketMask;
+
+        assert( buckets[index] == NULL );
+
+        buckets[index] = it->second;
+        occupied[index >> 6] |= (1ULL << (index & 63));
+
+        overflow.erase( it++ );
+    }
+}
+
+ncycle_t CalendarEventQueue::FindNextCycle( ) const
+{
+    ncycle_t nextCycle = std::numeric_limits<ncycle_t>::max( );
+
+    if( !overflow.empty( ) )
+        nextCycle = overflow.begin( )->first;
+
+    /* Scan the ring starting at the window start, wrapping around once. */
+    ncounter_t words = occupied.size( );
+    ncounter_t startIndex = windowStart & bucketMask;
+    ncounter_t startWord = startIndex >> 6;
+    uint64_t bits = occupied[startWord] & (~0ULL << (startIndex & 63));
+
+    for( ncounter_t word = 0; word <= words; word++ )
+    {
+        if( bits != 0 )
+        {
+            ncounter_t index = ((startWord + word) % words) * 64 
+                             + __builtin_ctzll( bits );
+            ncycle_t ringCycle = windowStart + ((index - startIndex) & bucketMask);
+
+            if( ringCycle < nextCycle )
+                nextCycle = ringCycle;
+
+            break;
+        }
+
+        bits = occupied[(startWord + word + 1) % words];
+
+        /* Last pass revisits the low part of the starting word. */
+        if( word + 1 == words )
+            bits &= ~(~0ULL << (startIndex & 63));
+    }
+
+    return nextCycle;
+}
+
+void CalendarEventQueue::ScheduleEvent( Event *event, ncycle_t when, int priority )
+{
+    event->SetCycle( when );
+
+    /* 
+     *  Slide the window up to the current cycle if the event would not fit.
+     *  Nothing is pending before nextEventCycle, so this is always safe.
+     */
+    if( !InWindow( when ) && when > windowStart )
+    {
+        ncycle_t start = (currentCycle < nextEventCycle) ? currentCycle : nextEventCycle;
+
+        if( start > windowStart )
+            AdvanceWindow( start );
+    }
+
+    if( when < nextEventCycle )
+    {
+        nextEventCycle = when;
+    }
+
+    /* 
+     *  Same placement as the list-based queue: in front of the first event
+     *  whose priority is greater than the insertion priority.
+     */
+    Event **link = GetBucket( when );
+
+    while( (*link) != NULL && (*link)->GetPriority( ) <= priority )
+        link = &((*link)->next);
+
+    event->next = (*link);
+    (*link) = event;
+
+    IndexEvent( event );
+}
+
+bool CalendarEventQueue::RemoveEvent( Event *event, ncycle_t when )
+{
+    Event **link = NULL;
+
+    if( InWindow( when ) )
+    {
+        link = &buckets[when & bucketMask];
+    }
+    else
+    {
+        std::map<ncycle_t, Event *>::iterator it = overflow.find( when );
+
+        if( it == overflow.end( ) )
+            return false;
+
+        link = &(it->second);
+    }
+
+    while( (*link) != NULL && (*link) != event )
+        link = &((*link)->next);
+
+    if( (*link) == NULL )
+        return false;
+
+    (*link) = event->next;
+    event->next = NULL;
+
+    UnindexEvent( event );
+
+    if( GetBucketHead( when ) == NULL )
+    {
+        ReleaseBucket( when );
+
+        if( when == nextEventCycle )
+            nextEventCycle = FindNextCycle( );
+    }
+
+    return true;
+}
+
+void CalendarEventQueue::Process( )
+{
+    ncycle_t processCycle = nextEventCycle;
+
+    assert( processCycle != std::numeric_limits<ncycle_t>::max( ) );
+
+    if( processCycle > windowStart )
+        AdvanceWindow( processCycle );
+
+    /* 
+     *  Events inserted into this cycle while it is processed are visited if
+     *  they land behind the current event, as with the list-based queue.
+     */
+    Event **head = GetBucket( processCycle );
+
+    assert( (*head) != NULL );
+
+    for( Event *event = (*head); event != NULL; event = event->next )
+    {
+        DispatchEvent( event );
+    }
+
+    /* Figure out the next cycle before freeing the events of this one. */
+    Event *event = (*head);
+    (*head) = NULL;
+    ReleaseBucket( processCycle );
+
+    while( event != NULL )
+    {
+        Event *nextEvent = event->next;
+        FreeEvent( event );
+        event = nextEvent;
+    }
+
+    lastEventCycle = processCycle;
+    nextEventCycle = FindNextCycle( );
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#ifndef __NVMAIN_CALENDAREVENTQUEUE_H__
+#define __NVMAIN_CALENDAREVENTQUEUE_H__
+
+#include <map>
+#include <vector>
+#include "src/EventQueue.h"
+
+namespace NVM {
+
+/*
+ *  Calendar queue variant of the event queue. Events in the near future are
+ *  kept in a ring of per-cycle buckets indexed by (cycle % buckets), events
+ *  beyond the ring fall back to a map of per-cycle buckets and are moved into
+ *  the ring as the window advances. A bitmap of non-empty buckets is used to
+ *  locate the next event cycle.
+ *
+ *  Each bucket is an intrusive singly-linked list ordered with exactly the
+ *  same rule as the default EventQueue, so event ordering within a cycle
+ *  (including events inserted while the cycle is being processed) is
+ *  identical. Events created by the queue are recycled through a free list.
+ */
+class CalendarEventQueue : public EventQueue
+{
+  public:
+    CalendarEventQueue( ncounter_t buckets = 1024 );
+    ~CalendarEventQueue( );
+
+    bool RemoveEvent( Event *event, ncycle_t when );
+
+    void Process( );
+
+  protected:
+    Event *AllocateEvent( );
+    void ScheduleEvent( Event *event, ncycle_t when, int priority );
+
+  private:
+    ncounter_t bucketCount;
+    ncounter_t bucketMask;
+    ncycle_t windowStart;
+
+    std::vector<Event *> buckets;
+    std::vector<uint64_t> occupied;
+    std::map<ncycle_t, Event *> overflow;
+
+    Event *freeEvents;
+    std::vector<Event *> eventSlabs;
+
+    bool InWindow( ncycle_t when ) const;
+    Event **GetBucket( ncycle_t when );
+    Event *GetBucketHead( ncycle_t when ) const;
+    void ReleaseBucket( ncycle_t when );
+    void AdvanceWindow( ncycle_t start );
+    ncycle_t FindNextCycle( ) const;
+    void FreeEvent( Event *event );
+};
+
+};
+
+#endif
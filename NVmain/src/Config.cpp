@@ -40,6 +40,7 @@
 #include <assert.h>
 #include <limits>
 #include "src/Config.h"
+#include "src/Debug.h"
 
 using namespace NVM;
 
@@ -47,11 +48,14 @@ Config::Config( )
 {
     simPtr = NULL;
     useDebugLog = false;
+    sealed = false;
+    debugInhibitor = new nullstream( );
 }
 
 
 Config::~Config( )
 {
+    delete debugInhibitor;
 }
 
 Config::Config(const Config& conf)
@@ -66,6 +70,9 @@ Config::Config(const Config& conf)
 
     fileName = conf.fileName;
     simPtr = conf.simPtr;
+    useDebugLog = false;
+    sealed = false;
+    debugInhibitor = new nullstream( );
 
     std::vector<std::string> tmpVec(conf.hookList);
     std::vector<std::string>::iterator vit;
@@ -179,10 +186,23 @@ void Config::Read( std::string filename )
     SetDebugLog( );
 }
 
+void Config::Seal( )
+{
+    sealed = true;
+}
+
 bool Config::KeyExists( std::string key )
 {
     std::map<std::string, std::string>::iterator i;
 
+#ifndef NDEBUG
+    if( sealed && lateKeys.insert( key ).second )
+    {
+        std::cerr << "Config: Warning: Key " << key << " was looked up after "
+                  << "configuration finished. Read it in SetConfig instead." << std::endl;
+    }
+#endif
+
     if( values.empty( ) )
         return false;
 
@@ -494,6 +514,11 @@ void Config::SetDebugLog( )
     }
 }
 
+std::ostream *Config::GetDebugInhibitor( )
+{
+    return debugInhibitor;
+}
+
 std::ostream *Config::GetDebugLog( )
 {
     if( useDebugLog )
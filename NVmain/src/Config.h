@@ -44,6 +44,8 @@
 
 namespace NVM {
 
+class nullstream;
+
 class Config 
 {
   public:
@@ -75,6 +77,13 @@ class Config
 
     bool KeyExists( std::string key );
 
+    /*
+     *  Called once the memory system is configured. Lookups belong in
+     *  SetConfig (see Params), so debug builds warn the first time each key
+     *  is looked up after this.
+     */
+    void Seal( );
+
     std::vector<std::string>& GetHooks( );
 
     void Print( );
@@ -89,14 +98,23 @@ class Config
     void SetDebugLog( );
     std::ostream *GetDebugLog( );
 
+    /* 
+     *  Sink for disabled debug output. Each channel has its own config, so
+     *  channels running on separate threads never share stream state.
+     */
+    std::ostream *GetDebugInhibitor( );
+
   private:
     std::string fileName;
     std::map<std::string, std::string> values;
     std::set<std::string> warned;
+    std::set<std::string> lateKeys;
+    bool sealed;
     std::vector<std::string> hookList;
     SimInterface *simPtr;
     std::ofstream debugLogFile;
     bool useDebugLog;
+    nullstream *debugInhibitor;
 
 };
 
@@ -50,8 +50,6 @@ nullstream& operator<<( nullstream& s, T const& ) { return s; }
 
 //nullstream& operator<<( nullstream& s, std::ostream &(std::ostream&));
 
-static nullstream nvmainDebugInhibitor;
-
 };
 
 
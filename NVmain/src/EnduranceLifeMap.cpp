@@ -0,0 +1,217 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#include "src/EnduranceLifeMap.h"
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+using namespace NVM;
+
+EnduranceLifeMap::EnduranceLifeMap( )
+{
+    lastPage = NULL;
+
+    clear( );
+}
+
+EnduranceLifeMap::~EnduranceLifeMap( )
+{
+    clear( );
+}
+
+void EnduranceLifeMap::clear( )
+{
+    std::unordered_map<uint64_t, uint32_t *>::iterator it;
+
+    for( it = pages.begin( ); it != pages.end( ); ++it )
+        delete [] it->second;
+
+    pages.clear( );
+    wideLives.clear( );
+
+    lastPageNumber = 0;
+    lastPage = NULL;
+
+    cells = 0;
+    totalLife = 0;
+    worstLife = std::numeric_limits<uint64_t>::max( );
+
+    for( int i = 0; i < histogramBuckets; i++ )
+        histogram[i] = 0;
+}
+
+uint64_t EnduranceLifeMap::size( ) const
+{
+    return cells;
+}
+
+uint32_t *EnduranceLifeMap::GetPage( uint64_t key, bool allocate )
+{
+    uint64_t pageNumber = key >> pageBits;
+
+    /* Writes to a word hit the same page over and over. */
+    if( lastPage != NULL && lastPageNumber == pageNumber )
+        return lastPage;
+
+    std::unordered_map<uint64_t, uint32_t *>::iterator it = pages.find( pageNumber );
+    uint32_t *page = NULL;
+
+    if( it != pages.end( ) )
+    {
+        page = it->second;
+    }
+    else if( allocate )
+    {
+        page = new uint32_t[pageCells];
+        memset( page, 0xFF, pageCells * sizeof(uint32_t) );
+
+        pages[pageNumber] = page;
+    }
+
+    if( page != NULL )
+    {
+        lastPageNumber = pageNumber;
+        lastPage = page;
+    }
+
+    return page;
+}
+
+int EnduranceLifeMap::Bucket( uint64_t life )
+{
+    return (life == 0) ? 0 : 64 - __builtin_clzll( life );
+}
+
+void EnduranceLifeMap::StoreLife( uint32_t *cell, uint64_t key, uint64_t life )
+{
+    if( life >= wideCell )
+    {
+        *cell = wideCell;
+        wideLives[key] = life;
+    }
+    else
+    {
+        if( *cell == wideCell )
+            wideLives.erase( key );
+
+        *cell = static_cast<uint32_t>( life );
+    }
+}
+
+bool EnduranceLifeMap::Find( uint64_t key, uint64_t& life )
+{
+    uint32_t *page = GetPage( key, false );
+
+    if( page == NULL || page[key & (pageCells - 1)] == emptyCell )
+        return false;
+
+    uint32_t cell = page[key & (pageCells - 1)];
+
+    life = (cell == wideCell) ? wideLives[key] : cell;
+
+    return true;
+}
+
+void EnduranceLifeMap::Insert( uint64_t key, uint64_t life )
+{
+    uint32_t *cell = GetPage( key, true ) + (key & (pageCells - 1));
+
+    assert( *cell == emptyCell );
+
+    StoreLife( cell, key, life );
+
+    cells++;
+    totalLife += life;
+    histogram[Bucket( life )]++;
+
+    if( life < worstLife )
+        worstLife = life;
+}
+
+void EnduranceLifeMap::Decrement( uint64_t key )
+{
+    uint32_t *cell = GetPage( key, false ) + (key & (pageCells - 1));
+    uint64_t life = (*cell == wideCell) ? wideLives[key] : *cell;
+
+    assert( *cell != emptyCell && life != 0 );
+
+    StoreLife( cell, key, life - 1 );
+
+    totalLife--;
+
+    if( Bucket( life ) != Bucket( life - 1 ) )
+    {
+        histogram[Bucket( life )]--;
+        histogram[Bucket( life - 1 )]++;
+    }
+
+    /* Lives only go down, so the worst life can be tracked exactly. */
+    if( life - 1 < worstLife )
+        worstLife = life - 1;
+}
+
+uint64_t EnduranceLifeMap::GetWorstLife( ) const
+{
+    return worstLife;
+}
+
+uint64_t EnduranceLifeMap::GetAverageLife( ) const
+{
+    return (cells != 0) ? (totalLife / cells) : 0;
+}
+
+void EnduranceLifeMap::GetHistogram( std::map<uint64_t, uint64_t>& hist ) const
+{
+    hist.clear( );
+
+    /* Each bucket is keyed by the smallest life it holds. */
+    for( int i = 0; i < histogramBuckets; i++ )
+    {
+        if( histogram[i] != 0 )
+            hist[(i == 0) ? 0 : (1ULL << (i - 1))] = histogram[i];
+    }
+}
+
+uint64_t EnduranceLifeMap::GetMemoryUsage( ) const
+{
+    /* Hash table nodes hold the key, the value and a next pointer. */
+    uint64_t pageNode = sizeof(void *) + sizeof(uint64_t) + sizeof(uint32_t *);
+    uint64_t wideNode = sizeof(void *) + 2 * sizeof(uint64_t);
+
+    return pages.size( ) * (pageCells * sizeof(uint32_t) + pageNode)
+         + pages.bucket_count( ) * sizeof(void *)
+         + wideLives.size( ) * wideNode 
+         + wideLives.bucket_count( ) * sizeof(void *);
+}
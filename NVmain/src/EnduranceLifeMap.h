@@ -0,0 +1,109 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#ifndef __ENDURANCELIFEMAP_H__
+#define __ENDURANCELIFEMAP_H__
+
+#include <map>
+#include <stdint.h>
+#include <unordered_map>
+
+namespace NVM {
+
+/*
+ *  Remaining life of each cell tracked by an endurance model. Keys are
+ *  grouped into pages of consecutive keys holding 32-bit counters, and a
+ *  page is only allocated once one of its cells is written. Keys built
+ *  from row and column are dense within a row, so this takes 4 bytes per
+ *  cell instead of a tree node per cell. Lives that do not fit in 32 bits
+ *  are kept in a side table.
+ *
+ *  The worst life, total life and a histogram of remaining life are kept
+ *  up to date as cells are inserted and decremented so reporting them does
+ *  not need to scan the map.
+ */
+class EnduranceLifeMap
+{
+  public:
+    EnduranceLifeMap( );
+    ~EnduranceLifeMap( );
+
+    void clear( );
+    uint64_t size( ) const;
+
+    /* Returns false if key has not been written yet. */
+    bool Find( uint64_t key, uint64_t& life );
+    /* Adds a cell that has not been written yet. */
+    void Insert( uint64_t key, uint64_t life );
+    /* Removes one write from a cell with life left. */
+    void Decrement( uint64_t key );
+
+    /* Maximum uint64_t value if no cells have been written. */
+    uint64_t GetWorstLife( ) const;
+    uint64_t GetAverageLife( ) const;
+
+    /* Number of cells per power of two range of remaining life. */
+    void GetHistogram( std::map<uint64_t, uint64_t>& histogram ) const;
+
+    /* Approximate number of bytes of host memory used. */
+    uint64_t GetMemoryUsage( ) const;
+
+  private:
+    static const uint64_t pageBits = 10;
+    static const uint64_t pageCells = 1ULL << pageBits;
+    static const uint32_t emptyCell = 0xFFFFFFFF;
+    static const uint32_t wideCell = 0xFFFFFFFE;
+    static const int histogramBuckets = 65;
+
+    std::unordered_map<uint64_t, uint32_t *> pages;
+    std::unordered_map<uint64_t, uint64_t> wideLives;
+
+    uint64_t lastPageNumber;
+    uint32_t *lastPage;
+
+    uint64_t cells;
+    uint64_t totalLife;
+    uint64_t worstLife;
+    uint64_t histogram[histogramBuckets];
+
+    uint32_t *GetPage( uint64_t key, bool allocate );
+    void StoreLife( uint32_t *cell, uint64_t key, uint64_t life );
+    static int Bucket( uint64_t life );
+
+    EnduranceLifeMap( const EnduranceLifeMap& );
+    EnduranceLifeMap& operator=( const EnduranceLifeMap& );
+};
+
+};
+
+#endif
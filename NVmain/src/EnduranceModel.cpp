@@ -35,7 +35,6 @@
 #include "Endurance/EnduranceDistributionFactory.h"
 #include "src/FaultModel.h"
 #include <iostream>
-#include <limits>
 
 using namespace NVM;
 
@@ -59,56 +58,45 @@ void EnduranceModel::SetConfig( Config *config, bool /*createChildren*/ )
  */
 uint64_t EnduranceModel::GetWorstLife( )
 {
-    std::map<uint64_t, uint64_t>::iterator i;
-    uint64_t min = std::numeric_limits< uint64_t >::max( );
-
-    for( i = life.begin( ); i != life.end( ); i++ )
-    {
-        if( i->second < min )
-            min = i->second;
-    }
-
-    return min;
+    return life.GetWorstLife( );
 }
 
 /*
- *  Finds the worst life in the life map. If you do not use the life
- *  map, you will need to overload this function to return the worst
- *  case life for statistics reporting.
+ *  Finds the average life in the life map. If you do not use the life
+ *  map, you will need to overload this function to return the average
+ *  life for statistics reporting.
  */
 uint64_t EnduranceModel::GetAverageLife( )
 {
-    std::map<uint64_t, uint64_t>::iterator i;
-    uint64_t total = 0;
-    uint64_t average = 0;
-
-    for( i = life.begin( ); i != life.end( ); i++ )
-        total += i->second;
+    return life.GetAverageLife( );
+}
 
-    if( life.size( ) != 0 )
-        average = total / life.size( );
-    else
-        average = 0;
+void EnduranceModel::GetLifeHistogram( std::map<uint64_t, uint64_t>& histogram )
+{
+    life.GetHistogram( histogram );
+}
 
-    return average;
+uint64_t EnduranceModel::GetLifeMemoryUsage( )
+{
+    return life.GetMemoryUsage( );
 }
 
 bool EnduranceModel::DecrementLife( uint64_t addr )
 {
-    std::map<uint64_t, uint64_t>::iterator i = life.find( addr );
+    uint64_t remaining;
     bool rv = true;
 
-    if( i == life.end( ) )
+    if( !life.Find( addr, remaining ) )
     {
           /* Generate a random number using the specified distribution */
-          life.insert( std::pair<uint64_t, uint64_t>( addr, enduranceDist->GetEndurance( ) ) );
+          life.Insert( addr, enduranceDist->GetEndurance( ) );
     }
     else
     {
         /* If the life is 0, leave it at that.  */
-        if( i->second != 0 )
+        if( remaining != 0 )
         {
-            i->second = i->second - 1;
+            life.Decrement( addr );
         }
         else
         {
@@ -121,17 +109,16 @@ bool EnduranceModel::DecrementLife( uint64_t addr )
 
 bool EnduranceModel::IsDead( uint64_t addr )
 {
-    std::map<uint64_t, uint64_t>::iterator i = life.find( addr );
+    uint64_t remaining;
     bool rv = false;
 
-    if( i != life.end( ) && i->second == 0 )
+    if( life.Find( addr, remaining ) && remaining == 0 )
     {
         rv = true;
     }
 
     return rv;
 }
-
 void EnduranceModel::SetGranularity( uint64_t bits )
 {
     granularity = bits;
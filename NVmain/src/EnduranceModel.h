@@ -41,6 +41,7 @@
 #include "src/Params.h"
 #include "src/NVMObject.h"
 #include "src/EnduranceDistribution.h"
+#include "src/EnduranceLifeMap.h"
 #include "include/NVMDataBlock.h"
 #include "include/NVMAddress.h"
 #include "src/FaultModel.h"
@@ -64,6 +65,8 @@ class EnduranceModel : public NVMObject
 
     uint64_t GetWorstLife( );
     uint64_t GetAverageLife( );
+    void GetLifeHistogram( std::map<uint64_t, uint64_t>& histogram );
+    uint64_t GetLifeMemoryUsage( );
 
     virtual void PrintStats( ) { }
 
@@ -71,7 +74,7 @@ class EnduranceModel : public NVMObject
 
   protected:
     EnduranceDistribution *enduranceDist;
-    std::map<uint64_t, uint64_t> life;
+    EnduranceLifeMap life;
     
     bool DecrementLife( uint64_t addr );
     bool IsDead( uint64_t addr );
@@ -35,7 +35,9 @@
 #include "src/NVMObject.h"
 #include "src/Config.h"
 #include "NVM/nvmain.h"
+#include "src/PartitionWorkers.h"
 
+#include <algorithm>
 #include <limits>
 #include <assert.h>
 
@@ -43,18 +45,7 @@ using namespace NVM;
 
 void Event::SetRecipient( NVMObject *r )
 {
-    std::vector<NVMObject_hook *>& children = r->GetParent( )->GetTrampoline( )->GetChildren( );
-    std::vector<NVMObject_hook *>::iterator it;
-    NVMObject_hook *hook = NULL;
-
-    for( it = children.begin(); it != children.end(); it++ )
-    {
-        if( (*it)->GetTrampoline() == r )
-        {
-            hook = (*it);
-            break;
-        }
-    }
+    NVMObject_hook *hook = r->GetSelfHook( );
 
     assert( hook != NULL );
 
@@ -67,27 +58,94 @@ EventQueue::EventQueue( )
     lastEventCycle = 0;
     nextEventCycle = std::numeric_limits<ncycle_t>::max();
     currentCycle = 0;
+    frequency = 0.0;
+
+    partitionWorkers = NULL;
+    partitionRecipient = NULL;
+    partitionMethod = NULL;
+    advancingPartitions = false;
+
+    eventIndex.assign( 256, NULL );
+    eventIndexMask = eventIndex.size( ) - 1;
+    indexedEvents = 0;
 }
 
 EventQueue::~EventQueue( )
 {
+    delete partitionWorkers;
 }
 
-void EventQueue::InsertEvent( EventType type, NVMObject *recipient, ncycle_t when, void *data, int priority )
+ncounter_t EventQueue::IndexSlot( NVMObject *recipient, ncycle_t when ) const
 {
-    /* The parent has our hook in the children list, we need to find this. */
-    std::vector<NVMObject_hook *>& children = recipient->GetParent( )->GetTrampoline( )->GetChildren( );
-    std::vector<NVMObject_hook *>::iterator it;
-    NVMObject_hook *hook = NULL;
+    uint64_t key = reinterpret_cast<uintptr_t>(recipient) 
+                 ^ (when * 0x9E3779B97F4A7C15ULL);
+
+    key ^= (key >> 29);
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= (key >> 32);
 
-    for( it = children.begin(); it != children.end(); it++ )
+    return key & eventIndexMask;
+}
+
+void EventQueue::GrowIndex( )
+{
+    std::vector<Event *> oldIndex;
+
+    oldIndex.swap( eventIndex );
+    eventIndex.assign( oldIndex.size( ) * 2, NULL );
+    eventIndexMask = eventIndex.size( ) - 1;
+
+    for( size_t slot = 0; slot < oldIndex.size( ); slot++ )
     {
-        if( (*it)->GetTrampoline() == recipient )
+        Event *event = oldIndex[slot];
+
+        while( event != NULL )
         {
-            hook = (*it);
-            break;
+            Event *nextEvent = event->indexNext;
+            ncounter_t newSlot = IndexSlot( event->recipient->GetTrampoline( ), 
+                                            event->cycle );
+
+            event->indexNext = eventIndex[newSlot];
+            eventIndex[newSlot] = event;
+
+            event = nextEvent;
         }
     }
+}
+
+void EventQueue::IndexEvent( Event *event )
+{
+    assert( event->recipient != NULL );
+
+    if( indexedEvents >= eventIndex.size( ) )
+        GrowIndex( );
+
+    ncounter_t slot = IndexSlot( event->recipient->GetTrampoline( ), event->cycle );
+
+    event->indexNext = eventIndex[slot];
+    eventIndex[slot] = event;
+    indexedEvents++;
+}
+
+void EventQueue::UnindexEvent( Event *event )
+{
+    ncounter_t slot = IndexSlot( event->recipient->GetTrampoline( ), event->cycle );
+    Event **link = &eventIndex[slot];
+
+    while( (*link) != NULL && (*link) != event )
+        link = &((*link)->indexNext);
+
+    if( (*link) != NULL )
+    {
+        (*link) = event->indexNext;
+        event->indexNext = NULL;
+        indexedEvents--;
+    }
+}
+
+void EventQueue::InsertEvent( EventType type, NVMObject *recipient, ncycle_t when, void *data, int priority )
+{
+    NVMObject_hook *hook = recipient->GetSelfHook( );
 
     assert( hook != NULL );
 
@@ -101,19 +159,7 @@ void EventQueue::InsertEvent( EventType type, NVMObject_hook *recipient, ncycle_
 
 void EventQueue::InsertEvent( EventType type, NVMObject *recipient, NVMainRequest *req, ncycle_t when, void *data, int priority )
 {
-    /* The parent has our hook in the children list, we need to find this. */
-    std::vector<NVMObject_hook *>& children = recipient->GetParent( )->GetTrampoline( )->GetChildren( );
-    std::vector<NVMObject_hook *>::iterator it;
-    NVMObject_hook *hook = NULL;
-
-    for( it = children.begin(); it != children.end(); it++ )
-    {
-        if( (*it)->GetTrampoline() == recipient )
-        {
-            hook = (*it);
-            break;
-        }
-    }
+    NVMObject_hook *hook = recipient->GetSelfHook( );
 
     assert( hook != NULL );
 
@@ -123,7 +169,7 @@ void EventQueue::InsertEvent( EventType type, NVMObject *recipient, NVMainReques
 void EventQueue::InsertEvent( EventType type, NVMObject_hook *recipient, NVMainRequest *req, ncycle_t when, void *data, int priority )
 {
     /* Create our event */
-    Event *event = new Event( );
+    Event *event = AllocateEvent( );
 
     event->SetType( type );
     event->SetRecipient( recipient );
@@ -135,8 +181,19 @@ void EventQueue::InsertEvent( EventType type, NVMObject_hook *recipient, NVMainR
 }
 
 void EventQueue::InsertEvent( Event *event, ncycle_t when, int priority )
+{
+    ScheduleEvent( event, when, priority );
+}
+
+Event *EventQueue::AllocateEvent( )
+{
+    return new Event( );
+}
+
+void EventQueue::ScheduleEvent( Event *event, ncycle_t when, int priority )
 {
     event->SetCycle( when );
+    IndexEvent( event );
 
     /* If this event time is before our previous nextEventCycle, change it. */
     if( when < nextEventCycle )
@@ -182,7 +239,7 @@ void EventQueue::InsertEvent( Event *event, ncycle_t when, int priority )
 void EventQueue::InsertCallback( NVMObject *recipient, CallbackPtr method,
                                  ncycle_t when, void *data, int priority )
 {
-    Event *event = new Event( );
+    Event *event = AllocateEvent( );
 
     event->SetType( EventCallback );
     event->SetRecipient( recipient );
@@ -213,6 +270,7 @@ bool EventQueue::RemoveEvent( Event *event, ncycle_t when )
             if( (*it) == event )
             {
                 eventList.erase( it );
+                UnindexEvent( event );
 
                 rv = true;
 
@@ -240,19 +298,7 @@ bool EventQueue::RemoveEvent( Event *event, ncycle_t when )
 
 Event *EventQueue::FindEvent( EventType type, NVMObject *recipient, NVMainRequest *req, ncycle_t when ) const
 {
-    /* The parent has our hook in the children list, we need to find this. */
-    std::vector<NVMObject_hook *>& children = recipient->GetParent( )->GetTrampoline( )->GetChildren( );
-    std::vector<NVMObject_hook *>::iterator it;
-    NVMObject_hook *hook = NULL;
-
-    for( it = children.begin(); it != children.end(); it++ )
-    {
-        if( (*it)->GetTrampoline() == recipient )
-        {
-            hook = (*it);
-            break;
-        }
-    }
+    NVMObject_hook *hook = recipient->GetSelfHook( );
 
     assert( hook != NULL );
 
@@ -262,50 +308,38 @@ Event *EventQueue::FindEvent( EventType type, NVMObject *recipient, NVMainReques
 
 Event *EventQueue::FindEvent( EventType type, NVMObject_hook *recipient, NVMainRequest *req, ncycle_t when ) const
 {
-    Event *rv = NULL;
+    Event *event = eventIndex[IndexSlot( recipient->GetTrampoline( ), when )];
 
-    if (eventMap.count(when) == 0) {
-        return rv;
-    } else {
-        const EventList& eventList = eventMap.find(when)->second;
-
-        EventList::const_iterator it;
-        for( it = eventList.begin(); it != eventList.end(); it++ )
+    for( ; event != NULL; event = event->indexNext )
+    {
+        if( event->GetCycle( ) == when && event->GetType( ) == type 
+            && event->GetRecipient( ) == recipient && event->GetRequest( ) == req )
         {
-            if( (*it)->GetType( ) == type && (*it)->GetRecipient( ) == recipient
-                && (*it)->GetRequest( ) == req )
-            {
-                rv = (*it);
-            }
+            break;
         }
-        return rv;
     }
+
+    return event;
 }
 
 
 Event *EventQueue::FindCallback( NVMObject *recipient, CallbackPtr method, ncycle_t when, void *data, int priority ) const
 {
-    Event *rv = NULL;
+    Event *event = eventIndex[IndexSlot( recipient, when )];
 
-    if( eventMap.count(when) != 0 )
+    for( ; event != NULL; event = event->indexNext )
     {
-        const EventList& eventList = eventMap.find(when)->second;
-
-        EventList::const_iterator it;
-        for( it = eventList.begin(); it != eventList.end(); it++ )
+        if( event->GetCycle( ) == when
+            && event->GetRecipient()->GetTrampoline() == recipient
+            && event->GetCallback() == method
+            && event->GetData() == data 
+            && event->GetPriority() == priority )
         {
-            if( (*it)->GetRecipient()->GetTrampoline() == recipient
-                && (*it)->GetCallback() == method
-                && (*it)->GetData() == data 
-                && (*it)->GetPriority() == priority )
-            {
-                rv = (*it);
-                break;
-            }
+            break;
         }
     }
 
-    return rv;
+    return event;
 }
 
 
@@ -317,6 +351,13 @@ void EventQueue::Loop( )
      * guarantee that the event that is inserted in current cycle and must
      * be handled in current cycle can be processed.
      */  
+    if( !partitions.empty( ) )
+    {
+        LoopPartitioned( 0 );
+        SetCurrentCycle( currentCycle + 1 );
+        return;
+    }
+
     if( nextEventCycle == currentCycle )
         Process( );
 
@@ -326,6 +367,12 @@ void EventQueue::Loop( )
 
 void EventQueue::Loop( ncycle_t steps )
 {
+    if( !partitions.empty( ) )
+    {
+        LoopPartitioned( steps );
+        return;
+    }
+
     /* Special case. */
     if( steps == 0 && nextEventCycle == currentCycle )
     {
@@ -365,39 +412,16 @@ void EventQueue::Process( )
 
     for( it = eventList.begin( ); it != eventList.end( ); it++ )
     {
-        switch( (*it)->GetType( ) )
-        {
-            case EventCycle:
-                (*it)->GetRecipient( )->Cycle( nextEventCycle - lastEventCycle );
-                break;
-
-            case EventIdle:
-                // TODO: Add this
-                break;
-
-            case EventRequest:
-                // TODO: Add this
-                break;
-
-            case EventResponse:
-                (*it)->GetRecipient( )->RequestComplete( (*it)->GetRequest( ) );
-                break;
-
-            case EventCallback:
-            {
-                CallbackPtr cb = (*it)->GetCallback( );
-                NVMObject *thisPtr = (*it)->GetRecipient( )->GetTrampoline( );
-                (*thisPtr.*cb)( (*it)->GetData() );
-                break;
-            }
-
-            case EventUnknown:
-                // TODO: Add this
-            default:
-                break;
-        }
+        DispatchEvent( (*it) );
+    }
 
-        /* Free event data */
+    /* 
+     *  Free event data once the whole cycle is done, so duplicate checks made
+     *  during this cycle still see the events that were already handled.
+     */
+    for( it = eventList.begin( ); it != eventList.end( ); it++ )
+    {
+        UnindexEvent( (*it) );
         delete (*it);
     }
 
@@ -417,9 +441,135 @@ void EventQueue::Process( )
     }
 }
 
+void EventQueue::DispatchEvent( Event *event )
+{
+    switch( event->GetType( ) )
+    {
+        case EventCycle:
+            event->GetRecipient( )->Cycle( nextEventCycle - lastEventCycle );
+            break;
+
+        case EventIdle:
+            // TODO: Add this
+            break;
+
+        case EventRequest:
+            // TODO: Add this
+            break;
+
+        case EventResponse:
+            event->GetRecipient( )->RequestComplete( event->GetRequest( ) );
+            break;
+
+        case EventCallback:
+        {
+            CallbackPtr cb = event->GetCallback( );
+            NVMObject *thisPtr = event->GetRecipient( )->GetTrampoline( );
+            (*thisPtr.*cb)( event->GetData() );
+            break;
+        }
+
+        case EventUnknown:
+            // TODO: Add this
+        default:
+            break;
+    }
+}
+
+void EventQueue::LoopPartitioned( ncycle_t steps )
+{
+    ncycle_t targetCycle = currentCycle + steps;
+
+    /* 
+     *  Partition events up to one of our own events are handled before it;
+     *  without own events the whole step is a single window.
+     */
+    for( ;; )
+    {
+        ncycle_t windowEnd = std::min( nextEventCycle, targetCycle );
+
+        AdvancePartitions( windowEnd );
+        currentCycle = windowEnd;
+
+        if( nextEventCycle == currentCycle )
+            Process( );
+
+        if( currentCycle >= targetCycle )
+            break;
+    }
+}
+
+void EventQueue::AdvancePartitions( ncycle_t when )
+{
+    std::vector<EventQueue *>::iterator it;
+
+    busyPartitions.clear( );
+
+    for( it = partitions.begin( ); it != partitions.end( ); it++ )
+    {
+        if( (*it)->GetNextEvent( ) <= when )
+            busyPartitions.push_back( *it );
+        else
+            (*it)->SetCurrentCycle( when );
+    }
+
+    if( busyPartitions.empty( ) )
+        return;
+
+    advancingPartitions = true;
+
+    /* Handing a single channel to a worker would only add a round trip. */
+    if( partitionWorkers != NULL && busyPartitions.size( ) > 1 )
+    {
+        partitionWorkers->Advance( busyPartitions, when );
+    }
+    else
+    {
+        for( it = busyPartitions.begin( ); it != busyPartitions.end( ); it++ )
+            (*it)->Loop( when - (*it)->GetCurrentCycle( ) );
+    }
+
+    advancingPartitions = false;
+
+    if( partitionRecipient != NULL )
+        (*partitionRecipient.*partitionMethod)( NULL );
+}
+
+void EventQueue::AddPartition( EventQueue *partition )
+{
+    partition->SetCurrentCycle( currentCycle );
+    partition->SetFrequency( frequency );
+
+    partitions.push_back( partition );
+}
+
+void EventQueue::SetPartitionThreads( ncounter_t threads )
+{
+    delete partitionWorkers;
+    partitionWorkers = NULL;
+
+    if( threads > 1 )
+        partitionWorkers = new PartitionWorkers( threads );
+}
+
+void EventQueue::SetPartitionCallback( NVMObject *recipient, CallbackPtr method )
+{
+    partitionRecipient = recipient;
+    partitionMethod = method;
+}
+
+bool EventQueue::AdvancingPartitions( ) const
+{
+    return advancingPartitions;
+}
+
 void EventQueue::SetFrequency( double freq )
 {
     frequency = freq;
+
+    std::vector<EventQueue *>::iterator it;
+    for( it = partitions.begin( ); it != partitions.end( ); it++ )
+        (*it)->SetFrequency( freq );
 }
 
 double EventQueue::GetFrequency( )
@@ -429,7 +579,13 @@ double EventQueue::GetFrequency( )
 
 ncycle_t EventQueue::GetNextEvent( )
 {
-    return nextEventCycle;
+    ncycle_t nextEvent = nextEventCycle;
+
+    std::vector<EventQueue *>::iterator it;
+    for( it = partitions.begin( ); it != partitions.end( ); it++ )
+        nextEvent = std::min( nextEvent, (*it)->GetNextEvent( ) );
+
+    return nextEvent;
 }
 
 ncycle_t EventQueue::GetCurrentCycle( )
@@ -440,12 +596,17 @@ ncycle_t EventQueue::GetCurrentCycle( )
 void EventQueue::SetCurrentCycle( ncycle_t curCycle )
 {
     currentCycle = curCycle;
+
+    std::vector<EventQueue *>::iterator it;
+    for( it = partitions.begin( ); it != partitions.end( ); it++ )
+        (*it)->SetCurrentCycle( curCycle );
 }
 
 
 GlobalEventQueue::GlobalEventQueue( )
 {
     currentCycle = 0;
+    frequency = 0.0;
 }
 
 GlobalEventQueue::~GlobalEventQueue( )
@@ -465,7 +626,13 @@ void GlobalEventQueue::AddSystem( NVMain *subSystem, Config *config )
      *  We aren't doing and checks here to make sure the input side (i.e. CPUFreq) is
      *  corrent since we don't know what it should be.
      */
-    eventQueues.insert( std::pair<EventQueue*, double>(queue, subSystemFrequency) );
+    ClockDomain domain;
+
+    domain.queue = queue;
+    domain.subsystemFrequency = static_cast<uint64_t>( subSystemFrequency + 0.5 );
+    SetClockRatio( domain );
+
+    clockDomains.push_back( domain );
     queue->SetFrequency( subSystemFrequency );
 
     std::cout << "NVMain: GlobalEventQueue: Added a memory subsystem running at "
@@ -473,6 +640,41 @@ void GlobalEventQueue::AddSystem( NVMain *subSystem, Config *config )
               << (frequency / 1000000.0) << "MHz." << std::endl;
 }
 
+void GlobalEventQueue::SetClockRatio( ClockDomain& domain )
+{
+    uint64_t globalFrequency = static_cast<uint64_t>( frequency + 0.5 );
+    uint64_t a = globalFrequency, b = domain.subsystemFrequency;
+
+    /* Reduce the ratio to keep the products small. */
+    while( b != 0 )
+    {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+
+    assert( a != 0 );
+
+    domain.globalTicks = globalFrequency / a;
+    domain.localTicks = domain.subsystemFrequency / a;
+}
+
+/* 
+ *  Both conversions round down, as the double multipliers did. Products are
+ *  formed in 128 bits since the ratio of two arbitrary clocks may not reduce.
+ */
+ncycle_t GlobalEventQueue::ToGlobalCycle( const ClockDomain& domain, ncycle_t localCycle ) const
+{
+    return static_cast<ncycle_t>( static_cast<unsigned __int128>( localCycle )
+                                  * domain.globalTicks / domain.localTicks );
+}
+
+ncycle_t GlobalEventQueue::ToLocalCycle( const ClockDomain& domain, ncycle_t globalCycle ) const
+{
+    return static_cast<ncycle_t>( static_cast<unsigned __int128>( globalCycle )
+                                  * domain.localTicks / domain.globalTicks );
+}
+
 void GlobalEventQueue::Cycle( ncycle_t steps )
 {
     EventQueue *nextEventQueue;
@@ -506,10 +708,50 @@ void GlobalEventQueue::Cycle( ncycle_t steps )
     }
 }
 
+ncycle_t GlobalEventQueue::FastForward( ncycle_t maxSteps )
+{
+    ncycle_t nextEvent = GetNextEvent( );
+    ncycle_t steps = 1;
+
+    /*
+     *  With no pending events only an unbounded caller needs to keep polling
+     *  one cycle at a time; a bounded one can skip straight to its limit.
+     */
+    if( nextEvent == std::numeric_limits<ncycle_t>::max( ) )
+    {
+        if( maxSteps != std::numeric_limits<ncycle_t>::max( ) )
+            steps = maxSteps;
+    }
+    else if( nextEvent > currentCycle + 1 )
+    {
+        steps = nextEvent - currentCycle;
+    }
+
+    if( steps > maxSteps )
+        steps = maxSteps;
+
+    /*
+     *  Sync every subsystem up to the cycle before the event and take the
+     *  last cycle as a normal step. Events scheduled across subsystems are
+     *  relative to the target queue's current cycle, so processing the event
+     *  while the other queues lag behind would shift them.
+     */
+    if( steps > 1 )
+        Cycle( steps - 1 );
+    if( steps > 0 )
+        Cycle( 1 );
+
+    return steps;
+}
+
 /* Set frequency of global event queue in Hz. */
 void GlobalEventQueue::SetFrequency( double freq )
 {
     frequency = freq;
+
+    std::vector<ClockDomain>::iterator it;
+    for( it = clockDomains.begin( ); it != clockDomains.end( ); it++ )
+        SetClockRatio( *it );
 }
 
 double GlobalEventQueue::GetFrequency( )
@@ -519,29 +761,30 @@ double GlobalEventQueue::GetFrequency( )
 
 ncycle_t GlobalEventQueue::GetNextEvent( EventQueue **eq )
 {
-    std::map<EventQueue *, double>::const_iterator iter;
+    std::vector<ClockDomain>::const_iterator it;
     ncycle_t nextEventCycle = std::numeric_limits<ncycle_t>::max( );
 
     if( eq != NULL )
         *eq = NULL;
 
-    for( iter = eventQueues.begin( ); iter != eventQueues.end( ); iter++ )
+    for( it = clockDomains.begin( ); it != clockDomains.end( ); it++ )
     {
+        ncycle_t localEventCycle = it->queue->GetNextEvent( );
+
         /* 
          *  If there is no event, we must skip frequency alignment to prevent
-         *  underflow causing an invalid nextEventCycle.
+         *  overflow causing an invalid nextEventCycle.
          */
-        if( iter->first->GetNextEvent( ) == std::numeric_limits<ncycle_t>::max( ) )
+        if( localEventCycle == std::numeric_limits<ncycle_t>::max( ) )
             continue;
 
-        double frequencyMultiplier = frequency / iter->second;
-        double globalEventCycle = iter->first->GetNextEvent( ) * frequencyMultiplier;
+        ncycle_t globalEventCycle = ToGlobalCycle( *it, localEventCycle );
 
-        if( static_cast<ncycle_t>(globalEventCycle) < nextEventCycle )
+        if( globalEventCycle < nextEventCycle )
         {
-            nextEventCycle = static_cast<ncycle_t>(globalEventCycle);
+            nextEventCycle = globalEventCycle;
             if( eq != NULL )
-                *eq = iter->first;
+                *eq = it->queue;
         }
     }
 
@@ -555,17 +798,20 @@ ncycle_t GlobalEventQueue::GetCurrentCycle( )
 
 void GlobalEventQueue::Sync( )
 {
-    std::map<EventQueue *, double>::const_iterator iter;
-    for( iter = eventQueues.begin( ); iter != eventQueues.end( ); iter++ )
+    std::vector<ClockDomain>::iterator it;
+    for( it = clockDomains.begin( ); it != clockDomains.end( ); it++ )
     {
-        double frequencyMultiplier = frequency / iter->second;
-        double setCycle = static_cast<double>(currentCycle) / frequencyMultiplier;
-        ncycle_t stepCount = static_cast<ncycle_t>(setCycle) - iter->first->GetCurrentCycle( );
+        EventQueue *queue = it->queue;
+        ncycle_t setCycle = ToLocalCycle( *it, currentCycle );
 
-        if( static_cast<ncycle_t>(setCycle) > iter->first->GetCurrentCycle( ) )
-        {
-            iter->first->Loop( stepCount );
-        }
+        if( setCycle <= queue->GetCurrentCycle( ) )
+            continue;
+
+        /* Only queues with events due need to be looped. */
+        if( queue->GetNextEvent( ) <= setCycle )
+            queue->Loop( setCycle - queue->GetCurrentCycle( ) );
+        else
+            queue->SetCurrentCycle( setCycle );
     }
 }
 
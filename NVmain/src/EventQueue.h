@@ -36,6 +36,7 @@
 
 #include <map>
 #include <list>
+#include <vector>
 #include "include/NVMTypes.h"
 #include "include/NVMainRequest.h"
 
@@ -45,6 +46,7 @@ class Event;
 class NVMObject_hook;
 class Config;
 class NVMain;
+class PartitionWorkers;
 
 typedef std::list<Event *> EventList;
 typedef void (NVMObject::*CallbackPtr)(void*);
@@ -60,7 +62,8 @@ enum EventType { EventUnknown,
 class Event
 {
   public:
-    Event() : type(EventUnknown), recipient(NULL), request(NULL), data(NULL), cycle(0), priority(0) {}
+    Event() : type(EventUnknown), recipient(NULL), request(NULL), data(NULL), cycle(0), priority(0),
+              method(NULL), next(NULL), indexNext(NULL), pooled(false) {}
     ~Event() {}
 
     void SetType( EventType e ) { type = e; }
@@ -88,6 +91,14 @@ class Event
     ncycle_t cycle;
     int priority;
     CallbackPtr method;
+
+    /* Intrusive bookkeeping for the event queues. */
+    Event *next;                 /* Next event in the same cycle. */
+    Event *indexNext;            /* Next event in the same duplicate index slot. */
+    bool pooled;                 /* Allocated from the queue's event pool. */
+
+    friend class EventQueue;
+    friend class CalendarEventQueue;
 };
 
 
@@ -95,7 +106,7 @@ class EventQueue
 {
   public:
     EventQueue();
-    ~EventQueue();
+    virtual ~EventQueue();
 
     void InsertEvent( EventType type, NVMObject_hook *recipient, NVMainRequest *req, ncycle_t when, void *data = NULL, int priority = 0 );
     void InsertEvent( EventType type, NVMObject *recipient, NVMainRequest *req, ncycle_t when, void *data = NULL, int priority = 0 );
@@ -110,9 +121,9 @@ class EventQueue
 
     Event *FindCallback( NVMObject *recipient, CallbackPtr method, ncycle_t when, void *data = NULL, int priority = 0 ) const;
 
-    bool RemoveEvent( Event *event, ncycle_t when );
+    virtual bool RemoveEvent( Event *event, ncycle_t when );
 
-    void Process( );
+    virtual void Process( );
     void Loop( );
     void Loop( ncycle_t steps );
 
@@ -123,13 +134,61 @@ class EventQueue
     ncycle_t GetCurrentCycle( );
     void SetCurrentCycle( ncycle_t curCycle );
 
-  private:
+    /*
+     *  Partitions are child queues (one per memory channel) whose objects
+     *  never schedule events on each other. They are advanced in lockstep
+     *  with this queue, on worker threads once SetPartitionThreads is called.
+     *  After every window the partition callback runs on the calling thread,
+     *  so work deferred by the partitions can be finished serially.
+     */
+    void AddPartition( EventQueue *partition );
+    void SetPartitionThreads( ncounter_t threads );
+    void SetPartitionCallback( NVMObject *recipient, CallbackPtr method );
+    bool AdvancingPartitions( ) const;
+
+  protected:
     ncycle_t nextEventCycle;
     ncycle_t lastEventCycle;
     ncycle_t currentCycle; 
     double frequency;
 
+    /*
+     *  Backend hooks. The default implementation keeps a map of per-cycle
+     *  event lists; alternative schedulers override these.
+     */
+    virtual Event *AllocateEvent( );
+    virtual void ScheduleEvent( Event *event, ncycle_t when, int priority );
+
+    void DispatchEvent( Event *event );
+
+    /*
+     *  Pending events are hashed by (recipient, cycle) so the duplicate
+     *  checks in FindEvent and FindCallback do not walk the cycle's event
+     *  list. Backends index an event when it is scheduled and remove it when
+     *  it is freed or removed.
+     */
+    void IndexEvent( Event *event );
+    void UnindexEvent( Event *event );
+
+  private:
     std::map< ncycle_t, EventList> eventMap; 
+
+    std::vector<EventQueue *> partitions;
+    std::vector<EventQueue *> busyPartitions;
+    PartitionWorkers *partitionWorkers;
+    NVMObject *partitionRecipient;
+    CallbackPtr partitionMethod;
+    bool advancingPartitions;
+
+    void LoopPartitioned( ncycle_t steps );
+    void AdvancePartitions( ncycle_t when );
+
+    std::vector<Event *> eventIndex;
+    ncounter_t eventIndexMask;
+    ncounter_t indexedEvents;
+
+    ncounter_t IndexSlot( NVMObject *recipient, ncycle_t when ) const;
+    void GrowIndex( );
 };
 
 
@@ -142,6 +201,14 @@ class GlobalEventQueue
     void AddSystem( NVMain *subSystem, Config *config );
     void Cycle( ncycle_t steps );
 
+    /*
+     *  Advance straight to the next cycle with a pending event (at least one
+     *  cycle, at most maxSteps) and return the number of cycles advanced.
+     *  Nothing can change state between events, so callers polling for a
+     *  condition every cycle observe the same cycles as with Cycle( 1 ).
+     */
+    ncycle_t FastForward( ncycle_t maxSteps );
+
     void SetFrequency( double freq );
     double GetFrequency( );
 
@@ -149,10 +216,27 @@ class GlobalEventQueue
     ncycle_t GetCurrentCycle( );
 
   private:
+    /*
+     *  A subsystem clock as an exact ratio to the global clock: every
+     *  globalTicks global cycles are localTicks subsystem cycles. Cycles are
+     *  converted with integer arithmetic, so the mapping never drifts.
+     */
+    struct ClockDomain
+    {
+        EventQueue *queue;
+        uint64_t subsystemFrequency;
+        uint64_t globalTicks;
+        uint64_t localTicks;
+    };
+
     ncycle_t currentCycle;
     double frequency;
 
-    std::map<EventQueue *, double> eventQueues;
+    std::vector<ClockDomain> clockDomains;
+
+    void SetClockRatio( ClockDomain& domain );
+    ncycle_t ToGlobalCycle( const ClockDomain& domain, ncycle_t localCycle ) const;
+    ncycle_t ToLocalCycle( const ClockDomain& domain, ncycle_t globalCycle ) const;
 
     void Sync( );
 
@@ -48,6 +48,7 @@
 #include <csignal>
 #include <limits>
 #include <algorithm>
+#include <cstddef>
 
 using namespace NVM;
 
@@ -59,6 +60,9 @@ MemoryController::MemoryController( )
 {
     transactionQueues = NULL;
     transactionQueueCount = 0;
+    indexTransactions = false;
+    transactionIndices = NULL;
+    queuedTransactions = NULL;
     commandQueues = NULL;
     commandQueueCount = 0;
 
@@ -75,16 +79,24 @@ MemoryController::MemoryController( )
     activeSubArray = NULL;
 
     delayedRefreshCounter = NULL;
+    refreshGroupsDue = 0;
     
     curQueue = 0;
     nextRefreshRank = 0;
     nextRefreshBank = 0;
 
     handledRefresh = std::numeric_limits<ncycle_t>::max( );
+
+    commandsCreated = 0;
+    commandAllocations = 0;
+    transactionQueueDepth.SetBuckets( 4, 16 );
 }
 
 MemoryController::~MemoryController( )
 {
+    delete [] transactionIndices;
+    delete [] queuedTransactions;
+
     for( ncounter_t i = 0; i < p->RANKS; i++ )
     {
         delete [] activateQueued[i];
@@ -123,9 +135,12 @@ MemoryController::~MemoryController( )
     }
 
     delete [] delayedRefreshCounter;
+
+    for( size_t i = 0; i < freeCommands.size( ); i++ )
+        delete freeCommands[i];
 }
 
-void MemoryController::InitQueues( unsigned int numQueues )
+void MemoryController::InitQueues( unsigned int numQueues, bool indexed )
 {
     if( transactionQueues != NULL )
         delete [] transactionQueues;
@@ -133,6 +148,9 @@ void MemoryController::InitQueues( unsigned int numQueues )
     transactionQueues = new NVMTransactionQueue[ numQueues ];
     transactionQueueCount = numQueues;
 
+    /* The indices are sized in SetConfig once the geometry is known. */
+    indexTransactions = indexed;
+
     for( unsigned int i = 0; i < numQueues; i++ )
         transactionQueues[i].clear( );
 }
@@ -175,6 +193,15 @@ void MemoryController::Prequeue( ncounter_t queueNum, NVMainRequest *request )
     assert( queueNum < transactionQueueCount );
 
     transactionQueues[queueNum].push_front( request );
+
+    if( transactionIndices != NULL )
+    {
+        ncounter_t queueId = GetCommandQueueId( request->address );
+
+        transactionIndices[queueNum].PushFront( request, 
+                transactionQueues[queueNum].begin( ), queueId );
+        queuedTransactions[queueId]++;
+    }
 }
 
 void MemoryController::Enqueue( ncounter_t queueNum, NVMainRequest *request )
@@ -191,10 +218,18 @@ void MemoryController::Enqueue( ncounter_t queueNum, NVMainRequest *request )
     assert( queueNum < transactionQueueCount );
 
     transactionQueues[queueNum].push_back( request );
+    transactionQueueDepth.Sample( transactionQueues[queueNum].size( ) );
     
     /* If this command queue is empty, we can schedule a new transaction right away. */
     ncounter_t queueId = GetCommandQueueId( request->address );
 
+    if( transactionIndices != NULL )
+    {
+        transactionIndices[queueNum].PushBack( request, 
+                --transactionQueues[queueNum].end( ), queueId );
+        queuedTransactions[queueId]++;
+    }
+
     if( EffectivelyEmpty( queueId ) )
     {
         ncycle_t nextWakeup = GetEventQueue( )->GetCurrentCycle( );
@@ -210,6 +245,9 @@ bool MemoryController::TransactionAvailable( ncounter_t queueId )
 {
     bool rv = false; 
 
+    if( queuedTransactions != NULL )
+        return (queuedTransactions[queueId] > 0);
+
     for( ncounter_t queueIdx = 0; queueIdx < transactionQueueCount; queueIdx++ )
     {
         std::list<NVMainRequest *>::iterator it;
@@ -293,6 +331,8 @@ void MemoryController::CleanupCallback( void * /*data*/ )
 {
     for( ncycle_t queueId = 0; queueId < commandQueueCount; queueId++ )
     {
+        size_t queueSize = commandQueues[queueId].size( );
+
         /* Remove issued requests from the command queue. */
         commandQueues[queueId].erase(
             std::remove_if( commandQueues[queueId].begin(), 
@@ -300,6 +340,9 @@ void MemoryController::CleanupCallback( void * /*data*/ )
                             WasIssued ),
             commandQueues[queueId].end()
         );        
+
+        if( commandQueues[queueId].size( ) != queueSize )
+            MarkQueueStale( queueId );
     }
 }
 
@@ -312,9 +355,9 @@ bool MemoryController::RequestComplete( NVMainRequest *request )
     {
         /* 
          *  Any activate/precharge/etc commands belong to the memory controller
-         *  and we are in charge of deleting them!
+         *  and we are in charge of recycling them!
          */
-        delete request;
+        ReleaseCommand( request );
     }
     else
     {
@@ -419,32 +462,53 @@ void MemoryController::SetConfig( Config *conf, bool createChildren )
         subArrayNum = 1;
     }
 
-    /* Determine number of command queues. Assume per-bank queues as this was the default for older nvmain versions. */
-    queueModel = PerBankQueues;
-    commandQueueCount = p->RANKS * p->BANKS;
-    if( conf->KeyExists( "QueueModel" ) )
+    /* Determine number of command queues. */
+    queueModel = p->queueModel;
+    if( queueModel == PerRankQueues )
+        commandQueueCount = p->RANKS;
+    else if( queueModel == PerSubArrayQueues )
+        commandQueueCount = p->RANKS * p->BANKS * subArrayNum;
+    else
+        commandQueueCount = p->RANKS * p->BANKS;
+
+    std::cout << "Creating " << commandQueueCount << " command queues." << std::endl;
+    
+    commandQueues = new std::deque<NVMainRequest *> [commandQueueCount];
+
+    /* NextIssuable() watches the queue of each bank's first subarray. */
+    queueIssueTime.assign( commandQueueCount, 0 );
+    queueInHeap.assign( commandQueueCount, false );
+    queueStale.assign( commandQueueCount, false );
+    watchedQueueRank.assign( commandQueueCount, p->RANKS );
+    rankWatchedQueues.assign( p->RANKS, std::vector<ncounter_t>( ) );
+    issueTimes.clear( );
+    staleQueues.clear( );
+
+    for( ncounter_t rankIdx = 0; rankIdx < p->RANKS; rankIdx++ )
     {
-        if( conf->GetString( "QueueModel" ) == "PerRank" )
-        {
-            queueModel = PerRankQueues;
-            commandQueueCount = p->RANKS;
-        }
-        else if( conf->GetString( "QueueModel" ) == "PerBank" )
-        {
-            queueModel = PerBankQueues;
-            commandQueueCount = p->RANKS * p->BANKS;
-        }
-        else if( conf->GetString( "QueueModel" ) == "PerSubArray" )
+        for( ncounter_t bankIdx = 0; bankIdx < p->BANKS; bankIdx++ )
         {
-            queueModel = PerSubArrayQueues;
-            commandQueueCount = p->RANKS * p->BANKS * subArrayNum;
+            ncounter_t queueIdx = GetCommandQueueId( NVMAddress( 0, 0, bankIdx, rankIdx, 0, 0 ) );
+
+            if( watchedQueueRank[queueIdx] == p->RANKS )
+            {
+                watchedQueueRank[queueIdx] = rankIdx;
+                rankWatchedQueues[rankIdx].push_back( queueIdx );
+            }
         }
-        /* Add your custom types here. */
     }
 
-    std::cout << "Creating " << commandQueueCount << " command queues." << std::endl;
-    
-    commandQueues = new std::deque<NVMainRequest *> [commandQueueCount];
+    if( indexTransactions )
+    {
+        transactionIndices = new TransactionIndex[transactionQueueCount];
+        queuedTransactions = new ncounter_t[commandQueueCount];
+
+        for( ncounter_t i = 0; i < transactionQueueCount; i++ )
+            transactionIndices[i].SetDimensions( p->RANKS, p->BANKS, subArrayNum );
+
+        for( ncounter_t i = 0; i < commandQueueCount; i++ )
+            queuedTransactions[i] = 0;
+    }
     activateQueued = new bool * [p->RANKS];
     refreshQueued = new bool * [p->RANKS];
     starvationCounter = new ncounter_t ** [p->RANKS];
@@ -528,6 +592,9 @@ void MemoryController::SetConfig( Config *conf, bool createChildren )
             {
                 delayedRefreshCounter[i][j] = 0;
 
+                if( delayedRefreshCounter[i][j] >= p->DelayedRefreshThreshold )
+                    refreshGroupsDue++;
+
                 ncounter_t refreshBankHead = j * p->BanksPerRefresh;
 
                 /* create first refresh pulse to start the refresh countdown */ 
@@ -560,6 +627,80 @@ void MemoryController::RegisterStats( )
 {
     AddStat(simulation_cycles);
     AddStat(wakeupCount);
+    AddStat(commandsCreated);
+    AddStat(commandAllocations);
+    AddStat(transactionQueueDepth);
+}
+
+void MemoryController::RegisterLatencyStats( )
+{
+    AddStat(readLatency);
+    AddStat(writeLatency);
+    AddStat(readQueueLatency);
+    AddStat(writeQueueLatency);
+    AddStat(readTotalLatency);
+    AddStat(writeTotalLatency);
+
+    /* Sized here so the registered addresses stay put. */
+    rankReadTotalLatency.resize( p->RANKS );
+    rankWriteTotalLatency.resize( p->RANKS );
+
+    for( ncounter_t i = 0; i < p->RANKS; i++ )
+    {
+        std::stringstream rankName;
+
+        rankName << ".rank" << i;
+
+        GetStats( )->addStat( &(rankReadTotalLatency[i]),
+                              StatName( ) + ".readTotalLatency" + rankName.str( ), "" );
+        GetStats( )->addStat( &(rankWriteTotalLatency[i]),
+                              StatName( ) + ".writeTotalLatency" + rankName.str( ), "" );
+    }
+}
+
+void MemoryController::RecordLatency( NVMainRequest *request )
+{
+    bool isWrite = (request->type == WRITE || request->type == WRITE_PRECHARGE);
+    ncounter_t rank = request->address.GetRank( );
+
+    /* Requests completed without being issued may predate their arrival. */
+    ncycle_t queueLatency = (request->issueCycle > request->arrivalCycle)
+                          ? request->issueCycle - request->arrivalCycle : 0;
+    ncycle_t latency = (request->completionCycle > request->issueCycle)
+                     ? request->completionCycle - request->issueCycle : 0;
+    ncycle_t totalLatency = (request->completionCycle > request->arrivalCycle)
+                          ? request->completionCycle - request->arrivalCycle : 0;
+
+    if( isWrite )
+    {
+        writeLatency.Sample( latency );
+        writeQueueLatency.Sample( queueLatency );
+        writeTotalLatency.Sample( totalLatency );
+
+        if( rank < rankWriteTotalLatency.size( ) )
+            rankWriteTotalLatency[rank].Sample( totalLatency );
+    }
+    else
+    {
+        readLatency.Sample( latency );
+        readQueueLatency.Sample( queueLatency );
+        readTotalLatency.Sample( totalLatency );
+
+        if( rank < rankReadTotalLatency.size( ) )
+            rankReadTotalLatency[rank].Sample( totalLatency );
+    }
+}
+
+double MemoryController::MeanLatency( const Distribution& reads, const Distribution& writes )
+{
+    ncounter_t samples = reads.GetCount( ) + writes.GetCount( );
+
+    if( samples == 0 )
+        return 0.0;
+
+    return (reads.GetMean( ) * static_cast<double>(reads.GetCount( ))
+            + writes.GetMean( ) * static_cast<double>(writes.GetCount( )))
+           / static_cast<double>(samples);
 }
 
 /* 
@@ -630,7 +771,12 @@ void MemoryController::IncrementRefreshCounter( const ncounter_t bank, const uin
     /* get the bank group ID */
     ncounter_t bankGroupID = bank / p->BanksPerRefresh;
 
+    bool wasDue = (delayedRefreshCounter[rank][bankGroupID] >= p->DelayedRefreshThreshold);
+
     delayedRefreshCounter[rank][bankGroupID]++;
+
+    if( !wasDue && delayedRefreshCounter[rank][bankGroupID] >= p->DelayedRefreshThreshold )
+        refreshGroupsDue++;
 }
 
 /* 
@@ -641,7 +787,12 @@ void MemoryController::DecrementRefreshCounter( const ncounter_t bank, const uin
     /* get the bank group ID */
     ncounter_t bankGroupID = bank / p->BanksPerRefresh;
 
+    bool wasDue = (delayedRefreshCounter[rank][bankGroupID] >= p->DelayedRefreshThreshold);
+
     delayedRefreshCounter[rank][bankGroupID]--;
+
+    if( wasDue && delayedRefreshCounter[rank][bankGroupID] < p->DelayedRefreshThreshold )
+        refreshGroupsDue--;
 }
 
 /* 
@@ -682,7 +833,7 @@ bool MemoryController::HandleRefresh( )
                             // subarrays -- We will need a different command for precharging all banks
                             NVMainRequest *cmdRefPre = MakePrechargeAllRequest( 0, 0, refBank, i, 0 );
 
-                            commandQueues[queueId].push_back( cmdRefPre );
+                            EnqueueCommand( queueId, cmdRefPre );
 
                             /* clear all active subarrays */
                             for( ncounter_t sa = 0; sa < subArrayNum; sa++ )
@@ -700,7 +851,7 @@ bool MemoryController::HandleRefresh( )
 
                 /* send the refresh command to the rank */
                 cmdRefresh->issueCycle = GetEventQueue()->GetCurrentCycle();
-                commandQueues[queueId].push_back( cmdRefresh );
+                EnqueueCommand( queueId, cmdRefresh );
 
                 for( ncounter_t tmpBank = 0; tmpBank < p->BanksPerRefresh; tmpBank++ )
                 {
@@ -804,7 +955,7 @@ void MemoryController::PowerDown( const ncounter_t& rankId )
     if( pdRank->Idle( ) == false )
     {
         /* Remake request as PDA. */
-        delete powerdownRequest;
+        ReleaseCommand( powerdownRequest );
 
         pdOp = POWERDOWN_PDA;
         powerdownRequest = MakePowerdownRequest( pdOp, rankId );
@@ -813,11 +964,12 @@ void MemoryController::PowerDown( const ncounter_t& rankId )
     if( RankQueueEmpty( rankId ) && GetChild()->IsIssuable( powerdownRequest ) )
     {
         GetChild()->IssueCommand( powerdownRequest );
+        CommandIssued( powerdownRequest );
         rankPowerDown[rankId] = true;
     }
     else
     {
-        delete powerdownRequest;
+        ReleaseCommand( powerdownRequest );
     }
 }
 
@@ -830,11 +982,12 @@ void MemoryController::PowerUp( const ncounter_t& rankId )
         && GetChild()->IsIssuable( powerupRequest ) )
     {
         GetChild()->IssueCommand( powerupRequest );
+        CommandIssued( powerupRequest );
         rankPowerDown[rankId] = false;
     }
     else
     {
-        delete powerupRequest;
+        ReleaseCommand( powerupRequest );
     }
 }
 
@@ -866,11 +1019,12 @@ void MemoryController::HandleLowPower( )
             if( rankPowerDown[rankId] && GetChild()->IsIssuable( powerupRequest ) )
             {
                 GetChild()->IssueCommand( powerupRequest );
+                CommandIssued( powerupRequest );
                 rankPowerDown[rankId] = false;
             }
             else
             {
-                delete powerupRequest;
+                ReleaseCommand( powerupRequest );
             }
         }
         /* else, check whether the rank can be powered down or up */
@@ -899,28 +1053,76 @@ unsigned int MemoryController::GetID( )
     return this->id;
 }
 
+NVMainRequest *MemoryController::AllocateCommand( NVMainRequest *triggerRequest )
+{
+    NVMainRequest *command;
+
+    if( freeCommands.empty( ) )
+    {
+        command = new NVMainRequest( );
+        commandAllocations++;
+    }
+    else
+    {
+        /* Rebuild in place so nothing set by the previous user is left over. */
+        command = freeCommands.back( );
+        freeCommands.pop_back( );
+
+        command->~NVMainRequest( );
+        ::new (command) NVMainRequest( );
+    }
+
+    command->owner = this;
+    command->trigger = triggerRequest;
+    commandsCreated++;
+
+    return command;
+}
+
+void MemoryController::ReleaseCommand( NVMainRequest *command )
+{
+    assert( command->owner == this );
+
+    freeCommands.push_back( command );
+}
+
 NVMainRequest *MemoryController::MakeCachedRequest( NVMainRequest *triggerRequest )
 {
     /* This method should be called on *transaction* queue requests, thus only READ/WRITE possible. */
     assert( triggerRequest->type == READ || triggerRequest->type == WRITE );
 
-    NVMainRequest *cachedRequest = new NVMainRequest( );
+    /* 
+     *  Cached requests are only probed with IsIssuable, which never looks at
+     *  the data, so the data blocks are left with the trigger.
+     */
+    NVMainRequest *cachedRequest = AllocateCommand( triggerRequest );
 
-    *cachedRequest = *triggerRequest;
+    cachedRequest->address = triggerRequest->address;
     cachedRequest->type = (triggerRequest->type == READ ? CACHED_READ : CACHED_WRITE);
-    cachedRequest->owner = this;
+    cachedRequest->bulkCmd = triggerRequest->bulkCmd;
+    cachedRequest->threadId = triggerRequest->threadId;
+    cachedRequest->status = triggerRequest->status;
+    cachedRequest->access = triggerRequest->access;
+    cachedRequest->tag = triggerRequest->tag;
+    cachedRequest->reqInfo = triggerRequest->reqInfo;
+    cachedRequest->isPrefetch = triggerRequest->isPrefetch;
+    cachedRequest->pfTrigger = triggerRequest->pfTrigger;
+    cachedRequest->programCounter = triggerRequest->programCounter;
+    cachedRequest->arrivalCycle = triggerRequest->arrivalCycle;
+    cachedRequest->queueCycle = triggerRequest->queueCycle;
+    cachedRequest->issueCycle = triggerRequest->issueCycle;
+    cachedRequest->completionCycle = triggerRequest->completionCycle;
 
     return cachedRequest;
 }
 
 NVMainRequest *MemoryController::MakeActivateRequest( NVMainRequest *triggerRequest )
 {
-    NVMainRequest *activateRequest = new NVMainRequest( );
+    NVMainRequest *activateRequest = AllocateCommand( triggerRequest );
 
     activateRequest->type = ACTIVATE;
     activateRequest->issueCycle = GetEventQueue()->GetCurrentCycle();
     activateRequest->address = triggerRequest->address;
-    activateRequest->owner = this;
 
     return activateRequest;
 }
@@ -931,26 +1133,24 @@ NVMainRequest *MemoryController::MakeActivateRequest( const ncounter_t row,
                                                       const ncounter_t rank,
                                                       const ncounter_t subarray )
 {
-    NVMainRequest *activateRequest = new NVMainRequest( );
+    NVMainRequest *activateRequest = AllocateCommand( );
 
     activateRequest->type = ACTIVATE;
     ncounter_t actAddr = GetDecoder( )->ReverseTranslate( row, col, bank, rank, id, subarray );
     activateRequest->address.SetPhysicalAddress( actAddr );
     activateRequest->address.SetTranslatedAddress( row, col, bank, rank, id, subarray );
     activateRequest->issueCycle = GetEventQueue()->GetCurrentCycle();
-    activateRequest->owner = this;
 
     return activateRequest;
 }
 
 NVMainRequest *MemoryController::MakePrechargeRequest( NVMainRequest *triggerRequest )
 {
-    NVMainRequest *prechargeRequest = new NVMainRequest( );
+    NVMainRequest *prechargeRequest = AllocateCommand( triggerRequest );
 
     prechargeRequest->type = PRECHARGE;
     prechargeRequest->issueCycle = GetEventQueue()->GetCurrentCycle();
     prechargeRequest->address = triggerRequest->address;
-    prechargeRequest->owner = this;
 
     return prechargeRequest;
 }
@@ -961,26 +1161,24 @@ NVMainRequest *MemoryController::MakePrechargeRequest( const ncounter_t row,
                                                        const ncounter_t rank,
                                                        const ncounter_t subarray )
 {
-    NVMainRequest *prechargeRequest = new NVMainRequest( );
+    NVMainRequest *prechargeRequest = AllocateCommand( );
 
     prechargeRequest->type = PRECHARGE;
     ncounter_t preAddr = GetDecoder( )->ReverseTranslate( row, col, bank, rank, id, subarray );
     prechargeRequest->address.SetPhysicalAddress( preAddr );
     prechargeRequest->address.SetTranslatedAddress( row, col, bank, rank, id, subarray );
     prechargeRequest->issueCycle = GetEventQueue()->GetCurrentCycle();
-    prechargeRequest->owner = this;
 
     return prechargeRequest;
 }
 
 NVMainRequest *MemoryController::MakePrechargeAllRequest( NVMainRequest *triggerRequest )
 {
-    NVMainRequest *prechargeAllRequest = new NVMainRequest( );
+    NVMainRequest *prechargeAllRequest = AllocateCommand( triggerRequest );
 
     prechargeAllRequest->type = PRECHARGE_ALL;
     prechargeAllRequest->issueCycle = GetEventQueue()->GetCurrentCycle();
     prechargeAllRequest->address = triggerRequest->address;
-    prechargeAllRequest->owner = this;
 
     return prechargeAllRequest;
 }
@@ -991,14 +1189,13 @@ NVMainRequest *MemoryController::MakePrechargeAllRequest( const ncounter_t row,
                                                           const ncounter_t rank,
                                                           const ncounter_t subarray )
 {
-    NVMainRequest *prechargeAllRequest = new NVMainRequest( );
+    NVMainRequest *prechargeAllRequest = AllocateCommand( );
 
     prechargeAllRequest->type = PRECHARGE_ALL;
     ncounter_t preAddr = GetDecoder( )->ReverseTranslate( row, col, bank, rank, id, subarray );
     prechargeAllRequest->address.SetPhysicalAddress( preAddr );
     prechargeAllRequest->address.SetTranslatedAddress( row, col, bank, rank, id, subarray );
     prechargeAllRequest->issueCycle = GetEventQueue()->GetCurrentCycle();
-    prechargeAllRequest->owner = this;
 
     return prechargeAllRequest;
 }
@@ -1021,14 +1218,13 @@ NVMainRequest *MemoryController::MakeRefreshRequest( const ncounter_t row,
                                                      const ncounter_t rank,
                                                      const ncounter_t subarray )
 {
-    NVMainRequest *refreshRequest = new NVMainRequest( );
+    NVMainRequest *refreshRequest = AllocateCommand( );
 
     refreshRequest->type = REFRESH;
     ncounter_t preAddr = GetDecoder( )->ReverseTranslate( row, col, bank, rank, id, subarray );
     refreshRequest->address.SetPhysicalAddress( preAddr );
     refreshRequest->address.SetTranslatedAddress( row, col, bank, rank, id, subarray );
     refreshRequest->issueCycle = GetEventQueue()->GetCurrentCycle();
-    refreshRequest->owner = this;
 
     return refreshRequest;
 }
@@ -1036,28 +1232,26 @@ NVMainRequest *MemoryController::MakeRefreshRequest( const ncounter_t row,
 NVMainRequest *MemoryController::MakePowerdownRequest( OpType pdOp,
                                                        const ncounter_t rank )
 {
-    NVMainRequest *powerdownRequest = new NVMainRequest( );
+    NVMainRequest *powerdownRequest = AllocateCommand( );
 
     powerdownRequest->type = pdOp;
     ncounter_t pdAddr = GetDecoder( )->ReverseTranslate( 0, 0, 0, rank, id, 0 );
     powerdownRequest->address.SetPhysicalAddress( pdAddr );
     powerdownRequest->address.SetTranslatedAddress( 0, 0, 0, rank, id, 0 );
     powerdownRequest->issueCycle = GetEventQueue()->GetCurrentCycle();
-    powerdownRequest->owner = this;
 
     return powerdownRequest;
 }
 
 NVMainRequest *MemoryController::MakePowerupRequest( const ncounter_t rank )
 {
-    NVMainRequest *powerupRequest = new NVMainRequest( );
+    NVMainRequest *powerupRequest = AllocateCommand( );
 
     powerupRequest->type = POWERUP;
     ncounter_t puAddr = GetDecoder( )->ReverseTranslate( 0, 0, 0, rank, id, 0 );
     powerupRequest->address.SetPhysicalAddress( puAddr );
     powerupRequest->address.SetTranslatedAddress( 0, 0, 0, rank, id, 0 );
     powerupRequest->issueCycle = GetEventQueue()->GetCurrentCycle();
-    powerupRequest->owner = this;
 
     return powerupRequest;
 }
@@ -1077,6 +1271,11 @@ bool MemoryController::IsLastRequest( std::list<NVMainRequest *>& transactionQue
         request->address.GetTranslatedAddress( &mRow, NULL, &mBank, &mRank, NULL, &mSubArray );
         std::list<NVMainRequest *>::iterator it;
 
+        TransactionIndex *index = GetTransactionIndex( transactionQueue );
+
+        if( index != NULL )
+            return (index->GetRowHead( mRank, mBank, mSubArray, mRow ) == NULL);
+
         for( it = transactionQueue.begin(); it != transactionQueue.end(); it++ )
         {
             ncounter_t rank, bank, row, subarray;
@@ -1112,6 +1311,11 @@ bool MemoryController::FindStarvedRequest( std::list<NVMainRequest *>& transacti
 
     *starvedRequest = NULL;
 
+    TransactionIndex *index = GetTransactionIndex( transactionQueue );
+
+    if( index != NULL )
+        return FindIndexedStarvedRequest( transactionQueue, index, starvedRequest, pred );
+
     for( it = transactionQueue.begin(); it != transactionQueue.end(); it++ )
     {
         ncounter_t rank, bank, row, subarray, col;
@@ -1181,26 +1385,40 @@ bool MemoryController::FindCachedAddress( std::list<NVMainRequest *>& transactio
 
     *accessibleRequest = NULL;
 
-    for( it = transactionQueue.begin(); it != transactionQueue.end(); it++ )
+    /* The index (if any) is walked alongside since it has the same order. */
+    TransactionIndex *index = GetTransactionIndex( transactionQueue );
+    TransactionIndex::Entry *entry = (index != NULL) ? index->GetFirst( ) : NULL;
+
+    for( it = transactionQueue.begin(); it != transactionQueue.end(); 
+         it++, entry = (entry != NULL) ? entry->next : NULL )
     {
-        ncounter_t queueId = GetCommandQueueId( (*it)->address );
+        ncounter_t queueId = (entry != NULL) ? entry->queueId 
+                                             : GetCommandQueueId( (*it)->address );
+
+        /* Don't bother copying the request if the queue is busy anyways. */
+        if( !commandQueues[queueId].empty() ) continue;
+
         NVMainRequest *cachedRequest = MakeCachedRequest( (*it) );
         
-        if( commandQueues[queueId].empty() 
-            && GetChild( )->IsIssuable( cachedRequest )
+        if( GetChild( )->IsIssuable( cachedRequest )
             && (*it)->arrivalCycle != GetEventQueue()->GetCurrentCycle()
             && pred( (*it ) ) )
         {
-            *accessibleRequest = (*it);
-            transactionQueue.erase( it );
+            if( entry != NULL )
+                *accessibleRequest = TakeTransaction( transactionQueue, index, entry );
+            else
+            {
+                *accessibleRequest = (*it);
+                transactionQueue.erase( it );
+            }
 
-            delete cachedRequest;
+            ReleaseCommand( cachedRequest );
 
             rv = true;
             break;
         }
 
-        delete cachedRequest;
+        ReleaseCommand( cachedRequest );
     }
 
     return rv;
@@ -1225,13 +1443,19 @@ bool MemoryController::FindWriteStalledRead( std::list<NVMainRequest *>& transac
     if( !p->WritePausing )
         return false;
 
-    for( it = transactionQueue.begin(); it != transactionQueue.end(); it++ )
+    /* The index (if any) is walked alongside since it has the same order. */
+    TransactionIndex *index = GetTransactionIndex( transactionQueue );
+    TransactionIndex::Entry *entry = (index != NULL) ? index->GetFirst( ) : NULL;
+
+    for( it = transactionQueue.begin(); it != transactionQueue.end(); 
+         it++, entry = (entry != NULL) ? entry->next : NULL )
     {
         if( (*it)->type != READ )
             continue;
 
         ncounter_t rank, bank, row, subarray, col;
-        ncounter_t queueId = GetCommandQueueId( (*it)->address );
+        ncounter_t queueId = (entry != NULL) ? entry->queueId 
+                                             : GetCommandQueueId( (*it)->address );
 
         if( !commandQueues[queueId].empty() ) continue;
 
@@ -1258,17 +1482,22 @@ bool MemoryController::FindWriteStalledRead( std::list<NVMainRequest *>& transac
         {
             if( !writingArray->BetweenWriteIterations( ) && p->pauseMode == PauseMode_Normal )
             {
-                delete testActivate;
+                ReleaseCommand( testActivate );
 
                 /* Stall the scheduler by returning true. */
                 rv = true;
                 break;
             }
 
-            *hitRequest = (*it);
-            transactionQueue.erase( it );
+            if( entry != NULL )
+                *hitRequest = TakeTransaction( transactionQueue, index, entry );
+            else
+            {
+                *hitRequest = (*it);
+                transactionQueue.erase( it );
+            }
 
-            delete testActivate;
+            ReleaseCommand( testActivate );
 
             /* Different row buffer management policy has different behavior */ 
 
@@ -1286,7 +1515,7 @@ bool MemoryController::FindWriteStalledRead( std::list<NVMainRequest *>& transac
             break;
         }
 
-        delete testActivate;
+        ReleaseCommand( testActivate );
     }
 
     return rv;
@@ -1308,6 +1537,11 @@ bool MemoryController::FindRowBufferHit( std::list<NVMainRequest *>& transaction
 
     *hitRequest = NULL;
 
+    TransactionIndex *index = GetTransactionIndex( transactionQueue );
+
+    if( index != NULL )
+        return FindIndexedRowBufferHit( transactionQueue, index, hitRequest, pred );
+
     for( it = transactionQueue.begin(); it != transactionQueue.end(); it++ )
     {
         ncounter_t rank, bank, row, subarray, col;
@@ -1370,6 +1604,11 @@ bool MemoryController::FindOldestReadyRequest( std::list<NVMainRequest *>& trans
 
     *oldestRequest = NULL;
 
+    TransactionIndex *index = GetTransactionIndex( transactionQueue );
+
+    if( index != NULL )
+        return FindIndexedOldestReadyRequest( transactionQueue, index, oldestRequest, pred );
+
     for( it = transactionQueue.begin(); it != transactionQueue.end(); it++ )
     {
         ncounter_t rank, bank;
@@ -1425,6 +1664,11 @@ bool MemoryController::FindClosedBankRequest( std::list<NVMainRequest *>& transa
 
     *closedRequest = NULL;
 
+    TransactionIndex *index = GetTransactionIndex( transactionQueue );
+
+    if( index != NULL )
+        return FindIndexedClosedBankRequest( transactionQueue, index, closedRequest, pred );
+
     for( it = transactionQueue.begin(); it != transactionQueue.end(); it++ )
     {
         ncounter_t rank, bank;
@@ -1463,6 +1707,220 @@ bool MemoryController::FindClosedBankRequest( std::list<NVMainRequest *>& transa
     return rv;
 }
 
+TransactionIndex *MemoryController::GetTransactionIndex( std::list<NVMainRequest *>& transactionQueue )
+{
+    if( transactionIndices == NULL )
+        return NULL;
+
+    /* Queues passed to the schedulers are always from transactionQueues. */
+    ptrdiff_t queueNum = &transactionQueue - transactionQueues;
+
+    if( queueNum < 0 || queueNum >= static_cast<ptrdiff_t>(transactionQueueCount) )
+        return NULL;
+
+    return &(transactionIndices[queueNum]);
+}
+
+NVMainRequest *MemoryController::TakeTransaction( std::list<NVMainRequest *>& transactionQueue,
+                                                  TransactionIndex *index, 
+                                                  TransactionIndex::Entry *entry )
+{
+    NVMainRequest *request = entry->request;
+
+    transactionQueue.erase( entry->position );
+    queuedTransactions[entry->queueId]--;
+    index->Remove( entry );
+
+    return request;
+}
+
+/*
+ *  The indexed searches visit each occupied (rank, bank, subarray) slot, find
+ *  the oldest request in it passing the same checks as the linear versions
+ *  and keep the oldest one overall. All requests in a slot share the same
+ *  bank state and command queue, so those are only checked once per slot.
+ */
+bool MemoryController::FindIndexedStarvedRequest( std::list<NVMainRequest *>& transactionQueue, 
+                                                  TransactionIndex *index,
+                                                  NVMainRequest **starvedRequest, 
+                                                  SchedulingPredicate& pred )
+{
+    TransactionIndex::Entry *best = NULL;
+    ncycle_t currentCycle = GetEventQueue()->GetCurrentCycle();
+
+    for( ncounter_t slotIdx = 0; slotIdx < index->GetOccupiedCount( ); slotIdx++ )
+    {
+        TransactionIndex::Entry *entry = index->GetOccupiedSlot( slotIdx );
+        ncounter_t rank = entry->rank, bank = entry->bank, subarray = entry->subarray;
+
+        if( !activateQueued[rank][bank] 
+            || bankNeedRefresh[rank][bank]
+            || refreshQueued[rank][bank]
+            || starvationCounter[rank][bank][subarray] < starvationThreshold
+            || !commandQueues[entry->queueId].empty() )
+            continue;
+
+        for( ; entry != NULL && (best == NULL || entry->order < best->order); 
+             entry = entry->slotNext )
+        {
+            ncounter_t muxLevel = static_cast<ncounter_t>(entry->col / p->RBSize);
+
+            if( ( !activeSubArray[rank][bank][subarray]
+                  || effectiveRow[rank][bank][subarray] != entry->row
+                  || effectiveMuxedRow[rank][bank][subarray] != muxLevel )
+                && entry->request->arrivalCycle != currentCycle
+                && pred( entry->request ) )
+            {
+                best = entry;
+                break;
+            }
+        }
+    }
+
+    if( best == NULL )
+        return false;
+
+    *starvedRequest = TakeTransaction( transactionQueue, index, best );
+
+    if( IsLastRequest( transactionQueue, (*starvedRequest) ) )
+        (*starvedRequest)->flags |= NVMainRequest::FLAG_LAST_REQUEST;
+
+    return true;
+}
+
+bool MemoryController::FindIndexedRowBufferHit( std::list<NVMainRequest *>& transactionQueue, 
+                                                TransactionIndex *index,
+                                                NVMainRequest **hitRequest, 
+                                                SchedulingPredicate& pred )
+{
+    TransactionIndex::Entry *best = NULL;
+    ncycle_t currentCycle = GetEventQueue()->GetCurrentCycle();
+
+    for( ncounter_t slotIdx = 0; slotIdx < index->GetOccupiedCount( ); slotIdx++ )
+    {
+        TransactionIndex::Entry *entry = index->GetOccupiedSlot( slotIdx );
+        ncounter_t rank = entry->rank, bank = entry->bank, subarray = entry->subarray;
+
+        if( !activateQueued[rank][bank] 
+            || !activeSubArray[rank][bank][subarray]
+            || bankNeedRefresh[rank][bank]
+            || refreshQueued[rank][bank]
+            || !commandQueues[entry->queueId].empty() )
+            continue;
+
+        /* Only requests to the open row can hit. */
+        entry = index->GetRowHead( entry, effectiveRow[rank][bank][subarray] );
+
+        for( ; entry != NULL && (best == NULL || entry->order < best->order); 
+             entry = entry->rowNext )
+        {
+            ncounter_t muxLevel = static_cast<ncounter_t>(entry->col / p->RBSize);
+
+            if( effectiveMuxedRow[rank][bank][subarray] == muxLevel
+                && entry->request->arrivalCycle != currentCycle
+                && pred( entry->request ) )
+            {
+                best = entry;
+                break;
+            }
+        }
+    }
+
+    if( best == NULL )
+        return false;
+
+    *hitRequest = TakeTransaction( transactionQueue, index, best );
+
+    if( IsLastRequest( transactionQueue, (*hitRequest) ) )
+        (*hitRequest)->flags |= NVMainRequest::FLAG_LAST_REQUEST;
+
+    return true;
+}
+
+bool MemoryController::FindIndexedOldestReadyRequest( std::list<NVMainRequest *>& transactionQueue, 
+                                                      TransactionIndex *index,
+                                                      NVMainRequest **oldestRequest, 
+                                                      SchedulingPredicate& pred )
+{
+    TransactionIndex::Entry *best = NULL;
+    ncycle_t currentCycle = GetEventQueue()->GetCurrentCycle();
+
+    for( ncounter_t slotIdx = 0; slotIdx < index->GetOccupiedCount( ); slotIdx++ )
+    {
+        TransactionIndex::Entry *entry = index->GetOccupiedSlot( slotIdx );
+        ncounter_t rank = entry->rank, bank = entry->bank;
+
+        if( !activateQueued[rank][bank] 
+            || bankNeedRefresh[rank][bank]
+            || refreshQueued[rank][bank]
+            || !commandQueues[entry->queueId].empty() )
+            continue;
+
+        for( ; entry != NULL && (best == NULL || entry->order < best->order); 
+             entry = entry->slotNext )
+        {
+            if( entry->request->arrivalCycle != currentCycle
+                && pred( entry->request ) )
+            {
+                best = entry;
+                break;
+            }
+        }
+    }
+
+    if( best == NULL )
+        return false;
+
+    *oldestRequest = TakeTransaction( transactionQueue, index, best );
+
+    if( IsLastRequest( transactionQueue, (*oldestRequest) ) )
+        (*oldestRequest)->flags |= NVMainRequest::FLAG_LAST_REQUEST;
+
+    return true;
+}
+
+bool MemoryController::FindIndexedClosedBankRequest( std::list<NVMainRequest *>& transactionQueue, 
+                                                     TransactionIndex *index,
+                                                     NVMainRequest **closedRequest, 
+                                                     SchedulingPredicate& pred )
+{
+    TransactionIndex::Entry *best = NULL;
+    ncycle_t currentCycle = GetEventQueue()->GetCurrentCycle();
+
+    for( ncounter_t slotIdx = 0; slotIdx < index->GetOccupiedCount( ); slotIdx++ )
+    {
+        TransactionIndex::Entry *entry = index->GetOccupiedSlot( slotIdx );
+        ncounter_t rank = entry->rank, bank = entry->bank;
+
+        if( activateQueued[rank][bank] 
+            || bankNeedRefresh[rank][bank]
+            || refreshQueued[rank][bank]
+            || !commandQueues[entry->queueId].empty() )
+            continue;
+
+        for( ; entry != NULL && (best == NULL || entry->order < best->order); 
+             entry = entry->slotNext )
+        {
+            if( entry->request->arrivalCycle != currentCycle
+                && pred( entry->request ) )
+            {
+                best = entry;
+                break;
+            }
+        }
+    }
+
+    if( best == NULL )
+        return false;
+
+    *closedRequest = TakeTransaction( transactionQueue, index, best );
+
+    if( IsLastRequest( transactionQueue, (*closedRequest) ) )
+        (*closedRequest)->flags |= NVMainRequest::FLAG_LAST_REQUEST;
+
+    return true;
+}
+
 bool MemoryController::DummyPredicate::operator() ( NVMainRequest* /*request*/ )
 {
     return true;
@@ -1504,20 +1962,20 @@ bool MemoryController::IssueMemoryCommands( NVMainRequest *req )
             req->issueCycle = GetEventQueue()->GetCurrentCycle();
 
             // Update starvation ??
-            commandQueues[queueId].push_back( req );
+            EnqueueCommand( queueId, req );
 
-            delete cachedRequest;
+            ReleaseCommand( cachedRequest );
 
             return true;
         }
         else
         {
-            delete cachedRequest;
+            ReleaseCommand( cachedRequest );
         }
     }
     else
     {
-        delete cachedRequest;
+        ReleaseCommand( cachedRequest );
     }
 
     if( !activateQueued[rank][bank] && commandQueues[queueId].empty() )
@@ -1533,7 +1991,7 @@ bool MemoryController::IssueMemoryCommands( NVMainRequest *req )
 
         NVMainRequest *actRequest = MakeActivateRequest( req );
         actRequest->flags |= (writingArray != NULL && writingArray->IsWriting( )) ? NVMainRequest::FLAG_PRIORITY : 0;
-        commandQueues[queueId].push_back( actRequest );
+        EnqueueCommand( queueId, actRequest );
 
         /* Different row buffer management policy has different behavior */ 
         /*
@@ -1544,7 +2002,7 @@ bool MemoryController::IssueMemoryCommands( NVMainRequest *req )
          */
         if( req->flags & NVMainRequest::FLAG_LAST_REQUEST && p->UsePrecharge )
         {
-            commandQueues[queueId].push_back( MakeImplicitPrechargeRequest( req ) );
+            EnqueueCommand( queueId, MakeImplicitPrechargeRequest( req ) );
             activeSubArray[rank][bank][subarray] = false;
             effectiveRow[rank][bank][subarray] = p->ROWS;
             effectiveMuxedRow[rank][bank][subarray] = p->ROWS;
@@ -1552,7 +2010,7 @@ bool MemoryController::IssueMemoryCommands( NVMainRequest *req )
         }
         else
         {
-            commandQueues[queueId].push_back( req );
+            EnqueueCommand( queueId, req );
         }
 
         rv = true;
@@ -1571,14 +2029,14 @@ bool MemoryController::IssueMemoryCommands( NVMainRequest *req )
 
         if( activeSubArray[rank][bank][subarray] && p->UsePrecharge )
         {
-            commandQueues[queueId].push_back( 
+            EnqueueCommand( queueId, 
                     MakePrechargeRequest( effectiveRow[rank][bank][subarray], 0, bank, rank, subarray ) );
         }
 
         NVMainRequest *actRequest = MakeActivateRequest( req );
         actRequest->flags |= (writingArray != NULL && writingArray->IsWriting( )) ? NVMainRequest::FLAG_PRIORITY : 0;
-        commandQueues[queueId].push_back( actRequest );
-        commandQueues[queueId].push_back( req );
+        EnqueueCommand( queueId, actRequest );
+        EnqueueCommand( queueId, req );
         activeSubArray[rank][bank][subarray] = true;
         effectiveRow[rank][bank][subarray] = row;
         effectiveMuxedRow[rank][bank][subarray] = muxLevel;
@@ -1606,7 +2064,7 @@ bool MemoryController::IssueMemoryCommands( NVMainRequest *req )
             /* if Restricted Close-Page is applied, we should never be here */
             assert( p->ClosePage != 2 );
 
-            commandQueues[queueId].push_back( MakeImplicitPrechargeRequest( req ) );
+            EnqueueCommand( queueId, MakeImplicitPrechargeRequest( req ) );
             activeSubArray[rank][bank][subarray] = false;
             effectiveRow[rank][bank][subarray] = p->ROWS;
             effectiveMuxedRow[rank][bank][subarray] = p->ROWS;
@@ -1626,7 +2084,7 @@ bool MemoryController::IssueMemoryCommands( NVMainRequest *req )
         }
         else
         {
-            commandQueues[queueId].push_back( req );
+            EnqueueCommand( queueId, req );
         }
 
         rv = true;
@@ -1676,6 +2134,7 @@ void MemoryController::CycleCommandQueues( )
                          << std::dec << " for queue " << queueId << std::endl;
 
             GetChild( )->IssueCommand( queueHead );
+            CommandIssued( queueHead );
 
             queueHead->flags |= NVMainRequest::FLAG_ISSUED;
 
@@ -1785,37 +2244,113 @@ ncounter_t MemoryController::GetCommandQueueId( NVMAddress addr )
     return queueId;
 }
 
-ncycle_t MemoryController::NextIssuable( NVMainRequest * /*request*/ )
+void MemoryController::EnqueueCommand( ncounter_t queueId, NVMainRequest *command )
 {
-    /* Determine the next time we need to wakeup. */
-    ncycle_t nextWakeup = std::numeric_limits<ncycle_t>::max( );
+    commandQueues[queueId].push_back( command );
 
-    /* Check for memory commands to issue. */
+    if( commandQueues[queueId].size( ) == 1 )
+        MarkQueueStale( queueId );
+}
+
+void MemoryController::MarkQueueStale( ncounter_t queueId )
+{
+    if( watchedQueueRank[queueId] == p->RANKS || queueStale[queueId] )
+        return;
+
+    queueStale[queueId] = true;
+    staleQueues.push_back( queueId );
+}
+
+void MemoryController::CommandIssued( NVMainRequest *command )
+{
+    ncounter_t issuedRank = command->address.GetRank( );
+    bool notifiesRanks = (command->type == READ || command->type == READ_PRECHARGE
+                       || command->type == WRITE || command->type == WRITE_PRECHARGE);
+
+    /* Any timing in the rank the command went to may have moved. */
+    for( ncounter_t i = 0; i < rankWatchedQueues[issuedRank].size( ); i++ )
+        MarkQueueStale( rankWatchedQueues[issuedRank][i] );
+
+    if( !notifiesRanks )
+        return;
+
+    /* Other ranks only see the bus turnaround for their reads and writes. */
     for( ncounter_t rankIdx = 0; rankIdx < p->RANKS; rankIdx++ )
     {
-        for( ncounter_t bankIdx = 0; bankIdx < p->BANKS; bankIdx++ )
+        if( rankIdx == issuedRank )
+            continue;
+
+        for( ncounter_t i = 0; i < rankWatchedQueues[rankIdx].size( ); i++ )
         {
-            ncounter_t queueIdx = GetCommandQueueId( NVMAddress( 0, 0, bankIdx, rankIdx, 0, 0 ) );
+            ncounter_t queueIdx = rankWatchedQueues[rankIdx][i];
 
-            /* Give refresh priority. */
-            if( NeedRefresh( bankIdx, rankIdx )
-                && IsRefreshBankQueueEmpty( bankIdx, rankIdx ) )
+            if( !commandQueues[queueIdx].empty( ) )
             {
-                if( lastIssueCycle != GetEventQueue()->GetCurrentCycle() )
-                    HandleRefresh( );
-                 else
-                     nextWakeup = GetEventQueue()->GetCurrentCycle() + 1;
+                OpType headType = commandQueues[queueIdx].front( )->type;
+
+                if( headType == READ || headType == READ_PRECHARGE
+                    || headType == WRITE || headType == WRITE_PRECHARGE )
+                    MarkQueueStale( queueIdx );
             }
+        }
+    }
+}
+
+void MemoryController::UpdateIssueTimes( )
+{
+    for( ncounter_t i = 0; i < staleQueues.size( ); i++ )
+    {
+        ncounter_t queueIdx = staleQueues[i];
+
+        queueStale[queueIdx] = false;
+
+        if( queueInHeap[queueIdx] )
+        {
+            issueTimes.erase( std::make_pair( queueIssueTime[queueIdx], queueIdx ) );
+            queueInHeap[queueIdx] = false;
+        }
+
+        if( commandQueues[queueIdx].empty( ) )
+            continue;
 
-            if( commandQueues[queueIdx].empty( ) )
-                continue;
+        queueIssueTime[queueIdx] = GetChild( )->NextIssuable( commandQueues[queueIdx].front( ) );
+        queueInHeap[queueIdx] = true;
+        issueTimes.insert( std::make_pair( queueIssueTime[queueIdx], queueIdx ) );
+    }
+
+    staleQueues.clear( );
+}
 
-            NVMainRequest *queueHead = commandQueues[queueIdx].at( 0 );
+ncycle_t MemoryController::NextIssuable( NVMainRequest * /*request*/ )
+{
+    /* Determine the next time we need to wakeup. */
+    ncycle_t nextWakeup = std::numeric_limits<ncycle_t>::max( );
 
-            nextWakeup = MIN( nextWakeup, GetChild( )->NextIssuable( queueHead ) );
+    /* Give refresh priority. */
+    if( refreshGroupsDue > 0 )
+    {
+        for( ncounter_t rankIdx = 0; rankIdx < p->RANKS; rankIdx++ )
+        {
+            for( ncounter_t bankIdx = 0; bankIdx < p->BANKS; bankIdx++ )
+            {
+                if( NeedRefresh( bankIdx, rankIdx )
+                    && IsRefreshBankQueueEmpty( bankIdx, rankIdx ) )
+                {
+                    if( lastIssueCycle != GetEventQueue()->GetCurrentCycle() )
+                        HandleRefresh( );
+                     else
+                         nextWakeup = GetEventQueue()->GetCurrentCycle() + 1;
+                }
+            }
         }
     }
 
+    /* Check for memory commands to issue. */
+    UpdateIssueTimes( );
+
+    if( !issueTimes.empty( ) )
+        nextWakeup = MIN( nextWakeup, issueTimes.begin( )->first );
+
     if( nextWakeup <= GetEventQueue( )->GetCurrentCycle( ) )
         nextWakeup = GetEventQueue( )->GetCurrentCycle( ) + 1;
 
@@ -40,19 +40,21 @@
 #include <vector>
 #include "src/NVMObject.h"
 #include "src/Config.h"
+#include "src/Params.h"
 #include "src/Interconnect.h"
 #include "src/AddressTranslator.h"
+#include "src/TransactionIndex.h"
 #include "include/NVMainRequest.h"
 #include <deque>
 #include <iostream>
 #include <list>
+#include <set>
 
 
 namespace NVM {
 
 
 enum ProcessorOp { LOAD, STORE };
-enum QueueModel { PerRankQueues, PerBankQueues, PerSubArrayQueues };
 
 /*
  *  If the transaction queue has higher priority, it is possible for a
@@ -104,7 +106,7 @@ class MemoryController : public NVMObject
     ~MemoryController( );
 
 
-    void InitQueues( unsigned int numQueues );
+    void InitQueues( unsigned int numQueues, bool indexed = false );
     void InitBankQueues( unsigned int numQueues );
 
     virtual bool RequestComplete( NVMainRequest *request );
@@ -142,6 +144,44 @@ class MemoryController : public NVMObject
 
     ncounter_t GetCommandQueueId( NVMAddress addr );
 
+    /* Append a command to a queue, refreshing its issue time if it is the new head. */
+    void EnqueueCommand( ncounter_t queueId, NVMainRequest *command );
+    /* Invalidate the issue times a command issued to the child may have moved. */
+    void CommandIssued( NVMainRequest *command );
+    void MarkQueueStale( ncounter_t queueId );
+    void UpdateIssueTimes( );
+
+    /*
+     *  Earliest cycle the head of each watched command queue may issue, as
+     *  last reported by the child, ordered so the next wakeup is the first
+     *  entry. A queue's time only changes when its head changes or a command
+     *  is issued to its rank (or, for reads and writes, to any rank since
+     *  the interconnect notifies the others), so NextIssuable() recomputes
+     *  just the queues marked stale since the previous call.
+     */
+    std::set< std::pair<ncycle_t, ncounter_t> > issueTimes;
+    std::vector<ncycle_t> queueIssueTime;
+    std::vector<bool> queueInHeap;
+    std::vector<bool> queueStale;
+    std::vector<ncounter_t> staleQueues;
+    /* Queues NextIssuable() watches for each rank, and the rank of each queue. */
+    std::vector< std::vector<ncounter_t> > rankWatchedQueues;
+    std::vector<ncounter_t> watchedQueueRank;
+
+    /* 
+     *  Optional per-queue indices (see TransactionIndex) and the number of
+     *  queued transactions per command queue. Only allocated for controllers
+     *  that request them in InitQueues and queue requests through Enqueue()
+     *  and Prequeue() exclusively.
+     */
+    bool indexTransactions;
+    TransactionIndex *transactionIndices;
+    ncounter_t *queuedTransactions;
+
+    TransactionIndex *GetTransactionIndex( std::list<NVMainRequest *>& transactionQueue );
+    NVMainRequest *TakeTransaction( std::list<NVMainRequest *>& transactionQueue, 
+                                    TransactionIndex *index, TransactionIndex::Entry *entry );
+
     bool **activateQueued;
     bool **refreshQueued;
     ncounter_t ***effectiveRow;
@@ -158,6 +198,32 @@ class MemoryController : public NVMObject
     void Prequeue( ncounter_t queueNum, NVMainRequest *request );
     void Enqueue( ncounter_t queueNum, NVMainRequest *request );
 
+    /*
+     *  Latency histograms for completed reads and writes, split into time
+     *  spent in the transaction queue, time from issue to completion and the
+     *  total, with the total also kept per rank. Controllers that track
+     *  latency call RegisterLatencyStats() and RecordLatency().
+     */
+    LogHistogram readLatency, writeLatency;
+    LogHistogram readQueueLatency, writeQueueLatency;
+    LogHistogram readTotalLatency, writeTotalLatency;
+    std::vector<LogHistogram> rankReadTotalLatency, rankWriteTotalLatency;
+
+    void RegisterLatencyStats( );
+    void RecordLatency( NVMainRequest *request );
+    double MeanLatency( const Distribution& reads, const Distribution& writes );
+
+    /*
+     *  Commands made by the controller (activates, precharges, refreshes,
+     *  powerdowns and cached probes) are recycled through a free-list rather
+     *  than going back to the heap. A command is returned to the list when it
+     *  completes, or by the caller for probes that are never issued. Commands
+     *  point at their triggering transaction instead of copying its data.
+     */
+    std::vector<NVMainRequest *> freeCommands;
+    NVMainRequest *AllocateCommand( NVMainRequest *triggerRequest = NULL );
+    void ReleaseCommand( NVMainRequest *command );
+
     NVMainRequest *MakeCachedRequest( NVMainRequest *triggerRequest );
     NVMainRequest *MakeActivateRequest( NVMainRequest *triggerRequest );
     NVMainRequest *MakeActivateRequest( const ncounter_t, const ncounter_t, 
@@ -205,6 +271,12 @@ class MemoryController : public NVMObject
     bool FindOldestReadyRequests( std::list<NVMainRequest *>& transactionQueue, std::vector<NVMainRequest *>& oldestRequests, NVM::SchedulingPredicate& p  );
     bool FindClosedBankRequests( std::list<NVMainRequest *>& transactionQueue, std::vector<NVMainRequest *>& closedRequests, NVM::SchedulingPredicate& p  );
 
+    /* Indexed versions of the searches above, same results without walking the queue. */
+    bool FindIndexedStarvedRequest( std::list<NVMainRequest *>& transactionQueue, TransactionIndex *index, NVMainRequest **starvedRequest, NVM::SchedulingPredicate& p );
+    bool FindIndexedRowBufferHit( std::list<NVMainRequest *>& transactionQueue, TransactionIndex *index, NVMainRequest **hitRequest, NVM::SchedulingPredicate& p );
+    bool FindIndexedOldestReadyRequest( std::list<NVMainRequest *>& transactionQueue, TransactionIndex *index, NVMainRequest **oldestRequest, NVM::SchedulingPredicate& p );
+    bool FindIndexedClosedBankRequest( std::list<NVMainRequest *>& transactionQueue, TransactionIndex *index, NVMainRequest **closedRequest, NVM::SchedulingPredicate& p );
+
     /* IsLastRequest() tells whether no other request has the row buffer hit in the transaction queue */
     virtual bool IsLastRequest( std::list<NVMainRequest *>& transactionQueue, NVMainRequest *request); 
     /* curQueue records the starting index for queue round-robin level scheduling */
@@ -213,6 +285,8 @@ class MemoryController : public NVMObject
     void MoveCurrentQueue( ); 
     /* record how many refresh should be handled */
     ncounter_t **delayedRefreshCounter; 
+    /* number of bank groups whose delayedRefreshCounter reached the threshold */
+    ncounter_t refreshGroupsDue;
 
     /* indicate whether the bank need to be refreshed immediately */
     bool **bankNeedRefresh;
@@ -267,6 +341,9 @@ class MemoryController : public NVMObject
 
     /* Stats */
     ncounter_t simulation_cycles;
+    ncounter_t commandsCreated;
+    ncounter_t commandAllocations;
+    Histogram transactionQueueDepth;
 };
 
 };
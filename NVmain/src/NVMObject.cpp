@@ -270,6 +270,7 @@ NVMObject *NVMObject_hook::GetTrampoline( )
 NVMObject::NVMObject( )
 {
     parent = NULL;
+    selfHook = NULL;
     decoder = NULL;
     children.clear( );
     eventQueue = NULL;
@@ -402,6 +403,20 @@ void NVMObject::SetParent( NVMObject *p )
     NVMObject_hook *hook = new NVMObject_hook( p );
 
     parent = hook;
+
+    /* If the parent already added us as a child, point at that hook. */
+    std::vector<NVMObject_hook *>& siblings = p->GetChildren( );
+    std::vector<NVMObject_hook *>::iterator it;
+
+    for( it = siblings.begin(); it != siblings.end(); it++ )
+    {
+        if( (*it)->GetTrampoline() == this )
+        {
+            selfHook = (*it);
+            break;
+        }
+    }
+
     SetEventQueue( p->GetEventQueue( ) );
     SetGlobalEventQueue( p->GetGlobalEventQueue( ) );
     SetStats( p->GetStats( ) );
@@ -433,6 +448,17 @@ void NVMObject::AddChild( NVMObject *c )
         }
     }
 
+    /*
+     *  Some objects are children of several modules (e.g., main memory behind
+     *  DRAM caches). Events are delivered through the hook held by the parent
+     *  module, so prefer that one and otherwise keep the first hook created.
+     */
+    if( c->selfHook == NULL 
+        || (c->parent != NULL && c->parent->GetTrampoline( ) == this) )
+    {
+        c->selfHook = hook;
+    }
+
     children.push_back( hook );
 }
 
@@ -484,6 +510,27 @@ NVMObject_hook* NVMObject::GetParent( )
     return parent;
 }
 
+NVMObject_hook *NVMObject::GetSelfHook( )
+{
+    if( selfHook != NULL )
+        return selfHook;
+
+    /* Not attached with AddChild; search the parent's children list. */
+    if( parent == NULL )
+        return NULL;
+
+    std::vector<NVMObject_hook *>& siblings = parent->GetTrampoline( )->GetChildren( );
+    std::vector<NVMObject_hook *>::iterator it;
+
+    for( it = siblings.begin(); it != siblings.end(); it++ )
+    {
+        if( (*it)->GetTrampoline() == this )
+            return (*it);
+    }
+
+    return NULL;
+}
+
 std::vector<NVMObject_hook *>& NVMObject::GetChildren( )
 {
     return children;
@@ -708,7 +755,7 @@ void NVMObject::SetDebugName( std::string dn, Config *config )
     }
     else
     {
-        debugStream = &nvmainDebugInhibitor;
+        debugStream = config->GetDebugInhibitor( );
     }
 }
 
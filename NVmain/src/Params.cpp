@@ -103,6 +103,7 @@ Params::Params( )
     EnduranceModel = "NullModel";
     DataEncoder = "default";
     EnergyModel = "current";
+    energyModel = EnergyModel_Current;
 
     UseLowPower = true;
     PowerDownMode = "FASTEXIT";
@@ -175,6 +176,9 @@ Params::Params( )
     MemoryPrefetcher = "none";
     PrefetchBufferSize = 32;
 
+    ParallelChannels = false;
+    ParallelChannelThreads = 0;
+
     programMode = ProgramMode_SRMS;
     MLCLevels = 1;
     WPVariance = 1;
@@ -198,6 +202,10 @@ Params::Params( )
     MaxCancellations = 4;
     pauseMode = PauseMode_Normal;
 
+    writeMode = WRITE_THROUGH;
+    /* Per-bank queues were the default for older nvmain versions. */
+    queueModel = PerBankQueues;
+
     DeadlockTimer = 10000000;
 
     debugOn = false;
@@ -293,6 +301,7 @@ void Params::SetParams( Config *c )
     c->GetString( "EnduranceModel", EnduranceModel );
     c->GetString( "DataEncoder", DataEncoder );
     c->GetString( "EnergyModel", EnergyModel );
+    energyModel = (EnergyModel == "current") ? EnergyModel_Current : EnergyModel_Energy;
 
     c->GetBool( "UseLowPower", UseLowPower );
     c->GetString( "PowerDownMode", PowerDownMode );
@@ -365,6 +374,9 @@ void Params::SetParams( Config *c )
     c->GetString( "MemoryPrefetcher", MemoryPrefetcher );
     c->GetValueUL( "PrefetchBufferSize", PrefetchBufferSize );
 
+    c->GetBool( "ParallelChannels", ParallelChannels );
+    c->GetValueUL( "ParallelChannelThreads", ParallelChannelThreads );
+
     if( c->KeyExists( "ProgramMode" ) )
     {
         if( c->GetString( "ProgramMode" ) == "SRMS" )
@@ -424,5 +436,28 @@ void Params::SetParams( Config *c )
             std::cout << "Unknown PauseMode: " << c->GetString( "PauseMode" )
                       << ". Defaulting to Normal" << std::endl;
     }
+
+    if( c->KeyExists( "WriteMode" ) )
+    {
+        if( c->GetString( "WriteMode" ) == "WriteThrough" )
+            writeMode = WRITE_THROUGH;
+        else if( c->GetString( "WriteMode" ) == "WriteBack" )
+            writeMode = WRITE_BACK;
+        else
+            std::cout << "NVMain Warning: Unknown write mode `"
+                      << c->GetString( "WriteMode" )
+                      << "'. Defaulting to WriteThrough" << std::endl;
+    }
+
+    if( c->KeyExists( "QueueModel" ) )
+    {
+        if( c->GetString( "QueueModel" ) == "PerRank" )
+            queueModel = PerRankQueues;
+        else if( c->GetString( "QueueModel" ) == "PerBank" )
+            queueModel = PerBankQueues;
+        else if( c->GetString( "QueueModel" ) == "PerSubArray" )
+            queueModel = PerSubArrayQueues;
+        /* Add your custom types here. */
+    }
 }
 
@@ -56,6 +56,19 @@ enum PauseMode {
     PauseMode_Optimal   ///< Optimal: Same as IIWC, but consider iteration complete
 };
 
+enum EnergyModelType {
+    EnergyModel_Current,    ///< IDD current based DRAM power model ("current")
+    EnergyModel_Energy      ///< Per-access energies from the config (anything else)
+};
+
+enum WriteMode {
+    WRITE_BACK,     ///< only modify the row buffer
+    WRITE_THROUGH,  ///< modify both row buffer and cell
+    DELAYED_WRITE   ///< data is stored in a write buffer
+};
+
+enum QueueModel { PerRankQueues, PerBankQueues, PerSubArrayQueues };
+
 class Params
 {
   public:
@@ -104,6 +117,7 @@ class Params
     std::string EnduranceModel;
     std::string DataEncoder;
     std::string EnergyModel;
+    EnergyModelType energyModel;
 
     bool UseLowPower;
     std::string PowerDownMode;
@@ -176,6 +190,9 @@ class Params
     std::string MemoryPrefetcher;
     ncounter_t PrefetchBufferSize;
 
+    bool ParallelChannels; // one event queue and thread per channel
+    ncounter_t ParallelChannelThreads; // 0 = one per channel, up to #cores
+
     ProgramMode programMode;
     ncounter_t MLCLevels;
     ncounter_t WPVariance;
@@ -209,6 +226,9 @@ class Params
     ncounter_t MaxCancellations;
     PauseMode pauseMode;
 
+    WriteMode writeMode;
+    QueueModel queueModel;
+
   private:
     void ConvertTiming( Config *conf, std::string param, ncycle_t& value );
     ncycle_t ConvertTiming( Config *conf, std::string param );
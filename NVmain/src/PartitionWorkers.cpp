@@ -0,0 +1,126 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#include "src/PartitionWorkers.h"
+#include "src/EventQueue.h"
+
+using namespace NVM;
+
+PartitionWorkers::PartitionWorkers( ncounter_t threads )
+    : work( NULL ), target( 0 ), generation( 0 ), busyHelpers( 0 ),
+      stopping( false ), nextQueue( 0 )
+{
+    for( ncounter_t i = 1; i < threads; i++ )
+        helpers.push_back( std::thread( &PartitionWorkers::Helper, this ) );
+}
+
+PartitionWorkers::~PartitionWorkers( )
+{
+    {
+        std::lock_guard<std::mutex> guard( lock );
+        stopping = true;
+    }
+    startWork.notify_all( );
+
+    for( ncounter_t i = 0; i < helpers.size( ); i++ )
+        helpers[i].join( );
+}
+
+ncounter_t PartitionWorkers::GetThreadCount( )
+{
+    return helpers.size( ) + 1;
+}
+
+void PartitionWorkers::Advance( std::vector<EventQueue *>& queues, ncycle_t when )
+{
+    {
+        std::lock_guard<std::mutex> guard( lock );
+
+        work = &queues;
+        target = when;
+        nextQueue.store( 0, std::memory_order_relaxed );
+        busyHelpers = helpers.size( );
+        generation++;
+    }
+    startWork.notify_all( );
+
+    RunQueues( );
+
+    /* The lock hand-off also publishes the helpers' queue updates. */
+    std::unique_lock<std::mutex> guard( lock );
+    workDone.wait( guard, [this] { return busyHelpers == 0; } );
+    work = NULL;
+}
+
+void PartitionWorkers::Helper( )
+{
+    ncounter_t seenGeneration = 0;
+
+    for( ;; )
+    {
+        {
+            std::unique_lock<std::mutex> guard( lock );
+            startWork.wait( guard, [&] { 
+                return stopping || generation != seenGeneration; } );
+
+            if( stopping )
+                return;
+
+            seenGeneration = generation;
+        }
+
+        RunQueues( );
+
+        {
+            std::lock_guard<std::mutex> guard( lock );
+            if( --busyHelpers == 0 )
+                workDone.notify_one( );
+        }
+    }
+}
+
+void PartitionWorkers::RunQueues( )
+{
+    std::vector<EventQueue *>& queues = *work;
+
+    for( ;; )
+    {
+        ncounter_t index = nextQueue.fetch_add( 1, std::memory_order_relaxed );
+
+        if( index >= queues.size( ) )
+            break;
+
+        EventQueue *queue = queues[index];
+        queue->Loop( target - queue->GetCurrentCycle( ) );
+    }
+}
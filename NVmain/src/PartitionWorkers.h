@@ -0,0 +1,84 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#ifndef __NVMAIN_PARTITIONWORKERS_H__
+#define __NVMAIN_PARTITIONWORKERS_H__
+
+#include "include/NVMTypes.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NVM {
+
+class EventQueue;
+
+/*
+ *  A fixed pool of threads that advances independent event queues (one per
+ *  memory channel) to a common cycle. The calling thread takes part in the
+ *  work, so a pool of N threads starts N - 1 helpers. Queues are claimed
+ *  one at a time, which keeps a busy channel from stalling the others.
+ */
+class PartitionWorkers
+{
+  public:
+    PartitionWorkers( ncounter_t threads );
+    ~PartitionWorkers( );
+
+    /* Run every queue up to and including cycle `when' and wait for all. */
+    void Advance( std::vector<EventQueue *>& queues, ncycle_t when );
+
+    ncounter_t GetThreadCount( );
+
+  private:
+    std::vector<std::thread> helpers;
+    std::mutex lock;
+    std::condition_variable startWork;
+    std::condition_variable workDone;
+
+    std::vector<EventQueue *> *work;
+    ncycle_t target;
+    ncounter_t generation;
+    ncounter_t busyHelpers;
+    bool stopping;
+    std::atomic<ncounter_t> nextQueue;
+
+    void Helper( );
+    void RunQueues( );
+};
+
+};
+
+#endif
@@ -33,48 +33,305 @@
 
 #include "src/SimInterface.h"
 #include "src/Config.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace NVM;
 
-int SimInterface::GetDataAtAddress( uint64_t address, NVMDataBlock *data )
+SimInterface::SimInterface( )
+{
+    conf = NULL;
+
+    imageData = NULL;
+    imageSize = 0;
+    imageFd = -1;
+}
+
+SimInterface::~SimInterface( )
+{
+    std::unordered_map< uint64_t, DataPage* >::iterator it;
+
+    for( it = dataPages.begin( ); it != dataPages.end( ); ++it )
+    {
+        delete [] it->second->storage;
+        delete it->second;
+    }
+
+    UnmapImage( );
+}
+
+/*
+ *  Returns the page holding address. Pages covered by the memory image
+ *  are created on first use whether or not allocate is set.
+ */
+SimInterface::DataPage *SimInterface::GetDataPage( uint64_t address, bool allocate )
+{
+    uint64_t pageNumber = address / pageBytes;
+    std::unordered_map< uint64_t, DataPage* >::iterator it = dataPages.find( pageNumber );
+
+    if( it != dataPages.end( ) )
+        return it->second;
+
+    uint64_t pageStart = pageNumber * pageBytes;
+    bool inImage = (imageData != NULL && pageStart < imageSize);
+
+    if( !inImage && !allocate )
+        return NULL;
+
+    DataPage *page = new DataPage( );
+
+    memset( page->slots, noSlot, sizeof(page->slots) );
+    page->usedSlots = 0;
+    page->slotCapacity = 0;
+    page->writtenLines = 0;
+    page->validLines = 0;
+    page->imageLines = 0;
+    page->storage = NULL;
+
+    if( inImage )
+    {
+        for( uint64_t line = 0; line < linesPerPage; line++ )
+        {
+            if( pageStart + line * lineBytes < imageSize )
+                page->imageLines |= (1ULL << line);
+        }
+
+        page->writtenLines = page->validLines = page->imageLines;
+    }
+
+    dataPages[pageNumber] = page;
+
+    return page;
+}
+
+/*
+ *  Returns the line holding address in page, followed by its LineInfo. If
+ *  allocate is set, a line that is not stored yet is added to the page.
+ */
+uint8_t *SimInterface::GetLine( DataPage *page, uint64_t address, bool allocate )
 {
-    int retval;
+    uint64_t line = (address % pageBytes) / lineBytes;
+
+    if( page->slots[line] != noSlot )
+        return page->storage + page->slots[line] * slotBytes;
 
-    if( !memoryData.count( address ) )
+    if( !allocate )
+        return NULL;
+
+    /* Grow the page by doubling until it can hold every line. */
+    if( page->usedSlots == page->slotCapacity )
     {
-        retval = 0;
+        uint64_t capacity = (page->slotCapacity == 0) ? 1 : 2 * page->slotCapacity;
+        uint8_t *storage = new uint8_t[capacity * slotBytes];
+
+        if( page->storage != NULL )
+        {
+            memcpy( storage, page->storage, page->usedSlots * slotBytes );
+            delete [] page->storage;
+        }
+
+        page->storage = storage;
+        page->slotCapacity = static_cast<uint8_t>( capacity );
     }
+
+    page->slots[line] = page->usedSlots++;
+
+    uint8_t *lineData = page->storage + page->slots[line] * slotBytes;
+    LineInfo info;
+
+    /* Lines from the memory image start out with its contents. */
+    if( (page->imageLines >> line) & 0x1 )
+        memcpy( lineData, imageData + (address - address % lineBytes), lineBytes );
     else
+        memset( lineData, 0, lineBytes );
+
+    info.size = static_cast<uint32_t>( lineBytes );
+    info.accessCount = 0;
+    memcpy( lineData + lineBytes, &info, sizeof(info) );
+
+    return lineData;
+}
+
+void SimInterface::CopyIn( uint64_t address, const uint8_t *data, uint64_t bytes )
+{
+    while( bytes > 0 )
     {
-        if( data )
-            data = memoryData[ address ];
-        retval = 1;
+        uint64_t offset = address % lineBytes;
+        uint64_t chunk = std::min( bytes, lineBytes - offset );
+        uint8_t *lineData = GetLine( GetDataPage( address, true ), address, true );
+
+        memcpy( lineData + offset, data, chunk );
+
+        address += chunk;
+        data += chunk;
+        bytes -= chunk;
     }
+}
+
+void SimInterface::CopyOut( uint64_t address, uint8_t *data, uint64_t bytes )
+{
+    while( bytes > 0 )
+    {
+        uint64_t offset = address % lineBytes;
+        uint64_t chunk = std::min( bytes, lineBytes - offset );
+        uint64_t line = (address % pageBytes) / lineBytes;
+        DataPage *page = GetDataPage( address, false );
+        uint8_t *lineData = (page != NULL) ? GetLine( page, address, false ) : NULL;
+
+        if( lineData != NULL )
+            memcpy( data, lineData + offset, chunk );
+        else if( page != NULL && ((page->imageLines >> line) & 0x1) )
+            memcpy( data, imageData + address, chunk );
+        else
+            memset( data, 0, chunk );
 
-    return retval;
+        address += chunk;
+        data += chunk;
+        bytes -= chunk;
+    }
 }
 
-void SimInterface::SetDataAtAddress( uint64_t address, NVMDataBlock& data )
+int SimInterface::GetDataAtAddress( uint64_t address, NVMDataBlock *data )
 {
-    if( !accessCounts.count( address ) )
+    std::lock_guard<std::mutex> guard( memoryDataLock );
+    DataPage *page = GetDataPage( address, false );
+    uint64_t line = (address % pageBytes) / lineBytes;
+
+    if( page == NULL || !((page->writtenLines >> line) & 0x1) )
+        return 0;
+
+    if( data )
     {
-        NVMDataBlock *newData = new NVMDataBlock( );
-        memoryData[ address ] = newData;
-        *newData = data;
-        accessCounts[ address ] = 0;
+        NVMDataBlock storedData;
+        uint8_t *lineData = GetLine( page, address, false );
+        uint64_t size = lineBytes;
+
+        if( lineData != NULL )
+            size = reinterpret_cast<LineInfo *>(lineData + lineBytes)->size;
+
+        if( size > 0 )
+        {
+            storedData.SetSize( size );
+            CopyOut( address, storedData.rawData, size );
+        }
+
+        storedData.SetValid( (page->validLines >> line) & 0x1 );
+
+        *data = std::move( storedData );
     }
+
+    return 1;
+}
+
+void SimInterface::SetDataAtAddress( uint64_t address, NVMDataBlock& data )
+{
+    std::lock_guard<std::mutex> guard( memoryDataLock );
+    uint64_t size = (data.rawData != NULL) ? data.GetSize( ) : 0;
+
+    if( size > 0 )
+        CopyIn( address, data.rawData, size );
+
+    DataPage *page = GetDataPage( address, true );
+    uint64_t line = (address % pageBytes) / lineBytes;
+    LineInfo *info = reinterpret_cast<LineInfo *>(GetLine( page, address, true ) + lineBytes);
+
+    if( (page->writtenLines >> line) & 0x1 )
+        info->accessCount++;
+
+    info->size = static_cast<uint32_t>( size );
+    page->writtenLines |= (1ULL << line);
+
+    if( data.IsValid( ) )
+        page->validLines |= (1ULL << line);
     else
+        page->validLines &= ~(1ULL << line);
+}
+
+unsigned int SimInterface::GetAccessCount( uint64_t address )
+{
+    std::lock_guard<std::mutex> guard( memoryDataLock );
+    DataPage *page = GetDataPage( address, false );
+    uint8_t *lineData = (page != NULL) ? GetLine( page, address, false ) : NULL;
+
+    if( lineData == NULL )
+        return 0;
+
+    return reinterpret_cast<LineInfo *>(lineData + lineBytes)->accessCount;
+}
+
+bool SimInterface::MapImage( std::string file )
+{
+    struct stat imageStat;
+
+    imageFd = open( file.c_str( ), O_RDONLY );
+    if( imageFd < 0 || fstat( imageFd, &imageStat ) != 0 )
+    {
+        std::cerr << "NVMain Error: Could not open memory image: " << file << std::endl;
+        UnmapImage( );
+        return false;
+    }
+
+    imageSize = static_cast<uint64_t>(imageStat.st_size);
+
+    if( imageSize == 0 )
+    {
+        UnmapImage( );
+        return true;
+    }
+
+    /* Round up so lines at the end of the file can be read whole. */
+    uint64_t mapSize = ((imageSize + pageBytes - 1) / pageBytes) * pageBytes;
+    void *mapping = mmap( NULL, mapSize, PROT_READ, MAP_PRIVATE, imageFd, 0 );
+
+    if( mapping == MAP_FAILED )
     {
-        NVMDataBlock *newData = memoryData[ address ];
-        *newData = data;
-        accessCounts[ address ]++;
+        std::cerr << "NVMain Error: Could not map memory image: " << file << std::endl;
+        UnmapImage( );
+        return false;
     }
+
+    imageData = static_cast<const uint8_t *>(mapping);
+
+    return true;
+}
+
+void SimInterface::UnmapImage( )
+{
+    if( imageData != NULL )
+    {
+        uint64_t mapSize = ((imageSize + pageBytes - 1) / pageBytes) * pageBytes;
+        munmap( const_cast<uint8_t *>(imageData), mapSize );
+    }
+
+    if( imageFd >= 0 )
+        close( imageFd );
+
+    imageData = NULL;
+    imageSize = 0;
+    imageFd = -1;
 }
 
 void SimInterface::SetConfig( Config *config, bool /*createChildren*/ )
 {
     conf = config;
+
+    if( config->KeyExists( "MemoryImageFile" ) )
+    {
+        std::lock_guard<std::mutex> guard( memoryDataLock );
+
+        if( imageData == NULL && dataPages.empty( ) )
+        {
+            std::string imageFile = config->GetString( "MemoryImageFile" );
+
+            if( !MapImage( imageFile ) )
+                exit(1);
+        }
+    }
 }
 
 Config *SimInterface::GetConfig( )
@@ -36,6 +36,9 @@
 
 #include <stdint.h>
 #include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include "include/NVMDataBlock.h"
 
 namespace NVM {
@@ -44,8 +47,8 @@ class Config;
 class SimInterface
 {
   public:
-    SimInterface( ) { }
-    virtual ~SimInterface( ) { }
+    SimInterface( );
+    virtual ~SimInterface( );
 
     virtual unsigned int GetInstructionCount( int ) = 0;
     virtual unsigned int GetCacheMisses( int, int ) = 0;
@@ -55,17 +58,70 @@ class SimInterface
     virtual bool HasCacheMisses( ) = 0;
     virtual bool HasCacheHits( ) = 0;
 
+    /* Copies the data last written to address into data (if not NULL). */
     virtual int  GetDataAtAddress( uint64_t address, NVMDataBlock *data );
     virtual void SetDataAtAddress( uint64_t address, NVMDataBlock& data );
 
+    /* Number of times the data at address was overwritten. */
+    unsigned int GetAccessCount( uint64_t address );
+
     void SetConfig( Config *conf, bool createChildren = true );
     Config *GetConfig( );
 
   private:
-    std::map< uint64_t, NVMDataBlock* > memoryData;
-    std::map< uint64_t, unsigned int > accessCounts;
+    /*
+     *  Data written to memory is kept in a sparse image of 4 KB pages. Each
+     *  page stores the 64-byte lines written so far contiguously, together
+     *  with the size and overwrite count of the block written at each line,
+     *  and grows as more of its lines are written. If the MemoryImageFile
+     *  parameter is set, the file is mapped read-only as the initial
+     *  contents of memory starting at address 0. Lines it covers read as
+     *  written and are copied into their page when first overwritten.
+     */
+    static const uint64_t pageBytes = 4096;
+    static const uint64_t lineBytes = 64;
+    static const uint64_t linesPerPage = pageBytes / lineBytes;
+    static const uint8_t noSlot = 0xFF;
+
+    struct LineInfo
+    {
+        uint32_t size;
+        uint32_t accessCount;
+    };
+
+    static const uint64_t slotBytes = lineBytes + sizeof(LineInfo);
+
+    struct DataPage
+    {
+        uint8_t slots[linesPerPage];
+        uint8_t usedSlots;
+        uint8_t slotCapacity;
+        uint64_t writtenLines;
+        uint64_t validLines;
+        uint64_t imageLines;
+        uint8_t *storage;
+    };
+
+    std::unordered_map< uint64_t, DataPage* > dataPages;
     Config *conf;
 
+    const uint8_t *imageData;
+    uint64_t imageSize;
+    int imageFd;
+
+    /* Channels simulated on separate threads share this store. */
+    std::mutex memoryDataLock;
+
+    DataPage *GetDataPage( uint64_t address, bool allocate );
+    uint8_t *GetLine( DataPage *page, uint64_t address, bool allocate );
+    void CopyIn( uint64_t address, const uint8_t *data, uint64_t bytes );
+    void CopyOut( uint64_t address, uint8_t *data, uint64_t bytes );
+
+    bool MapImage( std::string file );
+    void UnmapImage( );
+
+    SimInterface( const SimInterface& );
+    SimInterface& operator=( const SimInterface& );
 };
 
 };
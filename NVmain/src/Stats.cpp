@@ -34,13 +34,332 @@
 
 #include "src/Stats.h"
 
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 
 using namespace NVM;
 
 
+namespace {
+
+/* The original "iN.name value<units>" format. */
+class TextStatWriter : public StatWriter
+{
+  public:
+    TextStatWriter( std::ostream& s ) : stream(s), interval(0) { }
+
+    void BeginDump( ncounter_t i ) { interval = i; }
+    void Write( const std::string& name, int64_t value, const std::string& units ) { Line( name, value, units ); }
+    void Write( const std::string& name, uint64_t value, const std::string& units ) { Line( name, value, units ); }
+    void Write( const std::string& name, double value, const std::string& units ) { Line( name, value, units ); }
+    void Write( const std::string& name, const std::string& value, const std::string& units ) { Line( name, value, units ); }
+    void WriteUnknown( const std::string& name, const std::string& units ) { Line( name, "?????", units ); }
+    void EndDump( ) { stream.flush( ); }
+
+  private:
+    template<typename T>
+    void Line( const std::string& name, const T& value, const std::string& units )
+    {
+        stream << "i" << interval << "." << name << " " << value << units << "\n";
+    }
+
+    std::ostream& stream;
+    ncounter_t interval;
+};
+
+/* 
+ *  One JSON object per dump, so interval dumps appended to the same file can
+ *  be read back line by line. Units are listed separately.
+ */
+class JsonStatWriter : public StatWriter
+{
+  public:
+    JsonStatWriter( std::ostream& s ) : stream(s), first(true) { }
+
+    void BeginDump( ncounter_t interval )
+    {
+        stream << "{\"interval\":" << interval << ",\"stats\":{";
+    }
+
+    void Write( const std::string& name, int64_t value, const std::string& units ) 
+    { 
+        Key( name, units ); 
+        stream << value; 
+    }
+
+    void Write( const std::string& name, uint64_t value, const std::string& units ) 
+    { 
+        Key( name, units ); 
+        stream << value; 
+    }
+
+    void Write( const std::string& name, double value, const std::string& units )
+    {
+        Key( name, units );
+
+        /* JSON has no representation for NaN or infinity. */
+        if( std::isfinite( value ) )
+        {
+            std::streamsize precision = stream.precision( std::numeric_limits<double>::max_digits10 );
+            stream << value;
+            stream.precision( precision );
+        }
+        else
+        {
+            stream << "null";
+        }
+    }
+
+    void Write( const std::string& name, const std::string& value, const std::string& units )
+    {
+        Key( name, units );
+        Quote( value );
+    }
+
+    void WriteUnknown( const std::string& name, const std::string& units )
+    {
+        Key( name, units );
+        stream << "null";
+    }
+
+    void EndDump( )
+    {
+        stream << "},\"units\":{";
+
+        for( size_t i = 0; i < unitList.size( ); i++ )
+        {
+            if( i != 0 ) stream << ",";
+            Quote( unitList[i].first );
+            stream << ":";
+            Quote( unitList[i].second );
+        }
+
+        stream << "}}" << std::endl;
+    }
+
+  private:
+    void Key( const std::string& name, const std::string& units )
+    {
+        if( !first ) stream << ",";
+        first = false;
+
+        Quote( name );
+        stream << ":";
+
+        if( !units.empty( ) )
+            unitList.push_back( std::make_pair( name, units ) );
+    }
+
+    void Quote( const std::string& str )
+    {
+        stream << '"';
+        for( size_t i = 0; i < str.size( ); i++ )
+        {
+            unsigned char c = static_cast<unsigned char>(str[i]);
+
+            if( c == '"' || c == '\\' )
+                stream << '\\' << c;
+            else if( c < 0x20 )
+                stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') 
+                       << static_cast<int>(c) << std::dec << std::setfill(' ');
+            else
+                stream << c;
+        }
+        stream << '"';
+    }
+
+    std::ostream& stream;
+    bool first;
+    std::vector<std::pair<std::string, std::string> > unitList;
+};
+
+/* interval,name,value,units rows. The header is written by Stats once. */
+class CsvStatWriter : public StatWriter
+{
+  public:
+    CsvStatWriter( std::ostream& s ) : stream(s), interval(0) { }
+
+    void BeginDump( ncounter_t i ) { interval = i; }
+    void Write( const std::string& name, int64_t value, const std::string& units ) { Row( name, value, units ); }
+    void Write( const std::string& name, uint64_t value, const std::string& units ) { Row( name, value, units ); }
+
+    void Write( const std::string& name, double value, const std::string& units ) 
+    { 
+        std::streamsize precision = stream.precision( std::numeric_limits<double>::max_digits10 );
+        Row( name, value, units ); 
+        stream.precision( precision );
+    }
+
+    void Write( const std::string& name, const std::string& value, const std::string& units ) 
+    { 
+        Row( name, Escape( value ), units ); 
+    }
+
+    void WriteUnknown( const std::string& name, const std::string& units ) { Row( name, "", units ); }
+    void EndDump( ) { stream.flush( ); }
+
+  private:
+    template<typename T>
+    void Row( const std::string& name, const T& value, const std::string& units )
+    {
+        stream << interval << "," << Escape( name ) << "," << value << "," 
+               << Escape( units ) << "\n";
+    }
+
+    std::string Escape( const std::string& field )
+    {
+        if( field.find_first_of( ",\"\n" ) == std::string::npos )
+            return field;
+
+        std::string quoted = "\"";
+        for( size_t i = 0; i < field.size( ); i++ )
+        {
+            if( field[i] == '"' ) quoted += '"';
+            quoted += field[i];
+        }
+        return quoted + "\"";
+    }
+
+    std::ostream& stream;
+    ncounter_t interval;
+};
+
+}
+
+
+Distribution::Distribution( )
+{
+    samples = 0;
+    minimum = maximum = 0;
+    sum = sumSquares = 0.0;
+}
+
+double Distribution::GetMean( ) const
+{
+    return (samples == 0) ? 0.0 : sum / static_cast<double>(samples);
+}
+
+double Distribution::GetStdDev( ) const
+{
+    if( samples == 0 )
+        return 0.0;
+
+    double mean = GetMean( );
+    double variance = sumSquares / static_cast<double>(samples) - mean * mean;
+
+    return (variance > 0.0) ? std::sqrt( variance ) : 0.0;
+}
+
+Histogram::Histogram( )
+{
+    SetBuckets( 1, 16 );
+}
+
+void Histogram::SetBuckets( uint64_t width, ncounter_t count )
+{
+    bucketWidth = (width == 0) ? 1 : width;
+
+    /* The last bucket holds everything past the others. */
+    buckets.assign( (count < 2) ? 2 : count, 0 );
+}
+
+LogHistogram::LogHistogram( unsigned int bits )
+{
+    /* At least one sub-bucket per power of two, and no wider than a value. */
+    precision = (bits < 1) ? 1 : ((bits > 32) ? 32 : bits);
+    linearBuckets = 1ULL << precision;
+    subBuckets = linearBuckets >> 1;
+}
+
+uint64_t LogHistogram::GetBucketHigh( ncounter_t bucket ) const
+{
+    if( bucket < linearBuckets )
+        return bucket;
+
+    uint64_t shift = (bucket - linearBuckets) / subBuckets + 1;
+    uint64_t sub = (bucket - linearBuckets) % subBuckets + subBuckets;
+
+    /* The top bucket wraps around to the largest value. */
+    return ((sub + 1) << shift) - 1;
+}
+
+uint64_t LogHistogram::GetPercentile( ncounter_t num, ncounter_t den ) const
+{
+    if( samples == 0 || den == 0 )
+        return 0;
+
+    ncounter_t target = (samples * num + den - 1) / den;
+    ncounter_t seen = 0;
+
+    if( target == 0 )
+        target = 1;
+
+    for( ncounter_t i = 0; i < buckets.size( ); i++ )
+    {
+        seen += buckets[i];
+
+        if( seen >= target )
+        {
+            uint64_t value = GetBucketHigh( i );
+
+            if( value > maximum ) value = maximum;
+            if( value < minimum ) value = minimum;
+
+            return value;
+        }
+    }
+
+    return maximum;
+}
+
+void StatPrinter<Distribution>::Print( StatWriter& out, const std::string& name,
+                                       const Distribution& value, const std::string& units )
+{
+    out.Write( name + ".count", static_cast<uint64_t>(value.GetCount( )), "" );
+    out.Write( name + ".mean", value.GetMean( ), units );
+    out.Write( name + ".stddev", value.GetStdDev( ), units );
+    out.Write( name + ".min", value.GetMin( ), units );
+    out.Write( name + ".max", value.GetMax( ), units );
+}
+
+void StatPrinter<Histogram>::Print( StatWriter& out, const std::string& name,
+                                    const Histogram& value, const std::string& units )
+{
+    StatPrinter<Distribution>::Print( out, name, value, units );
+
+    for( ncounter_t i = 0; i < value.GetBucketCount( ); i++ )
+    {
+        std::stringstream bucketName;
+
+        bucketName << name << ".bucket_" << i * value.GetBucketWidth( ) << "_";
+        if( i == value.GetBucketCount( ) - 1 )
+            bucketName << "inf";
+        else
+            bucketName << (i + 1) * value.GetBucketWidth( ) - 1;
+
+        out.Write( bucketName.str( ), static_cast<uint64_t>(value.GetBucket( i )), "" );
+    }
+}
+
+void StatPrinter<LogHistogram>::Print( StatWriter& out, const std::string& name,
+                                       const LogHistogram& value, const std::string& units )
+{
+    StatPrinter<Distribution>::Print( out, name, value, units );
+
+    out.Write( name + ".p50", value.GetPercentile( 50 ), units );
+    out.Write( name + ".p90", value.GetPercentile( 90 ), units );
+    out.Write( name + ".p99", value.GetPercentile( 99 ), units );
+    out.Write( name + ".p999", value.GetPercentile( 999, 1000 ), units );
+}
+
+
 Stats::Stats( )
 {
     psInterval = 0;
+    format = STATS_TEXT;
+    csvHeader = false;
 }
 
 Stats::~Stats( )
@@ -49,70 +368,121 @@ Stats::~Stats( )
 
     for( it = statList.begin(); it != statList.end(); it++ )
     {
-        /* Free reset value memory. */
-        uint8_t *rval = static_cast<uint8_t *>((*it)->GetResetValue( ));
-        delete[] rval; 
         delete (*it);
     }
 }
 
-void Stats::addStat( StatType stat, StatType resetValue, std::string statType, size_t typeSize, std::string name, std::string units )
+StatHandle Stats::addStat( StatBase *stat )
 {
-    StatBase *sb = new StatBase( );
+    statList.push_back( stat );
 
-    sb->SetName( name );
-    sb->SetValue( stat );
-    sb->SetResetValue( resetValue );
-    sb->SetStatType( statType, typeSize );
-    sb->SetUnits( units );
+    /* Lookups by name return the first stat registered under that name. */
+    nameIndex.insert( std::make_pair( stat->GetName( ), stat ) );
+    valueIndex[stat->GetValue( )] = stat;
 
-    statList.push_back( sb );
+    return stat;
 }
 
 void Stats::removeStat( StatType stat )
 {
-    std::vector<StatBase *>::iterator it;
+    std::unordered_map<StatType, StatBase *>::iterator vit = valueIndex.find( stat );
+
+    if( vit == valueIndex.end( ) )
+        return;
+
+    StatBase *sb = vit->second;
+    valueIndex.erase( vit );
 
+    std::vector<StatBase *>::iterator it;
     for( it = statList.begin(); it != statList.end(); it++ )
     {
-        if( (*it)->GetValue( ) == stat )
+        if( (*it) == sb )
         {
-            /* Free reset value memory. */
-            uint8_t *rval = static_cast<uint8_t *>((*it)->GetResetValue( ));
-            delete[] rval; 
-
             statList.erase( it );
             break;
         }
     }
+
+    /* Let a later stat with the same name take over the name. */
+    std::unordered_map<std::string, StatBase *>::iterator nit = nameIndex.find( sb->GetName( ) );
+    if( nit != nameIndex.end( ) && nit->second == sb )
+    {
+        nameIndex.erase( nit );
+
+        for( it = statList.begin(); it != statList.end(); it++ )
+        {
+            if( (*it)->GetName( ) == sb->GetName( ) )
+            {
+                nameIndex.insert( std::make_pair( (*it)->GetName( ), (*it) ) );
+                break;
+            }
+        }
+    }
+
+    delete sb;
 }
 
 StatType Stats::getStat( std::string name )
 {
-    StatType rv = NULL;
-    std::vector<StatBase *>::iterator it;
+    StatHandle handle = getHandle( name );
 
-    for( it = statList.begin(); it != statList.end(); it++ )
+    return (handle != NULL) ? handle->GetValue( ) : NULL;
+}
+
+StatHandle Stats::getHandle( std::string name )
+{
+    std::unordered_map<std::string, StatBase *>::iterator it = nameIndex.find( name );
+
+    return (it != nameIndex.end( )) ? it->second : NULL;
+}
+
+bool Stats::SetFormat( std::string fmt )
+{
+    if( fmt == "text" || fmt == "Text" )
+        format = STATS_TEXT;
+    else if( fmt == "json" || fmt == "JSON" )
+        format = STATS_JSON;
+    else if( fmt == "csv" || fmt == "CSV" )
+        format = STATS_CSV;
+    else
+        return false;
+
+    return true;
+}
+
+void Stats::PrintAll( std::ostream& stream )
+{
+    TextStatWriter text( stream );
+    JsonStatWriter json( stream );
+    CsvStatWriter csv( stream );
+    StatWriter *writer = &text;
+
+    if( format == STATS_JSON )
+    {
+        writer = &json;
+    }
+    else if( format == STATS_CSV )
     {
-        if( (*it)->GetName( ) == name )
+        writer = &csv;
+
+        if( !csvHeader )
         {
-            rv = (*it)->GetValue( );
-            break;
+            stream << "interval,name,value,units\n";
+            csvHeader = true;
         }
     }
 
-    return rv;
-}
+    writer->BeginDump( psInterval );
 
-void Stats::PrintAll( std::ostream& stream )
-{
     std::vector<StatBase *>::iterator it;
 
     for( it = statList.begin(); it != statList.end(); it++ )
     {
-        (*it)->Print( stream, psInterval );
+        (*it)->Print( *writer );
     }
 
+    writer->EndDump( );
+
     psInterval++;
 }
 
@@ -125,28 +495,3 @@ void Stats::ResetAll( )
         (*it)->Reset( );
     }
 }
-
-
-void StatBase::Reset( )
-{
-    std::memcpy( value, resetValue, typeSize );
-}
-
-void StatBase::Print( std::ostream& stream, ncounter_t psInterval )
-{
-    stream << "i" << psInterval << "." << name << " ";
-
-    if( statType == typeid(int).name() ) stream << *(static_cast<int *>(value));
-    else if( statType == typeid(float).name() ) stream << *(static_cast<float *>(value));
-    else if( statType == typeid(double).name() ) stream << *(static_cast<double *>(value));
-    else if( statType == typeid(ncounter_t).name() ) stream << *(static_cast<ncounter_t *>(value));
-    else if( statType == typeid(ncounters_t).name() ) stream << *(static_cast<ncounters_t *>(value));
-    else if( statType == typeid(ncycle_t).name() ) stream << *(static_cast<ncycle_t *>(value));
-    else if( statType == typeid(ncycles_t).name() ) stream << *(static_cast<ncycles_t *>(value));
-    else if( statType == typeid(std::string).name() ) stream << *(static_cast<std::string *>(value));
-    else stream << "?????";
-
-    stream << units << std::endl;
-}
-
-
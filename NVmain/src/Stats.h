@@ -45,12 +45,7 @@
         }
 #define _AddStat(STAT, UNITS)                                                 \
         {                                                                     \
-            uint8_t *__resetValue = new uint8_t [sizeof(STAT)];               \
-            memcpy(__resetValue, static_cast<StatType>(&STAT), sizeof(STAT)); \
-            this->GetStats()->addStat(static_cast<StatType>(&(STAT)),         \
-                                      static_cast<StatType>(__resetValue),    \
-                                      typeid(STAT).name(),                    \
-                                      sizeof(STAT),                           \
+            this->GetStats()->addStat(&(STAT),                                \
                                       StatName() + "." + #STAT,               \
                                       UNITS);                                 \
         }
@@ -59,13 +54,18 @@
 // CHLD = NVMObject_hook, STAT = std::string; returns StatType
 #define GetStat(CHLD, STAT) (CHLD->GetStats( )->getStat( CHLD->StatName( ) + "." + STAT ) )
 
+// CHLD = NVMObject_hook, STAT = std::string; returns StatHandle
+#define GetStatHandle(CHLD, STAT) (CHLD->GetStats( )->getHandle( CHLD->StatName( ) + "." + STAT ) )
+
 // STAT = StatType, TYPE = any type; returns TYPE
 #define CastStat(STAT, TYPE) (*(static_cast< TYPE * >( STAT )))
 
 
 
 #include <ostream>
+#include <string>
 #include <typeinfo>
+#include <unordered_map>
 #include <vector>
 #include <cstring>
 
@@ -76,55 +76,259 @@ namespace NVM {
 
 typedef void * StatType;
 
+/*
+ *  Running count, mean, standard deviation and range of a sampled value such
+ *  as a queue depth or a latency.
+ */
+class Distribution
+{
+  public:
+    Distribution( );
 
-class StatBase
+    void Sample( uint64_t value, ncounter_t count = 1 )
+    {
+        if( samples == 0 || value < minimum ) minimum = value;
+        if( samples == 0 || value > maximum ) maximum = value;
+
+        samples += count;
+        sum += static_cast<double>(value) * static_cast<double>(count);
+        sumSquares += static_cast<double>(value) * static_cast<double>(value)
+                    * static_cast<double>(count);
+    }
+
+    ncounter_t GetCount( ) const { return samples; }
+    uint64_t GetMin( ) const { return minimum; }
+    uint64_t GetMax( ) const { return maximum; }
+    double GetMean( ) const;
+    double GetStdDev( ) const;
+
+  protected:
+    ncounter_t samples;
+    uint64_t minimum, maximum;
+    double sum, sumSquares;
+};
+
+/*
+ *  A distribution that also counts samples in equal-width buckets. Samples
+ *  past the last bucket are counted in an overflow bucket. The geometry must
+ *  be set before the stat is registered since registration saves the value
+ *  that ResetAll() restores.
+ */
+class Histogram : public Distribution
 {
   public:
-    StatBase( ) { }
-    ~StatBase( ) { }
+    Histogram( );
 
-    void Reset( );
-    void Print( std::ostream& stream, ncounter_t psInterval );
+    void SetBuckets( uint64_t width, ncounter_t count );
 
-    std::string GetName( ) { return name; }
-    void SetName( std::string n ) { name = n; }
+    void Sample( uint64_t value, ncounter_t count = 1 )
+    {
+        Distribution::Sample( value, count );
 
-    void* GetValue( ) { return value; }
-    void SetValue( StatType val ) { value = val; }
+        uint64_t bucket = value / bucketWidth;
+        if( bucket >= buckets.size( ) - 1 )
+            bucket = buckets.size( ) - 1;
+
+        buckets[bucket] += count;
+    }
+
+    uint64_t GetBucketWidth( ) const { return bucketWidth; }
+    ncounter_t GetBucketCount( ) const { return buckets.size( ); }
+    ncounter_t GetBucket( ncounter_t bucket ) const { return buckets[bucket]; }
+
+  private:
+    uint64_t bucketWidth;
+    std::vector<ncounter_t> buckets;
+};
+
+/*
+ *  A distribution counted in log-linear buckets, in the style of an HDR
+ *  histogram, for values such as latencies that span several orders of
+ *  magnitude. Values below 2^precision get a bucket each; every power of two
+ *  above that is split into 2^(precision-1) buckets, so percentiles are
+ *  within 1/2^(precision-1) of the sampled value. Buckets are only allocated
+ *  once a value that large is seen.
+ */
+class LogHistogram : public Distribution
+{
+  public:
+    LogHistogram( unsigned int precision = 6 );
 
-    std::string GetUnits( ) { return units; }
-    void SetUnits( std::string u ) { units = u; }
+    void Sample( uint64_t value, ncounter_t count = 1 )
+    {
+        Distribution::Sample( value, count );
 
-    void SetResetValue( StatType rval ) { resetValue = rval; }
-    void *GetResetValue( ) { return resetValue; }
+        ncounter_t bucket = GetBucketIndex( value );
+        if( bucket >= buckets.size( ) )
+            buckets.resize( bucket + 1, 0 );
 
-    void SetStatType( std::string st, size_t ts ) { statType = st; typeSize = ts; }
-    size_t GetTypeSize( ) { return typeSize; }
-    std::string GetTypeName() { return statType; }
+        buckets[bucket] += count;
+    }
+
+    ncounter_t GetBucketIndex( uint64_t value ) const
+    {
+        if( value < linearBuckets )
+            return value;
+
+        unsigned int shift = 64 - __builtin_clzll( value ) - precision;
+        return linearBuckets + (shift - 1) * subBuckets
+               + ((value >> shift) - subBuckets);
+    }
+
+    uint64_t GetBucketHigh( ncounter_t bucket ) const;
+
+    /* Value that num/den of the samples are at or below, up to bucket precision. */
+    uint64_t GetPercentile( ncounter_t num, ncounter_t den = 100 ) const;
 
   private:
-    std::string name, statType, units;
-    size_t typeSize;
-    StatType resetValue;
-    StatType value;
+    unsigned int precision;
+    uint64_t linearBuckets, subBuckets;
+    std::vector<ncounter_t> buckets;
+};
+
+/*
+ *  Output format for stat dumps. Each stat hands its value(s) to a writer
+ *  with the overload for its type, so nothing is looked up by type name.
+ */
+class StatWriter
+{
+  public:
+    virtual ~StatWriter( ) { }
+
+    virtual void BeginDump( ncounter_t /*interval*/ ) { }
+    virtual void Write( const std::string& name, int64_t value, const std::string& units ) = 0;
+    virtual void Write( const std::string& name, uint64_t value, const std::string& units ) = 0;
+    virtual void Write( const std::string& name, double value, const std::string& units ) = 0;
+    virtual void Write( const std::string& name, const std::string& value, const std::string& units ) = 0;
+    virtual void WriteUnknown( const std::string& name, const std::string& units ) = 0;
+    virtual void EndDump( ) { }
+};
+
+enum StatsFormat { STATS_TEXT, STATS_JSON, STATS_CSV };
+
+/*
+ *  Printers are specialized for each supported stat type. Anything else is
+ *  printed as unknown.
+ */
+template<typename T>
+struct StatPrinter
+{
+    static void Print( StatWriter& out, const std::string& name, const T& /*value*/,
+                       const std::string& units )
+    {
+        out.WriteUnknown( name, units );
+    }
+};
+
+#define SCALAR_STAT_PRINTER(TYPE, AS)                                          \
+template<>                                                                    \
+struct StatPrinter<TYPE>                                                      \
+{                                                                             \
+    static void Print( StatWriter& out, const std::string& name,             \
+                       const TYPE& value, const std::string& units )          \
+    {                                                                         \
+        out.Write( name, static_cast<AS>(value), units );                    \
+    }                                                                         \
 };
 
+SCALAR_STAT_PRINTER(int, int64_t)
+SCALAR_STAT_PRINTER(int64_t, int64_t)
+SCALAR_STAT_PRINTER(uint64_t, uint64_t)
+SCALAR_STAT_PRINTER(float, double)
+SCALAR_STAT_PRINTER(double, double)
+SCALAR_STAT_PRINTER(std::string, std::string)
+
+#undef SCALAR_STAT_PRINTER
+
+template<>
+struct StatPrinter<Distribution>
+{
+    static void Print( StatWriter& out, const std::string& name,
+                       const Distribution& value, const std::string& units );
+};
+
+template<>
+struct StatPrinter<Histogram>
+{
+    static void Print( StatWriter& out, const std::string& name,
+                       const Histogram& value, const std::string& units );
+};
+
+template<>
+struct StatPrinter<LogHistogram>
+{
+    static void Print( StatWriter& out, const std::string& name,
+                       const LogHistogram& value, const std::string& units );
+};
+
+class StatBase
+{
+  public:
+    StatBase( std::string n, std::string u ) : name(n), units(u) { }
+    virtual ~StatBase( ) { }
+
+    virtual void Reset( ) = 0;
+    virtual void Print( StatWriter& out ) = 0;
+    virtual StatType GetValue( ) = 0;
+
+    const std::string& GetName( ) { return name; }
+    const std::string& GetUnits( ) { return units; }
+
+  private:
+    std::string name, units;
+};
+
+template<typename T>
+class TypedStat : public StatBase
+{
+  public:
+    TypedStat( T *stat, std::string n, std::string u )
+        : StatBase( n, u ), value(stat), resetValue(*stat) { }
+
+    void Reset( ) { *value = resetValue; }
+    void Print( StatWriter& out ) { StatPrinter<T>::Print( out, GetName( ), *value, GetUnits( ) ); }
+    StatType GetValue( ) { return static_cast<StatType>(value); }
+
+  private:
+    T *value;
+    T resetValue;
+};
+
+/* Registered stats can be looked up once by name and then used directly. */
+typedef StatBase * StatHandle;
+
 class Stats
 {
   public:
     Stats( );
     ~Stats( );
 
-    void addStat( StatType stat, StatType resetValue, std::string statType, size_t typeSize, std::string name, std::string units );
+    template<typename T>
+    StatHandle addStat( T *stat, std::string name, std::string units )
+    {
+        return addStat( new TypedStat<T>( stat, name, units ) );
+    }
+
     void removeStat( StatType stat );
     StatType getStat( std::string name );
+    StatHandle getHandle( std::string name );
+
+    void SetFormat( StatsFormat fmt ) { format = fmt; }
+    bool SetFormat( std::string fmt );
+    StatsFormat GetFormat( ) { return format; }
 
     void PrintAll( std::ostream& );
     void ResetAll( );
 
   private: 
+    StatHandle addStat( StatBase *stat );
+
     std::vector<StatBase *> statList;
+    std::unordered_map<std::string, StatBase *> nameIndex;
+    std::unordered_map<StatType, StatBase *> valueIndex;
     ncounter_t psInterval;
+    StatsFormat format;
+    bool csvHeader;
 };
 
 
@@ -132,5 +336,3 @@ class Stats
 
 
 #endif
-
-
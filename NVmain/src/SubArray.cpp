@@ -40,22 +40,13 @@
 #include "Endurance/NullModel/NullModel.h"
 #include "Endurance/Distributions/Normal.h"
 #include "DataEncoders/DataEncoderFactory.h"
+#include "include/NVMBitOps.h"
 
 #include <signal.h>
 #include <cassert>
 #include <iostream>
 #include <limits>
 
-/*
- * Using -O3 in gcc causes the popcount methods to return incorrect values.
- * Disable optimizations in these methods using compiler specific attributes.
- */
-#if defined(__clang__)
-#define NO_OPT __attribute__((optnone))
-#else
-#define NO_OPT __attribute__((optimize("0")))
-#endif
-
 using namespace NVM;
 
 SubArray::SubArray( )
@@ -118,6 +109,11 @@ SubArray::SubArray( )
     precharges = 0;
     refreshes = 0;
 
+    worstCaseEndurance = 0;
+    averageEndurance = 0;
+    enduranceMemoryUsage = 0;
+    enduranceHisto = "";
+
     actWaits = 0;
     actWaitTotal = 0;
     actWaitAverage = 0.0;
@@ -159,25 +155,7 @@ void SubArray::SetConfig( Config *c, bool createChildren )
     if( conf->KeyExists( "MATWidth" ) )
         MATWidth = static_cast<ncounter_t>( conf->GetValue( "MATWidth" ) );
 
-    /* Configure the write mode. */
-    if( conf->KeyExists( "WriteMode" ) )
-    {
-        if( conf->GetString( "WriteMode" ) == "WriteThrough" )
-        {
-            writeMode = WRITE_THROUGH;
-        }
-        else if( conf->GetString( "WriteMode" ) == "WriteBack" )
-        {
-            writeMode = WRITE_BACK;
-        }
-        else
-        {
-            std::cout << "NVMain Warning: Unknown write mode `"
-                      << conf->GetString( "WriteMode" )
-                      << "'. Defaulting to WriteThrough" << std::endl;
-            writeMode = WRITE_THROUGH;
-        }
-    }
+    writeMode = p->writeMode;
 
     ncounter_t totalWritePulses = p->nWP00 + p->nWP01 + p->nWP10 + p->nWP11;
     averageWriteIterations = static_cast<ncounter_t>( (totalWritePulses+2)/4 );
@@ -213,7 +191,7 @@ void SubArray::RegisterStats( )
         dataEncoder->RegisterStats( );
     }
 
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         AddUnitStat(subArrayEnergy, "mA*t");
         AddUnitStat(activeEnergy, "mA*t");
@@ -249,6 +227,8 @@ void SubArray::RegisterStats( )
     {
         AddStat(worstCaseEndurance);
         AddStat(averageEndurance);
+        AddStat(enduranceHisto);
+        AddUnitStat(enduranceMemoryUsage, "B");
     }
 
     AddStat(actWaits);
@@ -313,8 +293,7 @@ bool SubArray::Activate( NVMainRequest *request )
                          GetEventQueue()->GetCurrentCycle() 
                              + MAX( p->tRCD, p->tRAS ) );
 
-    /* the request is deleted by RequestComplete() */
-    request->owner = this;
+    /* the request is handed back to its owner by RequestComplete() */
     GetEventQueue( )->InsertEvent( EventResponse, this, request, 
                     GetEventQueue()->GetCurrentCycle() + p->tRCD );
 
@@ -330,7 +309,7 @@ bool SubArray::Activate( NVMainRequest *request )
     lastActivate = GetEventQueue()->GetCurrentCycle();
 
     /* Add to bank's total energy. */
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         /* DRAM Model */
         ncycle_t tRC = p->tRAS + p->tRP;
@@ -456,7 +435,7 @@ bool SubArray::Read( NVMainRequest *request )
 
 
     /* Calculate energy */
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         /* DRAM Model */
         subArrayEnergy += ( ( p->EIDD4R - p->EIDD3N ) * (double)(p->tBURST) ) / (double)(p->BANKS);
@@ -541,17 +520,17 @@ bool SubArray::Write( NVMainRequest *request )
         /* Count the number of bits modified. */
         if( !p->WriteAllBits )
         {
-            uint8_t *bitCountData = new uint8_t[request->data.GetSize()];
+            /* Only whole 32-bit words are compared. */
+            uint64_t bitCountBytes = (request->data.GetSize() / 4) * 4;
 
-            for( uint64_t bitCountByte = 0; bitCountByte < request->data.GetSize(); bitCountByte++ )
-            {
-                bitCountData[bitCountByte] = request->data.GetByte( bitCountByte )
-                                           ^ request->oldData.GetByte( bitCountByte );
-            }
+            bitCountScratch.resize( 2 * bitCountBytes );
 
-            ncounter_t bitCountWords = request->data.GetSize()/4;
+            const uint8_t *newBytes = request->data.GetBytes( bitCountBytes, 
+                                          bitCountScratch.data( ) );
+            const uint8_t *oldBytes = request->oldData.GetBytes( bitCountBytes,
+                                          bitCountScratch.data( ) + bitCountBytes );
 
-            ncounter_t numChangedBits = CountBitsMLC1( 1, (uint32_t*)bitCountData, bitCountWords );
+            ncounter_t numChangedBits = CountDiffBits( newBytes, oldBytes, bitCountBytes );
 
             assert( request->data.GetSize()*8 >= numChangedBits );
             numUnchangedBits = request->data.GetSize()*8 - numChangedBits;
@@ -652,19 +631,7 @@ bool SubArray::Write( NVMainRequest *request )
     writeEventTime = GetEventQueue()->GetCurrentCycle() + p->tCWD 
                      + MAX( p->tBURST, p->tCCD ) * request->burstCount + writeTimer;
 
-    /* The parent has our hook in the children list, we need to find this. */
-    std::vector<NVMObject_hook *>& children = GetParent( )->GetTrampoline( )->GetChildren( );
-    std::vector<NVMObject_hook *>::iterator it;
-    NVMObject_hook *hook = NULL;
-
-    for( it = children.begin(); it != children.end(); it++ )
-    {
-        if( (*it)->GetTrampoline() == this )
-        {
-            hook = (*it);
-            break;
-        }
-    }
+    NVMObject_hook *hook = GetSelfHook( );
 
     assert( hook != NULL );
 
@@ -686,7 +653,7 @@ bool SubArray::Write( NVMainRequest *request )
     GetEventQueue( )->InsertEvent( writeEvent, writeEventTime );
 
     /* Calculate energy. */
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         /* DRAM Model. */
         subArrayEnergy += ( ( p->EIDD4W - p->EIDD3N ) * (double)(p->tBURST) ) / (double)(p->BANKS);
@@ -758,8 +725,7 @@ bool SubArray::Precharge( NVMainRequest *request )
     nextActivate = MAX( nextActivate, 
                         GetEventQueue()->GetCurrentCycle() + writeTimer );
 
-    /* the request is deleted by RequestComplete() */
-    request->owner = this;
+    /* the request is handed back to its owner by RequestComplete() */
     GetEventQueue( )->InsertEvent( EventResponse, this, request, 
               GetEventQueue()->GetCurrentCycle() + writeTimer );
 
@@ -805,7 +771,7 @@ bool SubArray::Refresh( NVMainRequest* request )
     /* set the subarray under refreshing */
     state = SUBARRAY_REFRESHING;
 
-    if( p->EnergyModel == "current" )
+    if( p->energyModel == EnergyModel_Current )
     {
         /* calibrate the refresh energy since we may have fine-grained refresh */
         subArrayEnergy += ( ( p->EIDD5B - p->EIDD3N ) 
@@ -929,9 +895,9 @@ bool SubArray::BetweenWriteIterations( )
 ncycle_t SubArray::WriteCellData( NVMainRequest *request )
 {
     writeIterationStarts.clear( );
-    uint32_t *rawData = reinterpret_cast<uint32_t*>(request->data.rawData);
+    const uint8_t *rawData = request->data.rawData;
     unsigned int memoryWordSize = static_cast<unsigned int>(p->tBURST * p->RATE * p->BusWidth);
-    unsigned int writeBytes32 = memoryWordSize / 32;
+    uint64_t writeBytes = (memoryWordSize / 32) * 4;
 
     if( p->UniformWrites )
     {
@@ -951,8 +917,8 @@ ncycle_t SubArray::WriteCellData( NVMainRequest *request )
 
         if( rawData )
         {
-            writeCount0 = CountBitsMLC1( 0, rawData, writeBytes32 );
-            writeCount1 = CountBitsMLC1( 1, rawData, writeBytes32 );
+            writeCount1 = CountOnes( rawData, writeBytes );
+            writeCount0 = writeBytes * 8 - writeCount1;
         }
         else
         {
@@ -961,7 +927,7 @@ ncycle_t SubArray::WriteCellData( NVMainRequest *request )
             writeCount1 = 256;
         }
 
-        if( p->EnergyModel != "current" )
+        if( p->energyModel != EnergyModel_Current )
         {
             subArrayEnergy += p->Ereset * writeCount0;
             subArrayEnergy += p->Eset * writeCount1;
@@ -981,10 +947,10 @@ ncycle_t SubArray::WriteCellData( NVMainRequest *request )
     /* Check the data for the worst-case write time. */
     if( p->MLCLevels == 1 )
     {
-        ncounter_t writeCount0 = CountBitsMLC1( 0, rawData, writeBytes32 );
-        ncounter_t writeCount1 = CountBitsMLC1( 1, rawData, writeBytes32 );
+        ncounter_t writeCount1 = CountOnes( rawData, writeBytes );
+        ncounter_t writeCount0 = writeBytes * 8 - writeCount1;
 
-        if( p->EnergyModel != "current" )
+        if( p->energyModel != EnergyModel_Current )
         {
             subArrayEnergy += p->Ereset * writeCount0;
             subArrayEnergy += p->Eset * writeCount1;
@@ -999,10 +965,14 @@ ncycle_t SubArray::WriteCellData( NVMainRequest *request )
     }
     else if( p->MLCLevels == 2 )
     {
-        ncounter_t writeCount00 = CountBitsMLC2( 0, rawData, writeBytes32 );
-        ncounter_t writeCount01 = CountBitsMLC2( 1, rawData, writeBytes32 );
-        ncounter_t writeCount10 = CountBitsMLC2( 2, rawData, writeBytes32 );
-        ncounter_t writeCount11 = CountBitsMLC2( 3, rawData, writeBytes32 );
+        uint64_t cellCounts[4];
+
+        CountCellStates( rawData, writeBytes, cellCounts );
+
+        ncounter_t writeCount00 = cellCounts[0];
+        ncounter_t writeCount01 = cellCounts[1];
+        ncounter_t writeCount10 = cellCounts[2];
+        ncounter_t writeCount11 = cellCounts[3];
 
         assert( (writeCount00 + writeCount01 + writeCount10 + writeCount11)
                 == (memoryWordSize/2) );
@@ -1295,12 +1265,27 @@ bool SubArray::RequestComplete( NVMainRequest *req )
         }
     }
 
-    if( req->owner == this )
+    /*
+     *  Activates and precharges stay with whoever issued them (normally the
+     *  memory controller, which recycles its commands). Once the subarray
+     *  state is updated they are handed back instead of being deleted here.
+     */
+    bool returnToOwner = ( req->owner != this 
+                           && ( req->type == ACTIVATE || req->type == PRECHARGE
+                                || req->type == PRECHARGE_ALL ) );
+
+    if( req->owner == this || returnToOwner )
     {
         switch( req->type )
         {
             /* may implement more functions in the future */
             case ACTIVATE:
+                if( returnToOwner )
+                    return req->owner->RequestComplete( req );
+
+                delete req;
+                break;
+
             case READ:
             case WRITE:
                 delete req;
@@ -1322,6 +1307,10 @@ bool SubArray::RequestComplete( NVMainRequest *req )
                 state = SUBARRAY_CLOSED;
                 openRow = p->ROWS;
                 precharges++;
+
+                if( returnToOwner )
+                    return req->owner->RequestComplete( req );
+
                 delete req;
                 break;
 
@@ -1398,6 +1387,7 @@ ncycle_t SubArray::UpdateEndurance( NVMainRequest *request )
                      !conf->GetSimInterface( )-> GetDataAtAddress( 
                         request->address.GetPhysicalAddress( ), &oldData ) )
             {
+                oldData.SetSize( wordSize );
                 for( uint64_t i = 0; i < wordSize; i++ )
                   oldData.SetByte( i, 0 );
             }
@@ -1470,6 +1460,11 @@ void SubArray::CalculateStats( )
 {
     worstCaseEndurance = endrModel->GetWorstLife( );
     averageEndurance = endrModel->GetAverageLife( );
+    enduranceMemoryUsage = endrModel->GetLifeMemoryUsage( );
+
+    std::map<uint64_t, uint64_t> enduranceMap;
+    endrModel->GetLifeHistogram( enduranceMap );
+    enduranceHisto = PyDictHistogram<uint64_t, uint64_t>( enduranceMap );
 
     actWaitAverage = static_cast<double>(actWaitTotal) / static_cast<double>(actWaits);
 
@@ -1488,76 +1483,3 @@ bool SubArray::Idle( )
 void SubArray::Cycle( ncycle_t )
 {
 }
-
-/*
- *  Count the appearances for "value" for 2-bit MLC where value
- *  can be 0 (binary 00), 1 (binary 01), 2 (binary 10) or 3
- *  (binary 11).
- */
-ncounter_t NO_OPT SubArray::Count32MLC2( uint8_t value, uint32_t data )
-{
-    /*
-     *  This method counts the number of 11 pairs, so we need to convert
-     *  the bit pattern we are looking for to be 11.
-     */
-    if( value == 0 )
-        data ^= 0xFFFFFFFF;
-    else if( value == 1 )
-        data ^= 0xAAAAAAAA;
-    else if( value == 2 )
-        data ^= 0x55555555;
-
-    assert( value < 4 );
-
-    /* 
-     *  Count number of "11" pairs by ANDing together every-event bit
-     *  with every odd bit. The resulting ANDed value will be 1 if both
-     *  even and odd bit are 1 (i.e. "11") and 0 otherwise.
-     */
-    uint32_t count = (data & 0x55555555) & ((data & 0xAAAAAAAA) >> 1);
-
-    return Count32MLC1(count);
-}
-
-
-ncounter_t NO_OPT SubArray::CountBitsMLC2( uint8_t value, uint32_t *data, ncounter_t words )
-{
-    ncounter_t count = 0;
-
-    for( ncounter_t i = 0; i < words; i++ )
-    {
-        count += Count32MLC2( value, data[i] );
-    }
-
-    return count;
-}
-
-
-ncounter_t NO_OPT SubArray::Count32MLC1( uint32_t data )
-{
-    /*
-     *  Count the number of ones in this value using some
-     *  bit-manipulation magic.
-     */
-    uint32_t count = data;
-    count = count - ((count >> 1) & 0x55555555);
-    count = (count & 0x33333333) + ((count >> 2) & 0x33333333);
-    count = (((count + (count >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
-
-    return static_cast<ncounter_t>(count);
-}
-
-
-ncounter_t NO_OPT SubArray::CountBitsMLC1( uint8_t value, uint32_t *data, ncounter_t words )
-{
-    ncounter_t count = 0;
-
-    for( ncounter_t i = 0; i < words; i++ )
-    {
-        count += Count32MLC1( data[i] );
-    }
-
-    count = (value == 1) ? count : (words*32 - count);
-
-    return count;
-}
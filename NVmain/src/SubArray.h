@@ -36,6 +36,7 @@
 
 #include <stdint.h>
 #include <map>
+#include <vector>
 
 #include "src/NVMObject.h"
 #include "src/Config.h"
@@ -70,13 +71,6 @@ enum SubArrayState
     SUBARRAY_REFRESHING   /* SubArray is refreshing and return to SUBARRAY_CLOSED */
 };
 
-enum WriteMode 
-{
-    WRITE_BACK, /* only modify the row buffer */
-    WRITE_THROUGH, /* modify both row buffer and cell */
-    DELAYED_WRITE /* data is stored in a write buffer */
-};
-
 class SubArray : public NVMObject
 {
   public:
@@ -183,6 +177,8 @@ class SubArray : public NVMObject
     double refreshEnergy;
 
     uint64_t worstCaseEndurance, averageEndurance;
+    uint64_t enduranceMemoryUsage;
+    std::string enduranceHisto;
 
     ncounter_t reads, writes, activates, precharges, refreshes;
     ncounter_t idleTimer;
@@ -208,10 +204,7 @@ class SubArray : public NVMObject
 
     ncycle_t UpdateEndurance( NVMainRequest *request );
 
-    ncounter_t Count32MLC2( uint8_t value, uint32_t data );
-    ncounter_t CountBitsMLC2( uint8_t value, uint32_t *data, ncounter_t words );
-    ncounter_t Count32MLC1( uint32_t data );
-    ncounter_t CountBitsMLC1( uint8_t value, uint32_t *data, ncounter_t words );
+    std::vector<uint8_t> bitCountScratch;
 };
 
 };
@@ -0,0 +1,307 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#include "src/TransactionIndex.h"
+#include "include/NVMainRequest.h"
+
+#include <cassert>
+
+using namespace NVM;
+
+TransactionIndex::TransactionIndex( )
+{
+    rankCount = bankCount = subArrayCount = 0;
+
+    head = tail = NULL;
+    size = 0;
+
+    frontOrder = 0;
+    backOrder = 1;
+}
+
+TransactionIndex::~TransactionIndex( )
+{
+    Entry *entry = head;
+
+    while( entry != NULL )
+    {
+        Entry *next = entry->next;
+        delete entry;
+        entry = next;
+    }
+
+    for( size_t i = 0; i < freeEntries.size( ); i++ )
+        delete freeEntries[i];
+}
+
+void TransactionIndex::SetDimensions( ncounter_t ranks, ncounter_t banks, 
+                                      ncounter_t subarrays )
+{
+    assert( head == NULL );
+
+    rankCount = ranks;
+    bankCount = banks;
+    subArrayCount = subarrays;
+
+    slots.resize( ranks * banks * subarrays );
+
+    for( size_t i = 0; i < slots.size( ); i++ )
+    {
+        slots[i].head = slots[i].tail = NULL;
+        slots[i].occupiedPos = 0;
+        slots[i].rows.clear( );
+    }
+
+    occupied.clear( );
+}
+
+TransactionIndex::Entry *TransactionIndex::CreateEntry( NVMainRequest *request, 
+                                  NVMTransactionQueue::iterator position,
+                                  ncounter_t queueId )
+{
+    Entry *entry;
+
+    if( freeEntries.empty( ) )
+    {
+        entry = new Entry;
+    }
+    else
+    {
+        entry = freeEntries.back( );
+        freeEntries.pop_back( );
+    }
+
+    entry->request = request;
+    entry->position = position;
+    entry->queueId = queueId;
+
+    request->address.GetTranslatedAddress( &entry->row, &entry->col, &entry->bank, 
+                                           &entry->rank, NULL, &entry->subarray );
+
+    assert( entry->rank < rankCount && entry->bank < bankCount 
+            && entry->subarray < subArrayCount );
+
+    entry->slot = (entry->rank * bankCount + entry->bank) * subArrayCount 
+                + entry->subarray;
+
+    entry->prev = entry->next = NULL;
+    entry->slotPrev = entry->slotNext = NULL;
+    entry->rowPrev = entry->rowNext = NULL;
+
+    Slot& slot = slots[entry->slot];
+
+    if( slot.head == NULL )
+    {
+        slot.occupiedPos = occupied.size( );
+        occupied.push_back( entry->slot );
+    }
+
+    size++;
+
+    return entry;
+}
+
+TransactionIndex::Slot& TransactionIndex::GetSlot( Entry *entry )
+{
+    return slots[entry->slot];
+}
+
+TransactionIndex::Entry *TransactionIndex::PushBack( NVMainRequest *request, 
+                                  NVMTransactionQueue::iterator position,
+                                  ncounter_t queueId )
+{
+    Entry *entry = CreateEntry( request, position, queueId );
+    Slot& slot = GetSlot( entry );
+
+    std::map<ncounter_t, RowList>::iterator rowIt = slot.rows.find( entry->row );
+
+    if( rowIt == slot.rows.end( ) )
+    {
+        RowList rowList;
+
+        rowList.head = rowList.tail = entry;
+        slot.rows.insert( std::make_pair( entry->row, rowList ) );
+    }
+    else
+    {
+        entry->rowPrev = rowIt->second.tail;
+        rowIt->second.tail->rowNext = entry;
+        rowIt->second.tail = entry;
+    }
+
+    entry->slotPrev = slot.tail;
+    if( slot.tail != NULL )
+        slot.tail->slotNext = entry;
+    else
+        slot.head = entry;
+    slot.tail = entry;
+
+    entry->prev = tail;
+    if( tail != NULL )
+        tail->next = entry;
+    else
+        head = entry;
+    tail = entry;
+
+    entry->order = backOrder++;
+
+    return entry;
+}
+
+TransactionIndex::Entry *TransactionIndex::PushFront( NVMainRequest *request, 
+                                  NVMTransactionQueue::iterator position,
+                                  ncounter_t queueId )
+{
+    Entry *entry = CreateEntry( request, position, queueId );
+    Slot& slot = GetSlot( entry );
+
+    std::map<ncounter_t, RowList>::iterator rowIt = slot.rows.find( entry->row );
+
+    if( rowIt == slot.rows.end( ) )
+    {
+        RowList rowList;
+
+        rowList.head = rowList.tail = entry;
+        slot.rows.insert( std::make_pair( entry->row, rowList ) );
+    }
+    else
+    {
+        entry->rowNext = rowIt->second.head;
+        rowIt->second.head->rowPrev = entry;
+        rowIt->second.head = entry;
+    }
+
+    entry->slotNext = slot.head;
+    if( slot.head != NULL )
+        slot.head->slotPrev = entry;
+    else
+        slot.tail = entry;
+    slot.head = entry;
+
+    entry->next = head;
+    if( head != NULL )
+        head->prev = entry;
+    else
+        tail = entry;
+    head = entry;
+
+    entry->order = frontOrder--;
+
+    return entry;
+}
+
+void TransactionIndex::Remove( Entry *entry )
+{
+    Slot& slot = GetSlot( entry );
+
+    /* Row group. */
+    if( entry->rowPrev == NULL && entry->rowNext == NULL )
+    {
+        slot.rows.erase( entry->row );
+    }
+    else
+    {
+        RowList& rowList = slot.rows[entry->row];
+
+        if( entry->rowPrev != NULL )
+            entry->rowPrev->rowNext = entry->rowNext;
+        else
+            rowList.head = entry->rowNext;
+
+        if( entry->rowNext != NULL )
+            entry->rowNext->rowPrev = entry->rowPrev;
+        else
+            rowList.tail = entry->rowPrev;
+    }
+
+    /* Slot. */
+    if( entry->slotPrev != NULL )
+        entry->slotPrev->slotNext = entry->slotNext;
+    else
+        slot.head = entry->slotNext;
+
+    if( entry->slotNext != NULL )
+        entry->slotNext->slotPrev = entry->slotPrev;
+    else
+        slot.tail = entry->slotPrev;
+
+    if( slot.head == NULL )
+    {
+        /* Swap the last occupied slot into this one's position. */
+        ncounter_t last = occupied.back( );
+
+        occupied[slot.occupiedPos] = last;
+        slots[last].occupiedPos = slot.occupiedPos;
+        occupied.pop_back( );
+    }
+
+    /* Whole queue. */
+    if( entry->prev != NULL )
+        entry->prev->next = entry->next;
+    else
+        head = entry->next;
+
+    if( entry->next != NULL )
+        entry->next->prev = entry->prev;
+    else
+        tail = entry->prev;
+
+    size--;
+
+    /* Keep the order keys small when the queue drains. */
+    if( head == NULL )
+    {
+        frontOrder = 0;
+        backOrder = 1;
+    }
+
+    freeEntries.push_back( entry );
+}
+
+TransactionIndex::Entry *TransactionIndex::GetRowHead( ncounter_t rank, ncounter_t bank, 
+                                  ncounter_t subarray, ncounter_t row ) const
+{
+    const Slot& slot = slots[(rank * bankCount + bank) * subArrayCount + subarray];
+    std::map<ncounter_t, RowList>::const_iterator rowIt = slot.rows.find( row );
+
+    return (rowIt == slot.rows.end( )) ? NULL : rowIt->second.head;
+}
+
+TransactionIndex::Entry *TransactionIndex::GetRowHead( Entry *slotEntry, 
+                                                       ncounter_t row ) const
+{
+    const Slot& slot = slots[slotEntry->slot];
+    std::map<ncounter_t, RowList>::const_iterator rowIt = slot.rows.find( row );
+
+    return (rowIt == slot.rows.end( )) ? NULL : rowIt->second.head;
+}
@@ -0,0 +1,129 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#ifndef __NVMAIN_TRANSACTIONINDEX_H__
+#define __NVMAIN_TRANSACTIONINDEX_H__
+
+#include <map>
+#include <vector>
+#include "include/NVMTypes.h"
+
+namespace NVM {
+
+class NVMainRequest;
+
+/*
+ *  Index over a memory controller transaction queue. Each queued request is
+ *  tracked in three intrusive lists that all keep the queue's order: the
+ *  whole queue, its (rank, bank, subarray) slot and its (rank, bank, 
+ *  subarray, row) group. The schedulers only need to visit the occupied
+ *  slots and look up the open row of each one instead of walking the whole
+ *  queue, and the oldest candidate of all slots is the same request the
+ *  linear scan would have found first.
+ *
+ *  The translated address and command queue of a request are recorded when
+ *  it is inserted, so they must not change while the request is queued.
+ */
+class TransactionIndex
+{
+  public:
+    struct Entry
+    {
+        NVMainRequest *request;
+        NVMTransactionQueue::iterator position;
+        ncounters_t order;
+
+        ncounter_t rank, bank, subarray, row, col;
+        ncounter_t queueId;
+        ncounter_t slot;
+
+        Entry *prev, *next;
+        Entry *slotPrev, *slotNext;
+        Entry *rowPrev, *rowNext;
+    };
+
+    TransactionIndex( );
+    ~TransactionIndex( );
+
+    void SetDimensions( ncounter_t ranks, ncounter_t banks, ncounter_t subarrays );
+
+    Entry *PushBack( NVMainRequest *request, NVMTransactionQueue::iterator position,
+                     ncounter_t queueId );
+    Entry *PushFront( NVMainRequest *request, NVMTransactionQueue::iterator position,
+                      ncounter_t queueId );
+    void Remove( Entry *entry );
+
+    /* Oldest entry of the whole queue. */
+    Entry *GetFirst( ) const { return head; }
+    ncounter_t GetSize( ) const { return size; }
+
+    /* Slots holding at least one request, in no particular order. */
+    ncounter_t GetOccupiedCount( ) const { return occupied.size( ); }
+    Entry *GetOccupiedSlot( ncounter_t idx ) const { return slots[occupied[idx]].head; }
+
+    /* Oldest entry of a slot that targets the given row, or NULL. */
+    Entry *GetRowHead( ncounter_t rank, ncounter_t bank, ncounter_t subarray, 
+                       ncounter_t row ) const;
+    Entry *GetRowHead( Entry *slotEntry, ncounter_t row ) const;
+
+  private:
+    struct RowList
+    {
+        Entry *head, *tail;
+    };
+
+    struct Slot
+    {
+        Entry *head, *tail;
+        ncounter_t occupiedPos;
+        std::map<ncounter_t, RowList> rows;
+    };
+
+    ncounter_t rankCount, bankCount, subArrayCount;
+    std::vector<Slot> slots;
+    std::vector<ncounter_t> occupied;
+
+    Entry *head, *tail;
+    ncounter_t size;
+    ncounters_t frontOrder, backOrder;
+
+    std::vector<Entry *> freeEntries;
+
+    Entry *CreateEntry( NVMainRequest *request, NVMTransactionQueue::iterator position,
+                        ncounter_t queueId );
+    Slot& GetSlot( Entry *entry );
+};
+
+};
+
+#endif
@@ -47,6 +47,7 @@ TranslationMethod::TranslationMethod( )
      * The method is for a 256 MB memory => 29 bits total.
      * The bits widths for each are 1 - 1 - 10 - 3 - 6 - 8 
      */
+    generation = 0;
     SetBitWidths( 10, 8, 3, 1, 1, 6 );
     SetOrder( 4, 1, 3, 5, 6, 2 );
 }
@@ -64,6 +65,7 @@ void TranslationMethod::SetBitWidths( unsigned int rowBits, unsigned int colBits
     bitWidths[MEM_RANK] = rankBits;
     bitWidths[MEM_CHANNEL] = channelBits;
     bitWidths[MEM_SUBARRAY] = subarrayBits;
+    generation++;
 }
 
 void TranslationMethod::SetOrder( int row, int col, int bank, int rank, int channel, int subarray )
@@ -83,6 +85,7 @@ void TranslationMethod::SetOrder( int row, int col, int bank, int rank, int chan
     order[MEM_RANK] = rank - 1;
     order[MEM_CHANNEL] = channel - 1;
     order[MEM_SUBARRAY] = subarray - 1;
+    generation++;
 }
 
 void TranslationMethod::SetCount( uint64_t rows, uint64_t cols, uint64_t banks, 
@@ -94,6 +97,7 @@ void TranslationMethod::SetCount( uint64_t rows, uint64_t cols, uint64_t banks,
     count[MEM_RANK] = ranks;
     count[MEM_CHANNEL] = channels;
     count[MEM_SUBARRAY] = subarrays;
+    generation++;
 }
 
 void TranslationMethod::GetBitWidths( unsigned int *rowBits, unsigned int *colBits, unsigned int *bankBits,
@@ -71,10 +71,14 @@ class TranslationMethod
     void GetCount( uint64_t *rows, uint64_t *cols, uint64_t *banks, 
                    uint64_t *ranks, uint64_t *channels, uint64_t *subarrays );
 
+    /* Changes whenever the widths, order or counts are set. */
+    uint64_t GetGeneration( ) { return generation; }
+
   private:
     unsigned int bitWidths[6];
     uint64_t count[6];
     int order[6];
+    uint64_t generation;
 };
 
 };
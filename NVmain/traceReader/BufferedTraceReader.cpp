@@ -0,0 +1,196 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#include "traceReader/BufferedTraceReader.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace NVM;
+
+BufferedTraceReader::BufferedTraceReader( GenericTraceReader *r, ncounter_t entries )
+    : reader(r), lines(entries), valid(entries, 0)
+{
+    assert( entries > 0 );
+
+    readIndex = writeIndex = 0;
+    batchSize = std::max( entries / 8, static_cast<ncounter_t>(1) );
+    stopping = false;
+
+    consumeIndex = consumeEnd = 0;
+    finished = false;
+}
+
+BufferedTraceReader::~BufferedTraceReader( )
+{
+    {
+        std::lock_guard<std::mutex> guard( ringLock );
+        stopping = true;
+    }
+    ringNotFull.notify_one( );
+
+    if( producer.joinable( ) )
+        producer.join( );
+
+    delete reader;
+}
+
+void BufferedTraceReader::SetTraceFile( std::string file )
+{
+    assert( !producer.joinable( ) );
+
+    reader->SetTraceFile( file );
+}
+
+std::string BufferedTraceReader::GetTraceFile( )
+{
+    return reader->GetTraceFile( );
+}
+
+void BufferedTraceReader::Produce( )
+{
+    ncounter_t capacity = lines.size( );
+    ncounter_t produced = 0, freeEnd = 0;
+
+    while( true )
+    {
+        /* Wait for free slots and publish what was parsed so far. */
+        if( produced == freeEnd )
+        {
+            std::unique_lock<std::mutex> lock( ringLock );
+
+            bool wasEmpty = (readIndex == writeIndex);
+            writeIndex = produced;
+            if( wasEmpty && readIndex != writeIndex )
+                ringNotEmpty.notify_one( );
+
+            ringNotFull.wait( lock, [&]{ return stopping || writeIndex - readIndex < capacity; } );
+
+            if( stopping )
+                return;
+
+            freeEnd = readIndex + capacity;
+        }
+
+        ncounter_t slot = produced % capacity;
+        bool lineValid = reader->GetNextAccess( &lines[slot] );
+
+        valid[slot] = lineValid;
+        produced++;
+
+        if( !lineValid )
+            break;
+
+        /* Publish regularly so the consumer does not wait for a full ring. */
+        if( (produced & 63) == 0 )
+        {
+            std::lock_guard<std::mutex> guard( ringLock );
+
+            bool wasEmpty = (readIndex == writeIndex);
+            writeIndex = produced;
+            if( wasEmpty )
+                ringNotEmpty.notify_one( );
+        }
+    }
+
+    std::lock_guard<std::mutex> guard( ringLock );
+    writeIndex = produced;
+    ringNotEmpty.notify_one( );
+}
+
+bool BufferedTraceReader::GetNextAccess( TraceLine *nextAccess )
+{
+    if( !producer.joinable( ) )
+        producer = std::thread( &BufferedTraceReader::Produce, this );
+
+    if( consumeIndex == consumeEnd )
+    {
+        /* Reader already returned its last line. */
+        if( finished )
+        {
+            NVMDataBlock dataBlock;
+            NVMAddress nAddress;
+
+            nAddress.SetPhysicalAddress( 0xDEADC0DEDEADBEEFULL );
+            nextAccess->SetLine( nAddress, NOP, 0, dataBlock, dataBlock, 0 );
+            return false;
+        }
+
+        /* Free the batch we just consumed and take everything available. */
+        std::unique_lock<std::mutex> lock( ringLock );
+
+        bool wasFull = (writeIndex - readIndex == lines.size( ));
+        readIndex = consumeIndex;
+        if( wasFull )
+            ringNotFull.notify_one( );
+
+        ringNotEmpty.wait( lock, [&]{ return readIndex != writeIndex; } );
+
+        /* Take at most an eighth of the ring so the producer can keep going. */
+        consumeEnd = std::min( writeIndex, readIndex + batchSize );
+    }
+
+    TraceLine& line = lines[consumeIndex % lines.size( )];
+    bool lineValid = valid[consumeIndex % lines.size( )];
+
+    nextAccess->SetLine( line.GetAddress( ), line.GetOperation( ), line.GetCycle( ),
+                         line.GetData( ), line.GetOldData( ), line.GetThreadId( ) );
+
+    consumeIndex++;
+
+    if( !lineValid )
+        finished = true;
+
+    return lineValid;
+}
+
+int BufferedTraceReader::GetNextNAccesses( unsigned int N, 
+                                   std::vector<TraceLine *> *nextAccesses )
+{
+    int successes = 0;
+
+    for( unsigned int i = 0; i < N; i++ )
+    {
+        TraceLine *nextLine = new TraceLine( );
+
+        if( !GetNextAccess( nextLine ) )
+        {
+            delete nextLine;
+            break;
+        }
+
+        nextAccesses->push_back( nextLine );
+        successes++;
+    }
+
+    return successes;
+}
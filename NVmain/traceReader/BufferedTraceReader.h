@@ -0,0 +1,89 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#ifndef __BUFFEREDTRACEREADER_H__
+#define __BUFFEREDTRACEREADER_H__
+
+#include "traceReader/GenericTraceReader.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NVM {
+
+/*
+ *  Runs another trace reader on a producer thread which fills a bounded ring
+ *  of parsed trace lines. GetNextAccess only copies the next line out of the
+ *  ring, so reading and decompressing the trace overlaps with simulation.
+ *  Lines are handed over in batches to keep locking off the common path.
+ *  The wrapped reader is owned and deleted by this reader.
+ */
+class BufferedTraceReader : public GenericTraceReader
+{
+  public:
+    BufferedTraceReader( GenericTraceReader *reader, ncounter_t entries );
+    ~BufferedTraceReader( );
+    
+    void SetTraceFile( std::string file );
+    std::string GetTraceFile( );
+    
+    bool GetNextAccess( TraceLine *nextAccess );
+    int  GetNextNAccesses( unsigned int N, std::vector<TraceLine *> *nextAccess );
+  
+  private:
+    GenericTraceReader *reader;
+    std::thread producer;
+
+    /* Ring of parsed lines. valid is false for the final (EOF) line. */
+    std::vector<TraceLine> lines;
+    std::vector<uint8_t> valid;
+    ncounter_t batchSize;
+
+    /* Protected by ringLock. */
+    std::mutex ringLock;
+    std::condition_variable ringNotEmpty;
+    std::condition_variable ringNotFull;
+    ncounter_t readIndex, writeIndex;
+    bool stopping;
+
+    /* Consumer side only: lines taken from the ring but not returned yet. */
+    ncounter_t consumeIndex, consumeEnd;
+    bool finished;
+
+    void Produce( );
+};
+
+};
+
+#endif
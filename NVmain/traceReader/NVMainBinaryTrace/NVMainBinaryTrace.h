@@ -0,0 +1,92 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#ifndef __NVMAINBINARYTRACE_H__
+#define __NVMAINBINARYTRACE_H__
+
+#include <stdint.h>
+
+/*
+ *  Binary version of the NVMain trace format. The file starts with a fixed
+ *  16-byte header (all fields little-endian):
+ *
+ *    char     magic[4]    "NVMB"
+ *    uint16_t version     NVMB_VERSION
+ *    uint16_t flags       NVMB_HAS_DATA, NVMB_HAS_OLD_DATA
+ *    uint32_t lineSize    Size of the data payloads in bytes
+ *    uint32_t reserved    Zero
+ *
+ *  followed by one record per access:
+ *
+ *    uint8_t  tag         NVMB_OP_WRITE and which optional fields follow
+ *    varint   cycle       Zig-zag encoded delta from the previous cycle
+ *    varint   address     Zig-zag encoded delta from the previous address
+ *    varint   threadId    Only if NVMB_THREAD is set, otherwise unchanged
+ *    uint8_t  data[]      lineSize bytes, only if NVMB_DATA is set
+ *    uint8_t  oldData[]   lineSize bytes, only if NVMB_OLD_DATA is set
+ *
+ *  Varints are LEB128 (7 bits per byte, least significant group first). If
+ *  the header says the trace has (old) data, records without the payload
+ *  carry an all-zero line. The first record is relative to cycle 0,
+ *  address 0 and thread 0.
+ */
+
+namespace NVM {
+
+const char NVMB_MAGIC[4] = { 'N', 'V', 'M', 'B' };
+const uint16_t NVMB_VERSION = 1;
+const uint32_t NVMB_HEADER_SIZE = 16;
+
+/* Header flags. */
+const uint16_t NVMB_HAS_DATA = 0x1;
+const uint16_t NVMB_HAS_OLD_DATA = 0x2;
+
+/* Record tag bits. */
+const uint8_t NVMB_OP_WRITE = 0x1;
+const uint8_t NVMB_DATA = 0x2;
+const uint8_t NVMB_OLD_DATA = 0x4;
+const uint8_t NVMB_THREAD = 0x8;
+
+inline uint64_t NVMBZigZagEncode( int64_t value )
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t NVMBZigZagDecode( uint64_t value )
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+};
+
+#endif
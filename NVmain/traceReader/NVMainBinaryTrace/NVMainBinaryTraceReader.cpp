@@ -0,0 +1,304 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#include "traceReader/NVMainBinaryTrace/NVMainBinaryTraceReader.h"
+#include "traceReader/NVMainBinaryTrace/NVMainBinaryTrace.h"
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace NVM;
+
+namespace {
+
+/* Amount of the trace the kernel is asked to read in ahead of time. */
+const uint64_t readAheadWindow = 8 * 1024 * 1024;
+
+uint64_t ReadLittleEndian( const uint8_t *data, unsigned int bytes )
+{
+    uint64_t value = 0;
+
+    for( unsigned int i = 0; i < bytes; i++ )
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+
+    return value;
+}
+
+}
+
+NVMainBinaryTraceReader::NVMainBinaryTraceReader( )
+{
+    traceFile = "";
+    traceFd = -1;
+    traceData = NULL;
+    traceSize = 0;
+    position = 0;
+    readAheadEnd = 0;
+
+    flags = 0;
+    lineSize = 0;
+
+    lastCycle = 0;
+    lastAddress = 0;
+    lastThreadId = 0;
+}
+
+NVMainBinaryTraceReader::~NVMainBinaryTraceReader( )
+{
+    CloseTrace( );
+}
+
+void NVMainBinaryTraceReader::SetTraceFile( std::string file )
+{
+    traceFile = file;
+}
+
+std::string NVMainBinaryTraceReader::GetTraceFile( )
+{
+    return traceFile;
+}
+
+bool NVMainBinaryTraceReader::OpenTrace( )
+{
+    struct stat traceStat;
+
+    traceFd = open( traceFile.c_str( ), O_RDONLY );
+    if( traceFd < 0 || fstat( traceFd, &traceStat ) != 0 )
+    {
+        std::cerr << "Could not open trace file: " << traceFile << "!" << std::endl;
+        CloseTrace( );
+        return false;
+    }
+
+    traceSize = static_cast<uint64_t>(traceStat.st_size);
+
+    if( traceSize < NVMB_HEADER_SIZE )
+    {
+        std::cerr << "NVMainBinaryTraceReader: " << traceFile 
+            << " is too short to be a binary trace!" << std::endl;
+        CloseTrace( );
+        return false;
+    }
+
+    void *mapping = mmap( NULL, traceSize, PROT_READ, MAP_PRIVATE, traceFd, 0 );
+    if( mapping == MAP_FAILED )
+    {
+        std::cerr << "NVMainBinaryTraceReader: Could not map " << traceFile 
+            << "!" << std::endl;
+        CloseTrace( );
+        return false;
+    }
+
+    traceData = static_cast<const uint8_t *>(mapping);
+    madvise( mapping, traceSize, MADV_SEQUENTIAL );
+
+    if( memcmp( traceData, NVMB_MAGIC, sizeof(NVMB_MAGIC) ) != 0 
+        || ReadLittleEndian( traceData + 4, 2 ) != NVMB_VERSION )
+    {
+        std::cerr << "NVMainBinaryTraceReader: " << traceFile 
+            << " is not a version " << NVMB_VERSION << " binary trace!" << std::endl;
+        CloseTrace( );
+        return false;
+    }
+
+    flags = static_cast<uint16_t>(ReadLittleEndian( traceData + 6, 2 ));
+    lineSize = static_cast<uint32_t>(ReadLittleEndian( traceData + 8, 4 ));
+
+    position = NVMB_HEADER_SIZE;
+    readAheadEnd = 0;
+    ReadAhead( );
+
+    return true;
+}
+
+void NVMainBinaryTraceReader::CloseTrace( )
+{
+    if( traceData != NULL )
+        munmap( const_cast<uint8_t *>(traceData), traceSize );
+
+    if( traceFd >= 0 )
+        close( traceFd );
+
+    traceData = NULL;
+    traceFd = -1;
+}
+
+/* Keep at least half a window of the trace in flight in front of us. */
+void NVMainBinaryTraceReader::ReadAhead( )
+{
+    if( position + readAheadWindow / 2 < readAheadEnd || readAheadEnd >= traceSize )
+        return;
+
+    uint64_t pageSize = static_cast<uint64_t>(sysconf( _SC_PAGESIZE ));
+    uint64_t start = (position / pageSize) * pageSize;
+    uint64_t length = std::min( readAheadWindow, traceSize - start );
+
+    madvise( const_cast<uint8_t *>(traceData + start), length, MADV_WILLNEED );
+
+    readAheadEnd = start + length;
+}
+
+bool NVMainBinaryTraceReader::ReadVarint( uint64_t *value )
+{
+    uint64_t result = 0;
+    unsigned int shift = 0;
+
+    while( position < traceSize && shift < 64 )
+    {
+        uint8_t byte = traceData[position++];
+
+        result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
+
+        if( (byte & 0x80) == 0 )
+        {
+            *value = result;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool NVMainBinaryTraceReader::ReadPayload( NVMDataBlock& block, bool present, 
+                                           bool tracked )
+{
+    if( !tracked )
+        return true;
+
+    block.SetSize( lineSize );
+
+    if( !present )
+    {
+        memset( block.rawData, 0, lineSize );
+        return true;
+    }
+
+    if( position + lineSize > traceSize )
+        return false;
+
+    memcpy( block.rawData, traceData + position, lineSize );
+    position += lineSize;
+
+    return true;
+}
+
+bool NVMainBinaryTraceReader::GetNextAccess( TraceLine *nextAccess )
+{
+    /* If there is no trace file, we can't do anything. */
+    if( traceFile == "" )
+    {
+        std::cerr << "No trace file specified!" << std::endl;
+        return false;
+    }
+
+    if( traceData == NULL && !OpenTrace( ) )
+        return false;
+
+    ReadAhead( );
+
+    NVMDataBlock dataBlock;
+    NVMDataBlock oldDataBlock;
+    uint64_t cycleDelta, addressDelta, threadId = lastThreadId;
+    uint8_t tag = 0;
+
+    bool valid = (position < traceSize);
+
+    if( valid )
+    {
+        tag = traceData[position++];
+
+        valid = ReadVarint( &cycleDelta ) && ReadVarint( &addressDelta );
+
+        if( valid && (tag & NVMB_THREAD) )
+            valid = ReadVarint( &threadId );
+
+        valid = valid 
+             && ReadPayload( dataBlock, (tag & NVMB_DATA), (flags & NVMB_HAS_DATA) )
+             && ReadPayload( oldDataBlock, (tag & NVMB_OLD_DATA), 
+                             (flags & NVMB_HAS_OLD_DATA) );
+    }
+
+    /* There are no more records in the trace... Send back a "dummy" line */
+    if( !valid )
+    {
+        if( position < traceSize )
+            std::cerr << "NVMainBinaryTraceReader: Truncated record at offset " 
+                << position << "!" << std::endl;
+
+        NVMAddress nAddress;
+        nAddress.SetPhysicalAddress( 0xDEADC0DEDEADBEEFULL );
+        nextAccess->SetLine( nAddress, NOP, 0, dataBlock, oldDataBlock, 0 );
+        std::cout << "NVMainBinaryTraceReader: Reached EOF!" << std::endl;
+        return false;
+    }
+
+    lastCycle += NVMBZigZagDecode( cycleDelta );
+    lastAddress += NVMBZigZagDecode( addressDelta );
+    lastThreadId = threadId;
+
+    NVMAddress nAddress;
+    nAddress.SetPhysicalAddress( lastAddress );
+
+    nextAccess->SetLine( nAddress, (tag & NVMB_OP_WRITE) ? WRITE : READ, lastCycle, 
+                         dataBlock, oldDataBlock, 
+                         static_cast<ncounters_t>(lastThreadId) );
+
+    return true;
+}
+
+int NVMainBinaryTraceReader::GetNextNAccesses( unsigned int N, 
+                                   std::vector<TraceLine *> *nextAccesses )
+{
+    int successes = 0;
+
+    for( unsigned int i = 0; i < N; i++ )
+    {
+        TraceLine *nextLine = new TraceLine( );
+
+        if( !GetNextAccess( nextLine ) )
+        {
+            delete nextLine;
+            break;
+        }
+
+        nextAccesses->push_back( nextLine );
+        successes++;
+    }
+
+    return successes;
+}
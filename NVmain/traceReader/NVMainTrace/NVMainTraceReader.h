@@ -35,6 +35,7 @@
 #define __NVMAINTRACEREADER_H__
 
 #include "traceReader/GenericTraceReader.h"
+#include "traceReader/TraceFile.h"
 #include <string>
 #include <iostream>
 #include <fstream>
@@ -55,7 +56,7 @@ class NVMainTraceReader : public GenericTraceReader
   
   private:
     std::string traceFile;
-    std::ifstream trace;
+    TraceFile trace;
     unsigned int traceVersion;
     bool readVersion;
 };
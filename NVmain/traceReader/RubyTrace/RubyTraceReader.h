@@ -37,6 +37,7 @@
 #include <iostream>
 #include <fstream>
 #include "traceReader/GenericTraceReader.h"
+#include "traceReader/TraceFile.h"
 
 namespace NVM {
 
@@ -58,7 +59,7 @@ class RubyTraceReader : public GenericTraceReader
 
   private:
     std::string traceFile;
-    std::ifstream trace;
+    TraceFile trace;
 };
 
 };
@@ -0,0 +1,203 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#include "traceReader/TraceFile.h"
+#include <iostream>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <csignal>
+
+using namespace NVM;
+
+namespace {
+
+const size_t traceBufferSize = 1024 * 1024;
+
+struct CompressionFormat
+{
+    const char *decoder;
+    unsigned char magic[6];
+    size_t magicLength;
+};
+
+const CompressionFormat compressionFormats[] = 
+{
+    { "gzip", { 0x1F, 0x8B }, 2 },
+    { "zstd", { 0x28, 0xB5, 0x2F, 0xFD }, 4 },
+    { "xz",   { 0xFD, '7', 'z', 'X', 'Z', 0x00 }, 6 }
+};
+
+}
+
+TraceFile::FileBuffer::FileBuffer( ) : file(NULL), buffer(traceBufferSize)
+{
+    setg( &buffer[0], &buffer[0], &buffer[0] );
+}
+
+void TraceFile::FileBuffer::SetFile( FILE *f )
+{
+    file = f;
+    setg( &buffer[0], &buffer[0], &buffer[0] );
+}
+
+TraceFile::FileBuffer::int_type TraceFile::FileBuffer::underflow( )
+{
+    if( gptr( ) < egptr( ) )
+        return traits_type::to_int_type( *gptr( ) );
+
+    if( file == NULL )
+        return traits_type::eof( );
+
+    size_t count = fread( &buffer[0], 1, buffer.size( ), file );
+
+    if( count == 0 )
+        return traits_type::eof( );
+
+    setg( &buffer[0], &buffer[0], &buffer[0] + count );
+
+    return traits_type::to_int_type( *gptr( ) );
+}
+
+TraceFile::TraceFile( ) : std::istream(NULL)
+{
+    file = NULL;
+    decoder = -1;
+
+    rdbuf( &fileBuffer );
+}
+
+TraceFile::~TraceFile( )
+{
+    close( );
+}
+
+const char *TraceFile::FindDecoder( const char *fileName )
+{
+    unsigned char header[6];
+    FILE *f = fopen( fileName, "rb" );
+
+    if( f == NULL )
+        return NULL;
+
+    size_t headerLength = fread( header, 1, sizeof(header), f );
+    fclose( f );
+
+    for( size_t i = 0; i < sizeof(compressionFormats) / sizeof(compressionFormats[0]); i++ )
+    {
+        const CompressionFormat& format = compressionFormats[i];
+
+        if( headerLength >= format.magicLength 
+            && memcmp( header, format.magic, format.magicLength ) == 0 )
+            return format.decoder;
+    }
+
+    return NULL;
+}
+
+FILE *TraceFile::StartDecoder( const char *decoderName, const char *fileName )
+{
+    int pipeFds[2];
+
+    if( pipe( pipeFds ) != 0 )
+        return NULL;
+
+    decoder = fork( );
+
+    if( decoder == 0 )
+    {
+        /* Child: decompress the trace to the pipe. */
+        dup2( pipeFds[1], STDOUT_FILENO );
+        ::close( pipeFds[0] );
+        ::close( pipeFds[1] );
+
+        execlp( decoderName, decoderName, "-dc", fileName, (char *)NULL );
+
+        std::cerr << "Could not run `" << decoderName << "' to decompress trace file " 
+            << fileName << "!" << std::endl;
+        _exit( 127 );
+    }
+
+    ::close( pipeFds[1] );
+
+    if( decoder < 0 )
+    {
+        ::close( pipeFds[0] );
+        return NULL;
+    }
+
+    return fdopen( pipeFds[0], "r" );
+}
+
+void TraceFile::open( const char *fileName )
+{
+    close( );
+
+    const char *decoderName = FindDecoder( fileName );
+
+    if( decoderName != NULL )
+    {
+        std::cout << "Decompressing trace file " << fileName << " with " 
+            << decoderName << "." << std::endl;
+        file = StartDecoder( decoderName, fileName );
+    }
+    else
+    {
+        file = fopen( fileName, "r" );
+    }
+
+    fileBuffer.SetFile( file );
+    clear( (file == NULL) ? std::ios::failbit : std::ios::goodbit );
+}
+
+bool TraceFile::is_open( ) const
+{
+    return (file != NULL);
+}
+
+void TraceFile::close( )
+{
+    if( file != NULL )
+        fclose( file );
+
+    if( decoder > 0 )
+    {
+        /* Stop the decoder if the trace was not read to the end. */
+        kill( decoder, SIGTERM );
+        waitpid( decoder, NULL, 0 );
+    }
+
+    file = NULL;
+    decoder = -1;
+    fileBuffer.SetFile( NULL );
+}
@@ -0,0 +1,90 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#ifndef __TRACEFILE_H__
+#define __TRACEFILE_H__
+
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <sys/types.h>
+
+namespace NVM {
+
+/*
+ *  Input stream for text trace files. Traces compressed with gzip, zstd or
+ *  xz are recognized by their magic number and streamed through the
+ *  matching decompressor (gzip, zstd or xz in the PATH), which runs as a
+ *  separate process writing into a pipe. Uncompressed traces are read
+ *  directly. This lets the trace readers use compressed traces without
+ *  expanding them to disk first.
+ */
+class TraceFile : public std::istream
+{
+  public:
+    TraceFile( );
+    ~TraceFile( );
+
+    void open( const char *file );
+    bool is_open( ) const;
+    void close( );
+
+  private:
+    class FileBuffer : public std::streambuf
+    {
+      public:
+        FileBuffer( );
+
+        void SetFile( FILE *f );
+
+      protected:
+        int_type underflow( );
+
+      private:
+        FILE *file;
+        std::vector<char> buffer;
+    };
+
+    FileBuffer fileBuffer;
+    FILE *file;
+    pid_t decoder;
+
+    const char *FindDecoder( const char *file );
+    FILE *StartDecoder( const char *decoderName, const char *file );
+};
+
+};
+
+#endif
@@ -36,6 +36,7 @@
 
 /* Add your trace reader's include below. */
 #include "traceReader/NVMainTrace/NVMainTraceReader.h"
+#include "traceReader/NVMainBinaryTrace/NVMainBinaryTraceReader.h"
 #include "traceReader/RubyTrace/RubyTraceReader.h"
 
 using namespace NVM;
@@ -50,6 +51,8 @@ GenericTraceReader *TraceReaderFactory::CreateNewTraceReader( std::string reader
 
     if( reader == "NVMainTrace" )
         tracer = new NVMainTraceReader( );
+    else if( reader == "NVMainBinaryTrace" )
+        tracer = new NVMainBinaryTraceReader( );
     else if( reader == "RubyTrace" )
         tracer = new RubyTraceReader( );
 
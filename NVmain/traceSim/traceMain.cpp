@@ -35,12 +35,15 @@
 #include <cmath>
 #include <stdlib.h>
 #include <fstream>
+#include <utility>
+#include <limits>
 
 #include "src/Interconnect.h"
 #include "Interconnect/InterconnectFactory.h"
 #include "src/Config.h"
 #include "src/TranslationMethod.h"
 #include "traceReader/TraceReaderFactory.h"
+#include "traceReader/BufferedTraceReader.h"
 #include "src/AddressTranslator.h"
 #include "Decoders/DecoderFactory.h"
 #include "src/MemoryController.h"
@@ -50,6 +53,7 @@
 #include "include/NVMHelpers.h"
 #include "Utils/HookFactory.h"
 #include "src/EventQueue.h"
+#include "src/EventQueueFactory.h"
 #include "NVM/nvmain.h"
 #include "traceSim/traceMain.h"
 
@@ -64,7 +68,7 @@ int main( int argc, char *argv[] )
 
 TraceMain::TraceMain( )
 {
-
+    outstandingRequests = 0;
 }
 
 TraceMain::~TraceMain( )
@@ -80,7 +84,7 @@ int TraceMain::RunTrace( int argc, char *argv[] )
     TraceLine *tl = new TraceLine( );
     SimInterface *simInterface = new NullInterface( );
     NVMain *nvmain = new NVMain( );
-    EventQueue *mainEventQueue = new EventQueue( );
+    EventQueue *mainEventQueue = NULL;
     GlobalEventQueue *globalEventQueue = new GlobalEventQueue( );
     TagGenerator *tagGenerator = new TagGenerator( 1000 );
     bool IgnoreData = false;
@@ -105,7 +109,6 @@ int TraceMain::RunTrace( int argc, char *argv[] )
 
     config->Read( argv[1] );
     config->SetSimInterface( simInterface );
-    SetEventQueue( mainEventQueue );
     SetGlobalEventQueue( globalEventQueue );
     SetStats( stats );
     SetTagGenerator( tagGenerator );
@@ -128,17 +131,58 @@ int TraceMain::RunTrace( int argc, char *argv[] )
         }
     }
 
+    /* The event queue backend may be overridden from the command line. */
+    mainEventQueue = EventQueueFactory::CreateEventQueue( config );
+    SetEventQueue( mainEventQueue );
+
     if( config->KeyExists( "StatsFile" ) )
     {
         statStream.open( config->GetString( "StatsFile" ).c_str(), 
                          std::ofstream::out | std::ofstream::app );
     }
 
+    if( config->KeyExists( "StatsFormat" ) 
+        && !stats->SetFormat( config->GetString( "StatsFormat" ) ) )
+    {
+        std::cout << "Warning: Unknown StatsFormat `" << config->GetString( "StatsFormat" )
+            << "', printing stats as text." << std::endl;
+    }
+
+    /* Stats may also be dumped every StatsInterval cycles while the trace runs. */
+    ncycle_t statsInterval = 0;
+
+    if( config->KeyExists( "StatsInterval" ) )
+        statsInterval = static_cast<ncycle_t>(config->GetValue( "StatsInterval" ));
+
+    ncycle_t nextStatsDump = statsInterval;
+
     if( config->KeyExists( "IgnoreData" ) && config->GetString( "IgnoreData" ) == "true" )
     {
         IgnoreData = true;
     }
 
+    /* IgnoreTraceCycle issues every trace line at cycle 0. */
+    bool ignoreTraceCycle = config->KeyExists( "IgnoreTraceCycle" ) 
+                            && config->GetString( "IgnoreTraceCycle" ) == "true";
+
+    /* The config is sealed once NVMain is configured, so read the rest here. */
+    std::string traceReader = "NVMainTrace";
+
+    if( config->KeyExists( "TraceReader" ) )
+        traceReader = config->GetString( "TraceReader" );
+
+    /* 
+     *  Parse the trace on a separate thread unless TraceBufferSize is 0. The
+     *  buffered reader hands out the same lines in the same order.
+     */
+    ncounter_t traceBufferSize = 4096;
+
+    if( config->KeyExists( "TraceBufferSize" ) )
+        traceBufferSize = static_cast<ncounter_t>(config->GetValue( "TraceBufferSize" ));
+
+    double cpuToMemoryClock = (double)(config->GetValue( "CPUFreq" )) 
+                            / (double)(config->GetValue( "CLK" ));
+
     /*  Add any specified hooks */
     std::vector<std::string>& hookList = config->GetHooks( );
 
@@ -173,11 +217,10 @@ int TraceMain::RunTrace( int argc, char *argv[] )
     std::cout << "traceMain (" << (void*)(this) << ")" << std::endl;
     nvmain->PrintHierarchy( );
 
-    if( config->KeyExists( "TraceReader" ) )
-        trace = TraceReaderFactory::CreateNewTraceReader( 
-                config->GetString( "TraceReader" ) );
-    else
-        trace = TraceReaderFactory::CreateNewTraceReader( "NVMainTrace" );
+    trace = TraceReaderFactory::CreateNewTraceReader( traceReader );
+
+    if( trace != NULL && traceBufferSize > 0 )
+        trace = new BufferedTraceReader( trace, traceBufferSize );
 
     trace->SetTraceFile( argv[2] );
 
@@ -192,14 +235,21 @@ int TraceMain::RunTrace( int argc, char *argv[] )
      *  The trace cycle is assumed to be the rate that the CPU/LLC is issuing. 
      *  Scale the simulation cycles to be the number of *memory cycles* to run.
      */
-    simulateCycles = (uint64_t)ceil( ((double)(config->GetValue( "CPUFreq" )) 
-                    / (double)(config->GetValue( "CLK" ))) * simulateCycles ); 
+    simulateCycles = (uint64_t)ceil( cpuToMemoryClock * simulateCycles ); 
 
     std::cout << simulateCycles << " memory cycles) ***" << std::endl;
 
     currentCycle = 0;
     while( currentCycle <= simulateCycles || simulateCycles == 0 )
     {
+        if( statsInterval != 0 && currentCycle >= nextStatsDump )
+        {
+            GetChild( )->CalculateStats( );
+            stats->PrintAll( (statStream.is_open()) ? statStream : std::cout );
+
+            nextStatsDump = (currentCycle / statsInterval + 1) * statsInterval;
+        }
+
         if( !trace->GetNextAccess( tl ) )
         {
             /* Force all modules to drain requests. */
@@ -211,11 +261,14 @@ int TraceMain::RunTrace( int argc, char *argv[] )
             /* Wait for requests to drain. */
             while( outstandingRequests > 0 )
             {
-                globalEventQueue->Cycle( 1 );
-              
-                currentCycle++;
-
-                /* Retry drain each cycle if it failed. */
+                /* 
+                 *  Requests only complete on events, so skip idle cycles
+                 *  rather than stepping through them one at a time.
+                 */
+                currentCycle += globalEventQueue->FastForward( 
+                                    std::numeric_limits<ncycle_t>::max( ) );
+
+                /* Retry drain after each step if it failed. */
                 if( !draining )
                     draining = Drain( );
             }
@@ -229,17 +282,13 @@ int TraceMain::RunTrace( int argc, char *argv[] )
         request->type = tl->GetOperation( );
         request->bulkCmd = CMD_NOP;
         request->threadId = tl->GetThreadId( );
-        if( !IgnoreData ) request->data = tl->GetData( );
-        if( !IgnoreData ) request->oldData = tl->GetOldData( );
+        if( !IgnoreData ) request->data = std::move( tl->GetData( ) );
+        if( !IgnoreData ) request->oldData = std::move( tl->GetOldData( ) );
         request->status = MEM_REQUEST_INCOMPLETE;
         request->owner = (NVMObject *)this;
         
-        /* 
-         * If you want to ignore the cycles used in the trace file, just set
-         * the cycle to 0. 
-         */
-        if( config->KeyExists( "IgnoreTraceCycle" ) 
-                && config->GetString( "IgnoreTraceCycle" ) == "true" )
+        /* Ignoring the cycles used in the trace file sets them to 0. */
+        if( ignoreTraceCycle )
             tl->SetLine( tl->GetAddress( ), tl->GetOperation( ), 0, 
                          tl->GetData( ), tl->GetOldData( ), tl->GetThreadId( ) );
 
@@ -284,7 +333,15 @@ int TraceMain::RunTrace( int argc, char *argv[] )
                 if( currentCycle >= simulateCycles && simulateCycles != 0 )
                     break;
 
-                globalEventQueue->Cycle( 1 );
+                /* 
+                 *  The controller can only free queue space when an event
+                 *  fires, so jump to the next event instead of polling.
+                 */
+                if( simulateCycles != 0 )
+                    globalEventQueue->FastForward( simulateCycles - currentCycle );
+                else
+                    globalEventQueue->FastForward( 
+                        std::numeric_limits<ncycle_t>::max( ) );
                 currentCycle = globalEventQueue->GetCurrentCycle( );
             }
 
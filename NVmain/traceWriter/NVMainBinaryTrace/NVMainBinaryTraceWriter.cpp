@@ -0,0 +1,204 @@
+/*******************************************************************************
+* Copyright (c) 2012-2014, The Microsystems Design Labratory (MDL)
+* Department of Computer Science and Engineering, The Pennsylvania State University
+* All rights reserved.
+* 
+* This source code is part of NVMain - A cycle accurate timing, bit accurate
+* energy simulator for both volatile (e.g., DRAM) and non-volatile memory
+* (e.g., PCRAM). The source code is free and you can redistribute and/or
+* modify it by providing that the following conditions are met:
+* 
+*  1) Redistributions of source code must retain the above copyright notice,
+*     this list of conditions and the following disclaimer.
+* 
+*  2) Redistributions in binary form must reproduce the above copyright notice,
+*     this list of conditions and the following disclaimer in the documentation
+*     and/or other materials provided with the distribution.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+* Author list: 
+*   Matt Poremba    ( Email: mrp5060 at psu dot edu 
+*                     Website: http://www.cse.psu.edu/~poremba/ )
+*******************************************************************************/
+
+#include "traceWriter/NVMainBinaryTrace/NVMainBinaryTraceWriter.h"
+#include "traceReader/NVMainBinaryTrace/NVMainBinaryTrace.h"
+#include <cstring>
+
+using namespace NVM;
+
+namespace {
+
+void WriteLittleEndian( uint8_t *buffer, uint64_t value, unsigned int bytes )
+{
+    for( unsigned int i = 0; i < bytes; i++ )
+        buffer[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+unsigned int WriteVarint( uint8_t *buffer, uint64_t value )
+{
+    unsigned int length = 0;
+
+    while( value >= 0x80 )
+    {
+        buffer[length++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+
+    buffer[length++] = static_cast<uint8_t>(value);
+
+    return length;
+}
+
+}
+
+NVMainBinaryTraceWriter::NVMainBinaryTraceWriter( )
+{
+    wroteHeader = false;
+    lineSize = 0;
+
+    lastCycle = 0;
+    lastAddress = 0;
+    lastThreadId = 0;
+}
+
+NVMainBinaryTraceWriter::~NVMainBinaryTraceWriter( )
+{
+    /* An empty trace still needs a valid header. */
+    if( trace.is_open( ) && !wroteHeader )
+        WriteHeader( 64, NVMB_HAS_DATA | NVMB_HAS_OLD_DATA );
+}
+
+void NVMainBinaryTraceWriter::SetTraceFile( std::string file )
+{
+    // Note: This function assumes an absolute path is given, otherwise
+    // the current directory is used. 
+
+    traceFile = file;
+
+    trace.open( traceFile.c_str( ), std::ofstream::out | std::ofstream::binary );
+
+    if( !trace.is_open( ) )
+    {
+        std::cout << "Warning: Could not open trace file " << file
+                  << ". Output will be suppressed." << std::endl;
+    }
+}
+
+std::string NVMainBinaryTraceWriter::GetTraceFile( )
+{
+    return traceFile;
+}
+
+void NVMainBinaryTraceWriter::WriteHeader( uint32_t size, uint16_t flags )
+{
+    uint8_t header[NVMB_HEADER_SIZE];
+
+    memcpy( header, NVMB_MAGIC, sizeof(NVMB_MAGIC) );
+    WriteLittleEndian( header + 4, NVMB_VERSION, 2 );
+    WriteLittleEndian( header + 6, flags, 2 );
+    WriteLittleEndian( header + 8, size, 4 );
+    WriteLittleEndian( header + 12, 0, 4 );
+
+    trace.write( reinterpret_cast<char *>(header), NVMB_HEADER_SIZE );
+
+    lineSize = size;
+    wroteHeader = true;
+}
+
+/* Data is only stored if it has the trace's line size and is not all zero. */
+bool NVMainBinaryTraceWriter::HasPayload( NVMDataBlock& block )
+{
+    if( block.rawData == NULL || block.GetSize( ) != lineSize )
+        return false;
+
+    for( uint32_t i = 0; i < lineSize; i++ )
+    {
+        if( block.rawData[i] != 0 )
+            return true;
+    }
+
+    return false;
+}
+
+bool NVMainBinaryTraceWriter::SetNextAccess( TraceLine *nextAccess )
+{
+    /* Only print reads or writes. */
+    if( !trace.is_open( ) 
+        || (nextAccess->GetOperation() != READ && nextAccess->GetOperation() != WRITE) )
+        return false;
+
+    NVMDataBlock& data = nextAccess->GetData( );
+    NVMDataBlock& oldData = nextAccess->GetOldData( );
+
+    /* Requests without data (e.g., IgnoreData) stay without data when read back. */
+    if( !wroteHeader )
+    {
+        uint16_t flags = 0;
+
+        if( data.GetSize( ) > 0 ) flags |= NVMB_HAS_DATA;
+        if( oldData.GetSize( ) > 0 ) flags |= NVMB_HAS_OLD_DATA;
+
+        WriteHeader( (data.GetSize( ) > 0) ? static_cast<uint32_t>(data.GetSize( )) : 64, 
+                     flags );
+    }
+
+    /* Tag, three varints of up to 10 bytes each. */
+    uint8_t record[31];
+    unsigned int length = 1;
+    uint8_t tag = 0;
+
+    uint64_t cycle = nextAccess->GetCycle( );
+    uint64_t address = nextAccess->GetAddress( ).GetPhysicalAddress( );
+    uint64_t threadId = static_cast<uint64_t>(nextAccess->GetThreadId( ));
+
+    if( nextAccess->GetOperation( ) == WRITE )
+        tag |= NVMB_OP_WRITE;
+
+    length += WriteVarint( record + length, 
+                           NVMBZigZagEncode( static_cast<int64_t>(cycle - lastCycle) ) );
+    length += WriteVarint( record + length, 
+                           NVMBZigZagEncode( static_cast<int64_t>(address - lastAddress) ) );
+
+    if( threadId != lastThreadId )
+    {
+        tag |= NVMB_THREAD;
+        length += WriteVarint( record + length, threadId );
+    }
+
+    bool hasData = HasPayload( data );
+    bool hasOldData = HasPayload( oldData );
+
+    if( hasData ) tag |= NVMB_DATA;
+    if( hasOldData ) tag |= NVMB_OLD_DATA;
+
+    record[0] = tag;
+
+    trace.write( reinterpret_cast<char *>(record), length );
+    if( hasData )
+        trace.write( reinterpret_cast<char *>(data.rawData), lineSize );
+    if( hasOldData )
+        trace.write( reinterpret_cast<char *>(oldData.rawData), lineSize );
+
+    /* 
+     *  The writer is not destroyed when the simulation exits, so flush each 
+     *  record like the text writer does with std::endl.
+     */
+    trace.flush( );
+
+    lastCycle = cycle;
+    lastAddress = address;
+    lastThreadId = threadId;
+
+    return trace.good( );
+}